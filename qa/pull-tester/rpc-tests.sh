@@ -27,6 +27,7 @@ testScripts=(
     'txn_doublespend.py'
     'txn_doublespend.py --mineblock'
     'getchaintips.py'
+    'compactblocks.py'
     'rawtransactions.py'
     'rest.py'
     'mempool_spendcoinbase.py'
@@ -0,0 +1,84 @@
+#!/usr/bin/env python2
+# Copyright (c) 2018 The Verus developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#
+# Test compact block relay between nodes that negotiate it, and full block
+# relay to a node that runs with -compactblocks=0.
+#
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_greater_than, \
+    start_nodes, connect_nodes_bi, sync_blocks, sync_mempools
+
+import time
+
+
+class CompactBlocksTest(BitcoinTestFramework):
+
+    def setup_nodes(self):
+        return start_nodes(3, self.options.tmpdir, [
+            ["-debug=cmpctblock"],
+            ["-debug=cmpctblock"],
+            ["-compactblocks=0"],
+        ])
+
+    def setup_network(self, split=False):
+        self.nodes = self.setup_nodes()
+        connect_nodes_bi(self.nodes, 0, 1)
+        connect_nodes_bi(self.nodes, 0, 2)
+        self.is_network_split = False
+        self.sync_all()
+
+    def peer_info(self, node, services_bit):
+        # The peer of node that advertises (or not) compact block support
+        return [p for p in self.nodes[node].getpeerinfo()
+                if (int(p['services'], 16) & (1 << 24)) == services_bit]
+
+    def wait_for_negotiation(self):
+        for _ in range(30):
+            if all(p['compactblocks'] for p in self.peer_info(1, 1 << 24)):
+                return
+            time.sleep(1)
+        raise AssertionError("sendcmpct was not exchanged")
+
+    def run_test(self):
+        self.wait_for_negotiation()
+
+        # node2 has compact blocks disabled, so nobody agrees to use them with it
+        for p in self.nodes[2].getpeerinfo():
+            assert_equal(p['compactblocks'], False)
+        for p in self.peer_info(0, 0):
+            assert_equal(p['compactblocks'], False)
+
+        # A block made of transactions every node has already seen is rebuilt
+        # from the mempool, without asking for any transaction
+        txids = [self.nodes[0].sendtoaddress(self.nodes[1].getnewaddress(), 1) for _ in range(3)]
+        sync_mempools(self.nodes)
+        blockhash = self.nodes[0].generate(1)[0]
+        sync_blocks(self.nodes)
+
+        for node in self.nodes:
+            assert_equal(node.getbestblockhash(), blockhash)
+            assert_equal(node.getrawmempool(), [])
+        assert_equal(set(txids) <= set(self.nodes[1].getblock(blockhash)['tx']), True)
+
+        peer = self.peer_info(1, 1 << 24)[0]
+        assert_greater_than(peer['cmpctblocks_received'], 0)
+        assert_greater_than(peer['cmpctblocks_reconstructed'], 0)
+        assert_equal(peer['cmpctblock_txs_requested'], 0)
+
+        # node2 got the same block the old way
+        for p in self.nodes[2].getpeerinfo():
+            assert_equal(p['cmpctblocks_received'], 0)
+
+        # Blocks keep flowing both ways
+        self.nodes[1].generate(2)
+        sync_blocks(self.nodes)
+        assert_equal(self.nodes[0].getbestblockhash(), self.nodes[1].getbestblockhash())
+        assert_equal(self.nodes[2].getbestblockhash(), self.nodes[1].getbestblockhash())
+
+
+if __name__ == '__main__':
+    CompactBlocksTest().main()
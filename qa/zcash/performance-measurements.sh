@@ -216,6 +216,10 @@ case "$1" in
             listunspent)
                 zcash_rpc zcbenchmark listunspent 10
                 ;;
+            blocktojson|blocktojsonstream)
+                zcashd_generate
+                zcash_rpc zcbenchmark "$2" 1000 "${@:3}"
+                ;;
             *)
                 zcashd_stop
                 echo "Bad arguments to time."
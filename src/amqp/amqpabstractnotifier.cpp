@@ -10,7 +10,7 @@ AMQPAbstractNotifier::~AMQPAbstractNotifier()
 {
 }
 
-bool AMQPAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/)
+bool AMQPAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/, const CSerializedBlockRef & /*rawBlock*/)
 {
     return true;
 }
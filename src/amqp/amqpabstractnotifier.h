@@ -6,6 +6,7 @@
 #define ZCASH_AMQP_AMQPABSTRACTNOTIFIER_H
 
 #include "amqpconfig.h"
+#include "validationinterface.h"
 
 class CBlockIndex;
 class AMQPAbstractNotifier;
@@ -32,7 +33,7 @@ public:
     virtual bool Initialize() = 0;
     virtual void Shutdown() = 0;
 
-    virtual bool NotifyBlock(const CBlockIndex *pindex);
+    virtual bool NotifyBlock(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock);
     virtual bool NotifyTransaction(const CTransaction &transaction);
 
 protected:
@@ -109,11 +109,11 @@ void AMQPNotificationInterface::Shutdown()
     }
 }
 
-void AMQPNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindex)
+void AMQPNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock)
 {
     for (std::list<AMQPAbstractNotifier*>::iterator i = notifiers.begin(); i != notifiers.end(); ) {
         AMQPAbstractNotifier *notifier = *i;
-        if (notifier->NotifyBlock(pindex)) {
+        if (notifier->NotifyBlock(pindex, rawBlock)) {
             i++;
         } else {
             notifier->Shutdown();
@@ -24,8 +24,9 @@ protected:
     void Shutdown();
 
     // CValidationInterface
+    using CValidationInterface::UpdatedBlockTip;
     void SyncTransaction(const CTransaction &tx, const CBlock *pblock);
-    void UpdatedBlockTip(const CBlockIndex *pindex);
+    void UpdatedBlockTip(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock);
 
 private:
     AMQPNotificationInterface();
@@ -128,7 +128,7 @@ bool AMQPAbstractPublishNotifier::SendMessage(const char *command, const void* d
     return true;
 }
 
-bool AMQPPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool AMQPPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint("amqp", "amqp: Publish hashblock %s\n", hash.GetHex());
@@ -148,11 +148,16 @@ bool AMQPPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &t
     return SendMessage(MSG_HASHTX, data, 32);
 }
 
-bool AMQPPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool AMQPPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock)
 {
     LogPrint("amqp", "amqp: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
 
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    if (rawBlock) {
+        return SendMessage(MSG_RAWBLOCK, &(*rawBlock->begin()), rawBlock->size());
+    }
+
+    // Only when the tip has moved on since, read it back
+    CPlainDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
     {
         LOCK(cs_main);
         CBlock block;
@@ -32,7 +32,7 @@ public:
 class AMQPPublishHashBlockNotifier : public AMQPAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex);
+    bool NotifyBlock(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock);
 };
 
 class AMQPPublishHashTransactionNotifier : public AMQPAbstractPublishNotifier
@@ -44,7 +44,7 @@ public:
 class AMQPPublishRawBlockNotifier : public AMQPAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex);
+    bool NotifyBlock(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock);
 };
 
 class AMQPPublishRawTransactionNotifier : public AMQPAbstractPublishNotifier
@@ -0,0 +1,100 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockcache.h"
+
+#include "primitives/block.h"
+#include "version.h"
+
+CRecentBlockCache::CRecentBlockCache(size_t nMaxBytesIn) :
+    nBytes(0), nMaxBytes(nMaxBytesIn), nHits(0), nMisses(0)
+{
+}
+
+CRecentBlockCache::Entry CRecentBlockCache::Get(const uint256& hash)
+{
+    LOCK(cs);
+    std::map<uint256, EntryList::iterator>::iterator mi = mapEntries.find(hash);
+    if (mi == mapEntries.end()) {
+        nMisses++;
+        return Entry();
+    }
+    nHits++;
+    lru.splice(lru.begin(), lru, mi->second);
+    return mi->second->second;
+}
+
+CRecentBlockCache::Entry CRecentBlockCache::Insert(const uint256& hash, const CBlock& block)
+{
+    // Serialize outside the lock, blocks can be large
+    std::shared_ptr<CPlainDataStream> ss = std::make_shared<CPlainDataStream>(SER_NETWORK, PROTOCOL_VERSION);
+    ss->reserve(::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION));
+    *ss << block;
+    Entry entry = ss;
+
+    LOCK(cs);
+    std::map<uint256, EntryList::iterator>::iterator mi = mapEntries.find(hash);
+    if (mi != mapEntries.end()) {
+        lru.splice(lru.begin(), lru, mi->second);
+        return mi->second->second;
+    }
+    if (entry->size() > nMaxBytes) {
+        // Don't flush the whole cache for a block that could never fit
+        return entry;
+    }
+    lru.push_front(std::make_pair(hash, entry));
+    mapEntries[hash] = lru.begin();
+    nBytes += entry->size();
+    Trim();
+    return entry;
+}
+
+void CRecentBlockCache::Trim()
+{
+    AssertLockHeld(cs);
+    while (nBytes > nMaxBytes && !lru.empty()) {
+        nBytes -= lru.back().second->size();
+        mapEntries.erase(lru.back().first);
+        lru.pop_back();
+    }
+}
+
+void CRecentBlockCache::SetMaxBytes(size_t nMaxBytesIn)
+{
+    LOCK(cs);
+    nMaxBytes = nMaxBytesIn;
+    Trim();
+}
+
+void CRecentBlockCache::Clear()
+{
+    LOCK(cs);
+    lru.clear();
+    mapEntries.clear();
+    nBytes = 0;
+}
+
+size_t CRecentBlockCache::Count() const
+{
+    LOCK(cs);
+    return lru.size();
+}
+
+size_t CRecentBlockCache::Bytes() const
+{
+    LOCK(cs);
+    return nBytes;
+}
+
+uint64_t CRecentBlockCache::Hits() const
+{
+    LOCK(cs);
+    return nHits;
+}
+
+uint64_t CRecentBlockCache::Misses() const
+{
+    LOCK(cs);
+    return nMisses;
+}
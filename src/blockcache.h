@@ -0,0 +1,68 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKCACHE_H
+#define BITCOIN_BLOCKCACHE_H
+
+#include "streams.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <stdint.h>
+
+class CBlock;
+
+/** Default for -blockservecache, in megabytes */
+static const unsigned int DEFAULT_BLOCK_SERVE_CACHE = 16;
+/** Blocks read from disk to answer getdata are cached if they are this close to the tip */
+static const int BLOCK_SERVE_CACHE_DEPTH = 10;
+
+/**
+ * Recently connected blocks, kept in serialized network form so that a
+ * "getdata" for one of them is answered without reading the block from disk
+ * and serializing it again. When a new block arrives, all peers ask for the
+ * same block at about the same time, so fan-out costs a single disk read.
+ *
+ * Entries are shared: a block evicted while it is still being pushed to a
+ * peer stays alive until that reference is dropped.
+ */
+class CRecentBlockCache
+{
+public:
+    typedef std::shared_ptr<const CPlainDataStream> Entry;
+
+    explicit CRecentBlockCache(size_t nMaxBytesIn);
+
+    /** Look up a block, marking it most recently used. Returns NULL on a miss. */
+    Entry Get(const uint256& hash);
+
+    /** Serialize a block into the cache, evicting the least recently used ones as needed. */
+    Entry Insert(const uint256& hash, const CBlock& block);
+
+    void SetMaxBytes(size_t nMaxBytesIn);
+    void Clear();
+
+    size_t Count() const;
+    size_t Bytes() const;
+    uint64_t Hits() const;
+    uint64_t Misses() const;
+
+private:
+    typedef std::list<std::pair<uint256, Entry> > EntryList;
+
+    mutable CCriticalSection cs;
+    EntryList lru; // most recently used first
+    std::map<uint256, EntryList::iterator> mapEntries;
+    size_t nBytes;
+    size_t nMaxBytes;
+    uint64_t nHits;
+    uint64_t nMisses;
+
+    void Trim();
+};
+
+#endif // BITCOIN_BLOCKCACHE_H
@@ -0,0 +1,219 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKENCODINGS_H
+#define BITCOIN_BLOCKENCODINGS_H
+
+#include "primitives/block.h"
+#include "serialize.h"
+#include "uint256.h"
+
+#include <algorithm>
+#include <ios>
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+class CTxMemPool;
+
+/** Default for -compactblocks */
+static const bool DEFAULT_COMPACT_BLOCKS = true;
+/** Blocks this close to the tip are served as compact blocks, older ones in full */
+static const int MAX_CMPCTBLOCK_DEPTH = 5;
+/** getblocktxn requests are only answered for blocks this close to the tip */
+static const int MAX_BLOCKTXN_DEPTH = 10;
+
+/**
+ * Compact block relay, after BIP 152.
+ *
+ * A block is announced as its header, the coinbase (and the stake transaction
+ * of a PoS block), and a 6 byte short id for each of the other transactions.
+ * The receiver fills the block in from its mempool and only asks for the
+ * transactions it is missing, so a block whose transactions have already been
+ * relayed crosses the network as a few kilobytes instead of in full.
+ */
+
+/** A "getblocktxn" request for the transactions at the given positions of a block */
+class BlockTransactionsRequest
+{
+public:
+    uint256 blockhash;
+    std::vector<uint16_t> indexes;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(blockhash);
+        uint64_t indexes_size = (uint64_t)indexes.size();
+        READWRITE(COMPACTSIZE(indexes_size));
+
+        // Indexes are sent differentially encoded, each one as the distance
+        // from the previous one minus one
+        if (ser_action.ForRead()) {
+            size_t i = 0;
+            while (indexes.size() < indexes_size) {
+                indexes.resize(std::min((uint64_t)(1000 + indexes.size()), indexes_size));
+                for (; i < indexes.size(); i++) {
+                    uint64_t index = 0;
+                    READWRITE(COMPACTSIZE(index));
+                    if (index > std::numeric_limits<uint16_t>::max())
+                        throw std::ios_base::failure("index overflowed 16 bits");
+                    indexes[i] = index;
+                }
+            }
+
+            uint16_t offset = 0;
+            for (size_t j = 0; j < indexes.size(); j++) {
+                if (uint64_t(indexes[j]) + uint64_t(offset) > std::numeric_limits<uint16_t>::max())
+                    throw std::ios_base::failure("indexes overflowed 16 bits");
+                indexes[j] = indexes[j] + offset;
+                offset = indexes[j] + 1;
+            }
+        } else {
+            for (size_t i = 0; i < indexes.size(); i++) {
+                uint64_t index = indexes[i] - (i == 0 ? 0 : (indexes[i - 1] + 1));
+                READWRITE(COMPACTSIZE(index));
+            }
+        }
+    }
+};
+
+/** The "blocktxn" answer to a BlockTransactionsRequest */
+class BlockTransactions
+{
+public:
+    uint256 blockhash;
+    std::vector<CTransaction> txn;
+
+    BlockTransactions() {}
+    explicit BlockTransactions(const BlockTransactionsRequest& req) :
+        blockhash(req.blockhash), txn(req.indexes.size()) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(blockhash);
+        READWRITE(txn);
+    }
+};
+
+/** A transaction sent along with a compact block, with its index differentially encoded */
+struct PrefilledTransaction
+{
+    uint16_t index;
+    CTransaction tx;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        uint64_t idx = index;
+        READWRITE(COMPACTSIZE(idx));
+        if (idx > std::numeric_limits<uint16_t>::max())
+            throw std::ios_base::failure("index overflowed 16 bits");
+        index = idx;
+        READWRITE(tx);
+    }
+};
+
+typedef enum ReadStatus_t
+{
+    READ_STATUS_OK,
+    READ_STATUS_INVALID, // Invalid object, peer is sending bogus crap
+    READ_STATUS_FAILED, // Failed to process object, fall back to requesting the full block
+} ReadStatus;
+
+/** The "cmpctblock" message */
+class CBlockHeaderAndShortTxIDs
+{
+private:
+    mutable uint64_t shorttxidk0, shorttxidk1;
+    uint64_t nonce;
+
+    void FillShortTxIDSelector() const;
+
+    friend class PartiallyDownloadedBlock;
+
+    static const int SHORTTXIDS_LENGTH = 6;
+
+protected:
+    std::vector<uint64_t> shorttxids;
+    std::vector<PrefilledTransaction> prefilledtxn;
+
+public:
+    CBlockHeader header;
+
+    // Dummy for deserialization
+    CBlockHeaderAndShortTxIDs() {}
+
+    explicit CBlockHeaderAndShortTxIDs(const CBlock& block);
+
+    uint64_t GetShortID(const uint256& txhash) const;
+
+    size_t BlockTxCount() const { return shorttxids.size() + prefilledtxn.size(); }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(header);
+        READWRITE(nonce);
+
+        uint64_t shorttxids_size = (uint64_t)shorttxids.size();
+        READWRITE(COMPACTSIZE(shorttxids_size));
+        if (ser_action.ForRead()) {
+            size_t i = 0;
+            while (shorttxids.size() < shorttxids_size) {
+                shorttxids.resize(std::min((uint64_t)(1000 + shorttxids.size()), shorttxids_size));
+                for (; i < shorttxids.size(); i++) {
+                    uint32_t lsb = 0; uint16_t msb = 0;
+                    READWRITE(lsb);
+                    READWRITE(msb);
+                    shorttxids[i] = (uint64_t(msb) << 32) | uint64_t(lsb);
+                }
+            }
+        } else {
+            for (size_t i = 0; i < shorttxids.size(); i++) {
+                uint32_t lsb = shorttxids[i] & 0xffffffff;
+                uint16_t msb = (shorttxids[i] >> 32) & 0xffff;
+                READWRITE(lsb);
+                READWRITE(msb);
+            }
+        }
+
+        READWRITE(prefilledtxn);
+
+        if (ser_action.ForRead())
+            FillShortTxIDSelector();
+    }
+};
+
+/** A block being rebuilt from a compact block, the mempool and a "blocktxn" answer */
+class PartiallyDownloadedBlock
+{
+protected:
+    std::vector<CTransaction> txn_available;
+    std::vector<bool> have_txn;
+    size_t prefilled_count, mempool_count;
+    CTxMemPool* pool;
+
+public:
+    CBlockHeader header;
+
+    explicit PartiallyDownloadedBlock(CTxMemPool* poolIn) : prefilled_count(0), mempool_count(0), pool(poolIn) {}
+
+    /** Place the prefilled transactions and look the others up in the mempool */
+    ReadStatus InitData(const CBlockHeaderAndShortTxIDs& cmpctblock);
+    bool IsTxAvailable(size_t index) const;
+    /** Assemble the block, taking the transactions that were still missing from vtx_missing, in order */
+    ReadStatus FillBlock(CBlock& block, const std::vector<CTransaction>& vtx_missing) const;
+
+    size_t BlockTxCount() const { return txn_available.size(); }
+    size_t PrefilledCount() const { return prefilled_count; }
+    size_t MempoolCount() const { return mempool_count; }
+};
+
+#endif // BITCOIN_BLOCKENCODINGS_H
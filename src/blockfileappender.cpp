@@ -0,0 +1,119 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfileappender.h"
+
+#include "main.h"
+
+#include <boost/filesystem.hpp>
+
+bool CBlockFileAppender::CloseFile(FileMap::iterator it)
+{
+    AssertLockHeld(cs);
+    bool fOk = true;
+    if (it->second.fDirty) {
+        FileCommit(it->second.file);
+        fOk = !ferror(it->second.file);
+    }
+    if (fclose(it->second.file) != 0)
+        fOk = false;
+    mapFiles.erase(it);
+    return fOk;
+}
+
+CBlockFileAppender::File* CBlockFileAppender::Seek(const CDiskBlockPos& pos, const char* prefix)
+{
+    AssertLockHeld(cs);
+    const std::pair<std::string, int> key(prefix, pos.nFile);
+    FileMap::iterator it = mapFiles.find(key);
+    if (it == mapFiles.end()) {
+        while (mapFiles.size() >= MAX_APPEND_FILES) {
+            FileMap::iterator itOldest = mapFiles.begin();
+            for (FileMap::iterator itFile = mapFiles.begin(); itFile != mapFiles.end(); ++itFile)
+                if (itFile->second.nLastUsed < itOldest->second.nLastUsed)
+                    itOldest = itFile;
+            if (!CloseFile(itOldest))
+                return NULL;
+        }
+        // Not through OpenDiskFile: the buffer has to be set before anything
+        // reads from or writes to the file, and appending needs no prefetch
+        boost::filesystem::path path = GetBlockPosFilename(pos, prefix);
+        boost::filesystem::create_directories(path.parent_path());
+        FILE* file = fopen(path.string().c_str(), "rb+");
+        if (!file)
+            file = fopen(path.string().c_str(), "wb+");
+        if (!file) {
+            LogPrintf("Unable to open file %s\n", path.string());
+            return NULL;
+        }
+        File& entry = mapFiles[key];
+        entry.file = file;
+        entry.buffer.reset(new char[BLOCKFILE_WRITE_BUFFER]);
+        setvbuf(file, entry.buffer.get(), _IOFBF, BLOCKFILE_WRITE_BUFFER);
+        entry.nPos = 0;
+        entry.fPending = false;
+        entry.fDirty = false;
+        it = mapFiles.find(key);
+    }
+    it->second.nLastUsed = ++nUseCount;
+    // Seeking flushes the buffer, appends in order don't need to
+    if (it->second.nPos != pos.nPos) {
+        if (fseek(it->second.file, pos.nPos, SEEK_SET) != 0) {
+            LogPrintf("Unable to seek to position %u of %s\n", pos.nPos, GetBlockPosFilename(pos, prefix).string());
+            return NULL;
+        }
+        it->second.nPos = pos.nPos;
+    }
+    return &it->second;
+}
+
+void CBlockFileAppender::Flush(const CDiskBlockPos& pos, const char* prefix)
+{
+    LOCK(cs);
+    FileMap::iterator it = mapFiles.find(std::make_pair(std::string(prefix), pos.nFile));
+    if (it != mapFiles.end() && it->second.fPending) {
+        fflush(it->second.file);
+        it->second.fPending = false;
+    }
+}
+
+bool CBlockFileAppender::Commit()
+{
+    LOCK(cs);
+    bool fOk = true;
+    for (FileMap::iterator it = mapFiles.begin(); it != mapFiles.end(); ++it) {
+        if (!it->second.fDirty)
+            continue;
+        FileCommit(it->second.file);
+        if (ferror(it->second.file)) {
+            LogPrintf("%s: failed to write %s%05u.dat\n", __func__, it->first.first, it->first.second);
+            fOk = false;
+            continue;
+        }
+        it->second.fPending = it->second.fDirty = false;
+    }
+    return fOk;
+}
+
+bool CBlockFileAppender::Close(const CDiskBlockPos& pos, const char* prefix)
+{
+    LOCK(cs);
+    FileMap::iterator it = mapFiles.find(std::make_pair(std::string(prefix), pos.nFile));
+    return it == mapFiles.end() || CloseFile(it);
+}
+
+bool CBlockFileAppender::CloseAll()
+{
+    LOCK(cs);
+    bool fOk = true;
+    while (!mapFiles.empty())
+        fOk &= CloseFile(mapFiles.begin());
+    return fOk;
+}
+
+size_t CBlockFileAppender::Count()
+{
+    LOCK(cs);
+    return mapFiles.size();
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKFILEAPPENDER_H
+#define BITCOIN_BLOCKFILEAPPENDER_H
+
+#include "chain.h"
+#include "clientversion.h"
+#include "protocol.h"
+#include "streams.h"
+#include "sync.h"
+#include "uint256.h"
+#include "util.h"
+
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <stdint.h>
+#include <stdio.h>
+
+/** Write buffer of each blk/rev file being appended to */
+static const size_t BLOCKFILE_WRITE_BUFFER = 1 << 20;
+/** Number of blk/rev files kept open for appending, undo data may go to older rev files */
+static const size_t MAX_APPEND_FILES = 8;
+
+/**
+ * Keeps the blk and rev files that blocks and undo data are appended to open,
+ * so that writing one is a buffered fwrite instead of an open, seek, write and
+ * close. Appended data reaches the OS when the buffer fills or somebody opens
+ * or maps the file to read it, and reaches the disk in Commit(), which
+ * FlushBlockFile calls before the block index referring to it is written.
+ */
+class CBlockFileAppender
+{
+public:
+    CBlockFileAppender() : nUseCount(0) { }
+    ~CBlockFileAppender() { CloseAll(); }
+
+    /**
+     * Append a record at pos: the message start, the serialized size of obj, obj
+     * and then the checksum if one is given. pos is moved past the header, to
+     * where obj starts.
+     */
+    template<typename T>
+    bool Append(CDiskBlockPos& pos, const char* prefix, const CMessageHeader::MessageStartChars& messageStart, const T& obj, const uint256* pChecksum = NULL)
+    {
+        LOCK(cs);
+        File* entry = Seek(pos, prefix);
+        if (entry == NULL)
+            return false;
+        entry->fPending = entry->fDirty = true;
+        // Nothing is known about the position after a failed write
+        entry->nPos = std::numeric_limits<unsigned int>::max();
+
+        // The stream must not close a file that stays open
+        CAutoFile fileout(entry->file, SER_DISK, CLIENT_VERSION);
+        unsigned int nSize = fileout.GetSerializeSize(obj);
+        try {
+            fileout << FLATDATA(messageStart) << nSize;
+            fileout << obj;
+            if (pChecksum)
+                fileout << *pChecksum;
+        } catch (const std::exception& e) {
+            fileout.release();
+            return error("%s: write to %s%05u.dat failed - %s", __func__, prefix, pos.nFile, e.what());
+        }
+        fileout.release();
+
+        pos.nPos += MESSAGE_START_SIZE + sizeof(nSize);
+        entry->nPos = pos.nPos + nSize + (pChecksum ? sizeof(*pChecksum) : 0);
+        return true;
+    }
+
+    /** Hand what was appended to a file to the OS, so it can be read back. */
+    void Flush(const CDiskBlockPos& pos, const char* prefix);
+
+    /** Write everything appended since the last commit to disk, whichever files it went to. */
+    bool Commit();
+
+    /** Commit and close a file, before it is truncated. */
+    bool Close(const CDiskBlockPos& pos, const char* prefix);
+
+    bool CloseAll();
+
+    /** Number of files open for appending. */
+    size_t Count();
+
+private:
+    struct File {
+        FILE* file;
+        std::unique_ptr<char[]> buffer;
+        unsigned int nPos;  //! Where the next write goes without a seek
+        bool fPending;      //! Written to, not flushed to the OS yet
+        bool fDirty;        //! Written to, not committed to disk yet
+        int64_t nLastUsed;
+    };
+    typedef std::map<std::pair<std::string, int>, File> FileMap;
+
+    CCriticalSection cs;
+    FileMap mapFiles;
+    int64_t nUseCount;
+
+    bool CloseFile(FileMap::iterator it);
+    File* Seek(const CDiskBlockPos& pos, const char* prefix);
+
+    CBlockFileAppender(const CBlockFileAppender&);
+    CBlockFileAppender& operator=(const CBlockFileAppender&);
+};
+
+#endif // BITCOIN_BLOCKFILEAPPENDER_H
@@ -0,0 +1,130 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilemap.h"
+
+#include <algorithm>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::shared_ptr<const CMappedFile> CMappedFile::Open(const boost::filesystem::path& path)
+{
+#ifdef WIN32
+    return std::shared_ptr<const CMappedFile>();
+#else
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd < 0)
+        return std::shared_ptr<const CMappedFile>();
+    struct stat st;
+    void* p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+    if (p == MAP_FAILED)
+        return std::shared_ptr<const CMappedFile>();
+    // Reads land all over the file, don't let the kernel read ahead of each one
+    posix_madvise(p, st.st_size, POSIX_MADV_RANDOM);
+    return std::shared_ptr<const CMappedFile>(new CMappedFile((const char*)p, st.st_size));
+#endif
+}
+
+CMappedFile::~CMappedFile()
+{
+#ifndef WIN32
+    munmap((void*)pdata, nSize);
+#endif
+}
+
+void CMappedFile::WillNeed(size_t nPos, size_t nLen) const
+{
+#ifndef WIN32
+    if (nPos >= nSize)
+        return;
+    nLen = std::min(nLen, nSize - nPos);
+    // madvise wants a page aligned start
+    size_t nPageSize = sysconf(_SC_PAGESIZE);
+    size_t nStart = nPos - nPos % nPageSize;
+    posix_madvise((void*)(pdata + nStart), nPos + nLen - nStart, POSIX_MADV_WILLNEED);
+#endif
+}
+
+CBlockFileMapCache::CBlockFileMapCache(size_t nMaxMapsIn) : nMaxMaps(nMaxMapsIn)
+{
+}
+
+CBlockFileMapCache::Mapping CBlockFileMapCache::Get(const boost::filesystem::path& path)
+{
+    std::string strPath = path.string();
+    {
+        LOCK(cs);
+        if (nMaxMaps == 0)
+            return Mapping();
+        std::map<std::string, EntryList::iterator>::iterator mi = mapEntries.find(strPath);
+        if (mi != mapEntries.end()) {
+            lru.splice(lru.begin(), lru, mi->second);
+            return mi->second->second;
+        }
+    }
+
+    // Map outside the lock, other files can be read from meanwhile
+    Mapping mapping = CMappedFile::Open(path);
+    if (!mapping)
+        return mapping;
+
+    LOCK(cs);
+    std::map<std::string, EntryList::iterator>::iterator mi = mapEntries.find(strPath);
+    if (mi != mapEntries.end()) {
+        lru.splice(lru.begin(), lru, mi->second);
+        return mi->second->second;
+    }
+    lru.push_front(std::make_pair(strPath, mapping));
+    mapEntries[strPath] = lru.begin();
+    Trim();
+    return mapping;
+}
+
+void CBlockFileMapCache::Erase(const boost::filesystem::path& path)
+{
+    LOCK(cs);
+    std::map<std::string, EntryList::iterator>::iterator mi = mapEntries.find(path.string());
+    if (mi != mapEntries.end()) {
+        lru.erase(mi->second);
+        mapEntries.erase(mi);
+    }
+}
+
+void CBlockFileMapCache::Trim()
+{
+    AssertLockHeld(cs);
+    while (lru.size() > nMaxMaps) {
+        mapEntries.erase(lru.back().first);
+        lru.pop_back();
+    }
+}
+
+void CBlockFileMapCache::SetMaxMaps(size_t nMaxMapsIn)
+{
+    LOCK(cs);
+    nMaxMaps = nMaxMapsIn;
+    Trim();
+}
+
+void CBlockFileMapCache::Clear()
+{
+    LOCK(cs);
+    lru.clear();
+    mapEntries.clear();
+}
+
+size_t CBlockFileMapCache::Count() const
+{
+    LOCK(cs);
+    return lru.size();
+}
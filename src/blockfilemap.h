@@ -0,0 +1,83 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKFILEMAP_H
+#define BITCOIN_BLOCKFILEMAP_H
+
+#include "sync.h"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <stdint.h>
+
+#include <boost/filesystem/path.hpp>
+
+/** Default for -blockfilemaps, 0 on 32-bit systems where address space is scarce */
+static const unsigned int DEFAULT_BLOCKFILE_MAPS = sizeof(void*) >= 8 ? 64 : 0;
+
+/** A whole file mapped read-only into memory. */
+class CMappedFile
+{
+public:
+    /** Map a file. Returns NULL if it can't be opened or mapped, or is empty. */
+    static std::shared_ptr<const CMappedFile> Open(const boost::filesystem::path& path);
+
+    ~CMappedFile();
+
+    const char* data() const { return pdata; }
+    size_t size() const { return nSize; }
+
+    /** Ask the kernel to read [nPos, nPos + nLen) in ahead of it being deserialized. */
+    void WillNeed(size_t nPos, size_t nLen) const;
+
+private:
+    const char* pdata;
+    size_t nSize;
+
+    CMappedFile(const char* pdataIn, size_t nSizeIn) : pdata(pdataIn), nSize(nSizeIn) { }
+    CMappedFile(const CMappedFile&);
+    CMappedFile& operator=(const CMappedFile&);
+};
+
+/**
+ * Mappings of blk and rev files that are no longer appended to, so that block
+ * and undo reads deserialize straight from memory instead of opening, seeking
+ * and reading the file each time. At most nMaxMaps files are mapped; the least
+ * recently used is unmapped once it is no longer being read from.
+ *
+ * A mapping covers the file as it was when it was mapped. Callers check that a
+ * record lies within it and read the file the usual way otherwise.
+ */
+class CBlockFileMapCache
+{
+public:
+    typedef std::shared_ptr<const CMappedFile> Mapping;
+
+    explicit CBlockFileMapCache(size_t nMaxMapsIn);
+
+    /** Get the mapping of a file, mapping it if needed. Returns NULL if disabled or mapping fails. */
+    Mapping Get(const boost::filesystem::path& path);
+
+    /** Drop the mapping of a file, before it is truncated or deleted. */
+    void Erase(const boost::filesystem::path& path);
+
+    void SetMaxMaps(size_t nMaxMapsIn);
+    void Clear();
+
+    size_t Count() const;
+
+private:
+    typedef std::list<std::pair<std::string, Mapping> > EntryList;
+
+    mutable CCriticalSection cs;
+    EntryList lru; // most recently used first
+    std::map<std::string, EntryList::iterator> mapEntries;
+    size_t nMaxMaps;
+
+    void Trim();
+};
+
+#endif // BITCOIN_BLOCKFILEMAP_H
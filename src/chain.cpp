@@ -5,8 +5,52 @@
 
 #include "chain.h"
 
+#include <new>
+
 using namespace std;
 
+/**
+ * CBlockIndexArena implementation
+ */
+void* CBlockIndexArena::Reserve() {
+    if (nUsed == ENTRIES_PER_CHUNK) {
+        vChunks.reserve(vChunks.size() + 1);
+        vChunks.push_back(static_cast<CBlockIndex*>(::operator new(sizeof(CBlockIndex) * ENTRIES_PER_CHUNK)));
+        nUsed = 0;
+    }
+    return vChunks.back() + nUsed;
+}
+
+CBlockIndex* CBlockIndexArena::Allocate() {
+    // Only count the slot once the constructor has not thrown
+    CBlockIndex* pindex = new (Reserve()) CBlockIndex();
+    nUsed++;
+    return pindex;
+}
+
+CBlockIndex* CBlockIndexArena::Allocate(const CBlockHeader& block) {
+    CBlockIndex* pindex = new (Reserve()) CBlockIndex(block);
+    nUsed++;
+    return pindex;
+}
+
+void CBlockIndexArena::Clear() {
+    for (size_t i = 0; i < vChunks.size(); i++) {
+        size_t nEntries = (i + 1 == vChunks.size()) ? nUsed : ENTRIES_PER_CHUNK;
+        for (size_t j = 0; j < nEntries; j++)
+            vChunks[i][j].~CBlockIndex();
+        ::operator delete(vChunks[i]);
+    }
+    vChunks.clear();
+    nUsed = ENTRIES_PER_CHUNK;
+}
+
+size_t CBlockIndexArena::Size() const {
+    if (vChunks.empty())
+        return 0;
+    return (vChunks.size() - 1) * ENTRIES_PER_CHUNK + nUsed;
+}
+
 /**
  * CChain implementation
  */
@@ -110,6 +110,11 @@ static const BlockStatus BLOCK_VALID_CONSENSUS = BLOCK_VALID_SCRIPTS;
 class CBlockIndex
 {
 public:
+    // Fields used when walking the index (pprev/pskip chains, difficulty and
+    // stake windows, best chain selection) come first so that they share the
+    // entry's first cache lines. Fields only needed to serve or validate the
+    // block itself follow.
+
     //! pointer to the hash of the block, if any. Memory is owned by this CBlockIndex
     const uint256* phashBlock;
 
@@ -122,14 +127,14 @@ public:
     //! height of the entry in the chain. The genesis block has height 0
     int nHeight;
 
-    //! Which # file this block is stored in (blk?????.dat)
-    int nFile;
-
-    //! Byte offset within blk?????.dat where this block's data is stored
-    unsigned int nDataPos;
+    //! Verification status of this block. See enum BlockStatus
+    unsigned int nStatus;
 
-    //! Byte offset within rev?????.dat where this block's undo data is stored
-    unsigned int nUndoPos;
+    //! block header, the fields read by the difficulty and stake loops
+    int nVersion;
+    unsigned int nTime;
+    unsigned int nBits;
+    uint256 nNonce;
 
     //! (memory only) Total amount of work (expected number of hashes) in the chain up to and including this block
     arith_uint256 nChainWork;
@@ -143,8 +148,26 @@ public:
     //! Change to 64-bit type when necessary; won't happen before 2030
     unsigned int nChainTx;
 
-    //! Verification status of this block. See enum BlockStatus
-    unsigned int nStatus;
+    //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
+    uint32_t nSequenceId;
+
+    //! Which # file this block is stored in (blk?????.dat)
+    int nFile;
+
+    //! Byte offset within blk?????.dat where this block's data is stored
+    unsigned int nDataPos;
+
+    //! Byte offset within rev?????.dat where this block's undo data is stored
+    unsigned int nUndoPos;
+
+    //! (memory only) Whether komodo_PoWtarget counts this block as PoW (1) or PoS (0), -1 until it is classified
+    int8_t nPoWClass;
+
+    //! (memory only) Whether the nonce marks this as a Verus PoS block (1) or not (0), -1 until it is checked
+    mutable int8_t nVerusPOS;
+
+    //! (memory only) Whether minerPubKey33 is known, see GetBlockMinerPubKey
+    bool fMinerPubKey;
 
     //! Branch ID corresponding to the consensus rules used to validate this block.
     //! Only cached if block validity is BLOCK_VALID_CONSENSUS.
@@ -166,17 +189,14 @@ public:
     //! Will be boost::none if nChainTx is zero.
     boost::optional<CAmount> nChainSproutValue;
 
-    //! block header
-    int nVersion;
+    //! block header, the rest
     uint256 hashMerkleRoot;
     uint256 hashReserved;
-    unsigned int nTime;
-    unsigned int nBits;
-    uint256 nNonce;
     std::vector<unsigned char> nSolution;
 
-    //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
-    uint32_t nSequenceId;
+    //! pubkey33 paid by the coinbase, as komodo_block2pubkey33 extracts it. Persisted in the
+    //! block tree database next to the index entry, so the notary checks needn't read the block
+    uint8_t minerPubKey33[33];
     
     void SetNull()
     {
@@ -195,6 +215,10 @@ public:
         hashAnchor = uint256();
         hashAnchorEnd = uint256();
         nSequenceId = 0;
+        nPoWClass = -1;
+        nVerusPOS = -1;
+        fMinerPubKey = false;
+        memset(minerPubKey33, 0, sizeof(minerPubKey33));
         nSproutValue = boost::none;
         nChainSproutValue = boost::none;
 
@@ -322,14 +346,23 @@ public:
     CBlockIndex* GetAncestor(int height);
     const CBlockIndex* GetAncestor(int height) const;
 
+    // Both only look at the nonce, so they don't build the whole header
+
     int32_t GetVerusPOSTarget() const
     {
-        return GetBlockHeader().GetVerusPOSTarget();
+        CBlockHeader block;
+        block.nNonce = nNonce;
+        return block.GetVerusPOSTarget();
     }
 
     bool IsVerusPOSBlock() const
     {
-        return GetBlockHeader().IsVerusPOSBlock();
+        if (nVerusPOS < 0) {
+            CBlockHeader block;
+            block.nNonce = nNonce;
+            nVerusPOS = block.IsVerusPOSBlock();
+        }
+        return nVerusPOS != 0;
     }
 };
 
@@ -420,6 +453,41 @@ public:
     }
 };
 
+/**
+ * Storage for the block index entries. Entries are carved out of large
+ * chunks instead of being allocated one by one, so headers that are loaded or
+ * received together sit next to each other in memory, and the allocator's
+ * per-object overhead is paid once per chunk. Entries are never freed on their
+ * own, only all together by Clear(), the same lifetime mapBlockIndex gives
+ * them. Not thread safe, callers hold cs_main.
+ */
+class CBlockIndexArena
+{
+public:
+    static const size_t ENTRIES_PER_CHUNK = 4096;
+
+    CBlockIndexArena() : nUsed(ENTRIES_PER_CHUNK) {}
+    ~CBlockIndexArena() { Clear(); }
+
+    CBlockIndex* Allocate();
+    CBlockIndex* Allocate(const CBlockHeader& block);
+
+    //! Destroy every entry, pointers handed out before are invalid afterwards
+    void Clear();
+
+    size_t Size() const;
+
+private:
+    std::vector<CBlockIndex*> vChunks;
+    //! Entries constructed in the last chunk
+    size_t nUsed;
+
+    void* Reserve();
+
+    CBlockIndexArena(const CBlockIndexArena&);
+    CBlockIndexArena& operator=(const CBlockIndexArena&);
+};
+
 /** An in-memory indexed chain of blocks. */
 class CChain {
 private:
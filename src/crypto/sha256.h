@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string>
 
 /** A hasher class for SHA-256. */
 class CSHA256
@@ -29,4 +30,17 @@ private:
     void FinalizeNoPadding(unsigned char hash[OUTPUT_SIZE], bool enforce_compression);
 };
 
+/**
+ * Select the fastest SHA-256 implementation this CPU supports, and return a
+ * description of it. Call once at startup, before any hashing threads exist.
+ */
+std::string SHA256AutoDetect();
+
+/**
+ * Compute the double SHA-256 of each of `blocks` consecutive 64 byte inputs,
+ * writing the 32 byte results consecutively to output. This is the merkle
+ * tree inner node hash, and uses the multi-buffer SIMD kernels when available.
+ */
+void SHA256D64(unsigned char* output, const unsigned char* input, size_t blocks);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
@@ -0,0 +1,96 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// SHA-256 transform using the Intel SHA extensions.
+
+#ifdef ENABLE_SHANI
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include "crypto/sha256_consts.h"
+
+namespace {
+
+alignas(16) const uint8_t BSWAP_MASK[16] = {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12};
+
+/** Four rounds, m holds the message words. */
+void inline QuadRound(__m128i& state0, __m128i& state1, __m128i m, int i)
+{
+    const __m128i msg = _mm_add_epi32(m, _mm_loadu_si128((const __m128i*)(sha256_consts::K + 4 * i)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0e));
+}
+
+/** Replace m0, the oldest four message words, with the next four. */
+void inline Schedule(__m128i& m0, __m128i m1, __m128i m2, __m128i m3)
+{
+    m0 = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(m0, m1), _mm_alignr_epi8(m3, m2, 4)), m3);
+}
+
+/** Convert the state from abcd/efgh to the abef/cdgh layout the instructions use. */
+void inline Shuffle(__m128i& s0, __m128i& s1)
+{
+    const __m128i t1 = _mm_shuffle_epi32(s0, 0xB1);
+    const __m128i t2 = _mm_shuffle_epi32(s1, 0x1B);
+    s0 = _mm_alignr_epi8(t1, t2, 0x08);
+    s1 = _mm_blend_epi16(t2, t1, 0xF0);
+}
+
+void inline Unshuffle(__m128i& s0, __m128i& s1)
+{
+    const __m128i t1 = _mm_shuffle_epi32(s0, 0x1B);
+    const __m128i t2 = _mm_shuffle_epi32(s1, 0xB1);
+    s0 = _mm_blend_epi16(t1, t2, 0xF0);
+    s1 = _mm_alignr_epi8(t2, t1, 0x08);
+}
+
+__m128i inline Load(const unsigned char* in)
+{
+    return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)in), _mm_load_si128((const __m128i*)BSWAP_MASK));
+}
+
+} // namespace
+
+namespace sha256_shani {
+void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks)
+{
+    __m128i s0 = _mm_loadu_si128((const __m128i*)s);
+    __m128i s1 = _mm_loadu_si128((const __m128i*)(s + 4));
+    Shuffle(s0, s1);
+
+    while (blocks--) {
+        const __m128i save0 = s0, save1 = s1;
+        __m128i m0 = Load(chunk);
+        __m128i m1 = Load(chunk + 16);
+        __m128i m2 = Load(chunk + 32);
+        __m128i m3 = Load(chunk + 48);
+
+        QuadRound(s0, s1, m0, 0);
+        QuadRound(s0, s1, m1, 1);
+        QuadRound(s0, s1, m2, 2);
+        QuadRound(s0, s1, m3, 3);
+        for (int i = 4; i < 16; i += 4) {
+            Schedule(m0, m1, m2, m3);
+            QuadRound(s0, s1, m0, i);
+            Schedule(m1, m2, m3, m0);
+            QuadRound(s0, s1, m1, i + 1);
+            Schedule(m2, m3, m0, m1);
+            QuadRound(s0, s1, m2, i + 2);
+            Schedule(m3, m0, m1, m2);
+            QuadRound(s0, s1, m3, i + 3);
+        }
+
+        s0 = _mm_add_epi32(s0, save0);
+        s1 = _mm_add_epi32(s1, save1);
+        chunk += 64;
+    }
+
+    Unshuffle(s0, s1);
+    _mm_storeu_si128((__m128i*)s, s0);
+    _mm_storeu_si128((__m128i*)(s + 4), s1);
+}
+}
+
+#endif
@@ -0,0 +1,155 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Double SHA-256 of four independent 64 byte messages at once, with SSE4.1.
+
+#ifdef ENABLE_SSE41
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include "crypto/common.h"
+#include "crypto/sha256_consts.h"
+
+namespace sha256d64_sse41 {
+namespace {
+
+__m128i inline K(uint32_t x) { return _mm_set1_epi32(x); }
+
+__m128i inline Add(__m128i x, __m128i y) { return _mm_add_epi32(x, y); }
+__m128i inline Add(__m128i x, __m128i y, __m128i z) { return Add(Add(x, y), z); }
+__m128i inline Add(__m128i w, __m128i x, __m128i y, __m128i z) { return Add(Add(w, x), Add(y, z)); }
+__m128i inline Xor(__m128i x, __m128i y) { return _mm_xor_si128(x, y); }
+__m128i inline Xor(__m128i x, __m128i y, __m128i z) { return Xor(Xor(x, y), z); }
+__m128i inline Or(__m128i x, __m128i y) { return _mm_or_si128(x, y); }
+__m128i inline And(__m128i x, __m128i y) { return _mm_and_si128(x, y); }
+__m128i inline ShR(__m128i x, int n) { return _mm_srli_epi32(x, n); }
+__m128i inline ShL(__m128i x, int n) { return _mm_slli_epi32(x, n); }
+
+__m128i inline Ch(__m128i x, __m128i y, __m128i z) { return Xor(z, And(x, Xor(y, z))); }
+__m128i inline Maj(__m128i x, __m128i y, __m128i z) { return Or(And(x, y), And(z, Or(x, y))); }
+__m128i inline Sigma0(__m128i x) { return Xor(Or(ShR(x, 2), ShL(x, 30)), Or(ShR(x, 13), ShL(x, 19)), Or(ShR(x, 22), ShL(x, 10))); }
+__m128i inline Sigma1(__m128i x) { return Xor(Or(ShR(x, 6), ShL(x, 26)), Or(ShR(x, 11), ShL(x, 21)), Or(ShR(x, 25), ShL(x, 7))); }
+__m128i inline sigma0(__m128i x) { return Xor(Or(ShR(x, 7), ShL(x, 25)), Or(ShR(x, 18), ShL(x, 14)), ShR(x, 3)); }
+__m128i inline sigma1(__m128i x) { return Xor(Or(ShR(x, 17), ShL(x, 15)), Or(ShR(x, 19), ShL(x, 13)), ShR(x, 10)); }
+
+/** One round of SHA-256 on every lane, kw is the round constant plus the message word. */
+void inline Round(__m128i a, __m128i b, __m128i c, __m128i& d, __m128i e, __m128i f, __m128i g, __m128i& h, __m128i kw)
+{
+    __m128i t1 = Add(h, Sigma1(e), Ch(e, f, g), kw);
+    __m128i t2 = Add(Sigma0(a), Maj(a, b, c));
+    d = Add(d, t1);
+    h = Add(t1, t2);
+}
+
+void inline Rounds16(__m128i& a, __m128i& b, __m128i& c, __m128i& d, __m128i& e, __m128i& f, __m128i& g, __m128i& h, const __m128i* kw)
+{
+    Round(a, b, c, d, e, f, g, h, kw[0]);
+    Round(h, a, b, c, d, e, f, g, kw[1]);
+    Round(g, h, a, b, c, d, e, f, kw[2]);
+    Round(f, g, h, a, b, c, d, e, kw[3]);
+    Round(e, f, g, h, a, b, c, d, kw[4]);
+    Round(d, e, f, g, h, a, b, c, kw[5]);
+    Round(c, d, e, f, g, h, a, b, kw[6]);
+    Round(b, c, d, e, f, g, h, a, kw[7]);
+    Round(a, b, c, d, e, f, g, h, kw[8]);
+    Round(h, a, b, c, d, e, f, g, kw[9]);
+    Round(g, h, a, b, c, d, e, f, kw[10]);
+    Round(f, g, h, a, b, c, d, e, kw[11]);
+    Round(e, f, g, h, a, b, c, d, kw[12]);
+    Round(d, e, f, g, h, a, b, c, kw[13]);
+    Round(c, d, e, f, g, h, a, b, kw[14]);
+    Round(b, c, d, e, f, g, h, a, kw[15]);
+}
+
+/** Compress one block per lane into s. w holds the 16 message words, and is used for the message schedule. */
+void inline Compress(__m128i* s, __m128i* w)
+{
+    __m128i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    __m128i kw[16];
+    for (int r = 0; r < 64; r += 16) {
+        if (r > 0) {
+            // Extend the message schedule in place, w[j] becomes word r + j
+            for (int j = 0; j < 16; j++)
+                w[j] = Add(w[j], sigma1(w[(j + 14) & 15]), w[(j + 9) & 15], sigma0(w[(j + 1) & 15]));
+        }
+        for (int j = 0; j < 16; j++)
+            kw[j] = Add(K(sha256_consts::K[r + j]), w[j]);
+        Rounds16(a, b, c, d, e, f, g, h, kw);
+    }
+    s[0] = Add(s[0], a);
+    s[1] = Add(s[1], b);
+    s[2] = Add(s[2], c);
+    s[3] = Add(s[3], d);
+    s[4] = Add(s[4], e);
+    s[5] = Add(s[5], f);
+    s[6] = Add(s[6], g);
+    s[7] = Add(s[7], h);
+}
+
+/** Compress the padding block of a 64 byte message, whose schedule is precomputed. */
+void inline CompressPadding64(__m128i* s)
+{
+    __m128i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    __m128i kw[16];
+    for (int r = 0; r < 64; r += 16) {
+        for (int j = 0; j < 16; j++)
+            kw[j] = K(sha256_consts::KW_PAD64[r + j]);
+        Rounds16(a, b, c, d, e, f, g, h, kw);
+    }
+    s[0] = Add(s[0], a);
+    s[1] = Add(s[1], b);
+    s[2] = Add(s[2], c);
+    s[3] = Add(s[3], d);
+    s[4] = Add(s[4], e);
+    s[5] = Add(s[5], f);
+    s[6] = Add(s[6], g);
+    s[7] = Add(s[7], h);
+}
+
+__m128i inline Read(const unsigned char* in, int off)
+{
+    return _mm_set_epi32(ReadBE32(in + 192 + off), ReadBE32(in + 128 + off), ReadBE32(in + 64 + off), ReadBE32(in + 0 + off));
+}
+
+void inline Write(unsigned char* out, int off, __m128i v)
+{
+    WriteBE32(out + 0 + off, _mm_extract_epi32(v, 0));
+    WriteBE32(out + 32 + off, _mm_extract_epi32(v, 1));
+    WriteBE32(out + 64 + off, _mm_extract_epi32(v, 2));
+    WriteBE32(out + 96 + off, _mm_extract_epi32(v, 3));
+}
+
+} // namespace
+
+void Transform_4way(unsigned char* out, const unsigned char* in)
+{
+    __m128i s[8], w[16];
+
+    // First SHA-256: the 64 byte message, then its padding
+    for (int i = 0; i < 8; i++)
+        s[i] = K(sha256_consts::H0[i]);
+    for (int i = 0; i < 16; i++)
+        w[i] = Read(in, 4 * i);
+    Compress(s, w);
+    CompressPadding64(s);
+
+    // Second SHA-256, of the 32 byte result
+    for (int i = 0; i < 8; i++) {
+        w[i] = s[i];
+        s[i] = K(sha256_consts::H0[i]);
+    }
+    w[8] = K(0x80000000);
+    for (int i = 9; i < 15; i++)
+        w[i] = K(0);
+    w[15] = K(256);
+    Compress(s, w);
+
+    for (int i = 0; i < 8; i++)
+        Write(out, 4 * i, s[i]);
+}
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include "blockcache.h"
+#include "primitives/block.h"
+#include "version.h"
+
+static CBlock MakeBlock(uint32_t nTime, size_t nTx)
+{
+    CBlock block;
+    block.nTime = nTime;
+    for (size_t i = 0; i < nTx; i++) {
+        CMutableTransaction mtx;
+        mtx.vin.resize(1);
+        mtx.vin[0].scriptSig = CScript() << i;
+        mtx.vout.resize(1);
+        mtx.vout[0].nValue = i;
+        block.vtx.push_back(CTransaction(mtx));
+    }
+    return block;
+}
+
+TEST(RecentBlockCache, MatchesBlockSerialization) {
+    CRecentBlockCache cache(1 << 20);
+    CBlock block = MakeBlock(1, 3);
+
+    EXPECT_FALSE(cache.Get(block.GetHash()));
+    cache.Insert(block.GetHash(), block);
+
+    CRecentBlockCache::Entry entry = cache.Get(block.GetHash());
+    ASSERT_TRUE(entry);
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << block;
+    EXPECT_EQ(std::string(ss.begin(), ss.end()), std::string(entry->begin(), entry->end()));
+    EXPECT_EQ(1, cache.Hits());
+    EXPECT_EQ(1, cache.Misses());
+}
+
+TEST(RecentBlockCache, EvictsLeastRecentlyUsed) {
+    CBlock a = MakeBlock(1, 10), b = MakeBlock(2, 10), c = MakeBlock(3, 10);
+    size_t nSize = ::GetSerializeSize(a, SER_NETWORK, PROTOCOL_VERSION);
+    CRecentBlockCache cache(2 * nSize);
+
+    CRecentBlockCache::Entry held = cache.Insert(a.GetHash(), a);
+    cache.Insert(b.GetHash(), b);
+    EXPECT_EQ(2, cache.Count());
+
+    // Touch a so that b is the oldest
+    EXPECT_TRUE(cache.Get(a.GetHash()));
+    cache.Insert(c.GetHash(), c);
+    EXPECT_EQ(2, cache.Count());
+    EXPECT_TRUE(cache.Get(a.GetHash()));
+    EXPECT_FALSE(cache.Get(b.GetHash()));
+    EXPECT_TRUE(cache.Get(c.GetHash()));
+
+    // Evicted entries stay valid for whoever still holds them
+    cache.SetMaxBytes(0);
+    EXPECT_EQ(0, cache.Count());
+    EXPECT_EQ(0, cache.Bytes());
+    EXPECT_EQ(nSize, held->size());
+
+    // A block that can never fit is serialized but not kept
+    EXPECT_TRUE(cache.Insert(a.GetHash(), a));
+    EXPECT_EQ(0, cache.Count());
+}
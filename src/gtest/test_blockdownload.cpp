@@ -0,0 +1,23 @@
+#include <gtest/gtest.h>
+
+#include "main.h"
+
+TEST(BlockDownload, InFlightLimitFollowsRate) {
+    // Nothing measured yet
+    EXPECT_EQ(MAX_BLOCKS_IN_TRANSIT_PER_PEER, GetBlocksInFlightLimit(0, 0));
+    EXPECT_EQ(MAX_BLOCKS_IN_TRANSIT_PER_PEER, GetBlocksInFlightLimit(100000, 0));
+
+    // As many blocks as the peer delivers in BLOCK_DOWNLOAD_QUEUE_SECONDS
+    EXPECT_EQ(10 * BLOCK_DOWNLOAD_QUEUE_SECONDS, GetBlocksInFlightLimit(10 * 20000, 20000));
+
+    // Slow peers keep a few, fast ones are capped
+    EXPECT_EQ(MIN_BLOCKS_IN_TRANSIT_PER_PEER, GetBlocksInFlightLimit(1000, 2000000));
+    EXPECT_EQ(MAX_BLOCKS_IN_TRANSIT_PER_PEER_ADAPTIVE, GetBlocksInFlightLimit(100000000, 2000));
+}
+
+TEST(BlockDownload, WindowStaysWithinBounds) {
+    LOCK(cs_main);
+    int nWindow = GetBlockDownloadWindow();
+    EXPECT_GE(nWindow, BLOCK_DOWNLOAD_WINDOW);
+    EXPECT_LE(nWindow, BLOCK_DOWNLOAD_WINDOW_MAX);
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include "blockencodings.h"
+#include "main.h"
+#include "streams.h"
+#include "txmempool.h"
+#include "version.h"
+
+static CBlock BuildBlock(size_t nTx)
+{
+    CBlock block;
+    block.nBits = 0x207fffff;
+    block.nTime = 1;
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig = CScript() << 42;
+    coinbase.vout.resize(1);
+    coinbase.vout[0].nValue = 1;
+    block.vtx.push_back(CTransaction(coinbase));
+
+    for (size_t i = 1; i < nTx; i++) {
+        CMutableTransaction mtx;
+        mtx.vin.resize(1);
+        mtx.vin[0].prevout.hash = block.vtx[i - 1].GetHash();
+        mtx.vin[0].scriptSig = CScript() << i;
+        mtx.vout.resize(1);
+        mtx.vout[0].nValue = i;
+        block.vtx.push_back(CTransaction(mtx));
+    }
+    block.hashMerkleRoot = block.BuildMerkleTree();
+    return block;
+}
+
+static void AddToMempool(CTxMemPool& pool, const CTransaction& tx)
+{
+    pool.addUnchecked(tx.GetHash(), CTxMemPoolEntry(tx, 0, 0, 0.0, 1, true, false, 0));
+}
+
+static CBlockHeaderAndShortTxIDs RoundTrip(const CBlockHeaderAndShortTxIDs& cmpctblock)
+{
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << cmpctblock;
+    CBlockHeaderAndShortTxIDs result;
+    ss >> result;
+    return result;
+}
+
+TEST(BlockEncodings, ReconstructFromMempool) {
+    CTxMemPool pool(::minRelayTxFee);
+    CBlock block = BuildBlock(4);
+    for (size_t i = 1; i < block.vtx.size(); i++)
+        AddToMempool(pool, block.vtx[i]);
+
+    CBlockHeaderAndShortTxIDs cmpctblock = RoundTrip(CBlockHeaderAndShortTxIDs(block));
+    EXPECT_EQ(block.GetHash(), cmpctblock.header.GetHash());
+    EXPECT_EQ(block.vtx.size(), cmpctblock.BlockTxCount());
+
+    PartiallyDownloadedBlock partialBlock(&pool);
+    ASSERT_EQ(READ_STATUS_OK, partialBlock.InitData(cmpctblock));
+    for (size_t i = 0; i < block.vtx.size(); i++)
+        EXPECT_TRUE(partialBlock.IsTxAvailable(i));
+    EXPECT_EQ(1, partialBlock.PrefilledCount());
+    EXPECT_EQ(3, partialBlock.MempoolCount());
+
+    CBlock result;
+    ASSERT_EQ(READ_STATUS_OK, partialBlock.FillBlock(result, std::vector<CTransaction>()));
+    EXPECT_EQ(block.GetHash(), result.GetHash());
+    EXPECT_EQ(block.hashMerkleRoot, result.BuildMerkleTree());
+}
+
+TEST(BlockEncodings, FillMissingTransactions) {
+    CTxMemPool pool(::minRelayTxFee);
+    CBlock block = BuildBlock(4);
+    AddToMempool(pool, block.vtx[2]);
+
+    CBlockHeaderAndShortTxIDs cmpctblock = RoundTrip(CBlockHeaderAndShortTxIDs(block));
+    PartiallyDownloadedBlock partialBlock(&pool);
+    ASSERT_EQ(READ_STATUS_OK, partialBlock.InitData(cmpctblock));
+    EXPECT_TRUE(partialBlock.IsTxAvailable(0));
+    EXPECT_FALSE(partialBlock.IsTxAvailable(1));
+    EXPECT_TRUE(partialBlock.IsTxAvailable(2));
+    EXPECT_FALSE(partialBlock.IsTxAvailable(3));
+
+    CBlock result;
+    std::vector<CTransaction> vMissing;
+    vMissing.push_back(block.vtx[1]);
+    // Too few transactions
+    EXPECT_EQ(READ_STATUS_INVALID, partialBlock.FillBlock(result, vMissing));
+
+    // The right number, but not the right ones
+    vMissing.push_back(block.vtx[2]);
+    EXPECT_EQ(READ_STATUS_FAILED, partialBlock.FillBlock(result, vMissing));
+
+    vMissing[1] = block.vtx[3];
+    ASSERT_EQ(READ_STATUS_OK, partialBlock.FillBlock(result, vMissing));
+    EXPECT_EQ(block.GetHash(), result.GetHash());
+    EXPECT_EQ(block.hashMerkleRoot, result.BuildMerkleTree());
+}
+
+TEST(BlockEncodings, EmptyCompactBlockIsInvalid) {
+    CTxMemPool pool(::minRelayTxFee);
+    CBlockHeaderAndShortTxIDs cmpctblock;
+    PartiallyDownloadedBlock partialBlock(&pool);
+    EXPECT_EQ(READ_STATUS_INVALID, partialBlock.InitData(cmpctblock));
+}
+
+TEST(BlockEncodings, TransactionsRequestRoundTrip) {
+    BlockTransactionsRequest req;
+    req.blockhash = uint256S("0x1234");
+    req.indexes.push_back(0);
+    req.indexes.push_back(1);
+    req.indexes.push_back(3);
+    req.indexes.push_back(1000);
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << req;
+    // Differentially encoded: 0, 0, 1, 996
+    EXPECT_EQ(32 + 1 + 1 + 1 + 1 + 3, ss.size());
+
+    BlockTransactionsRequest result;
+    ss >> result;
+    EXPECT_EQ(req.blockhash, result.blockhash);
+    EXPECT_EQ(req.indexes, result.indexes);
+}
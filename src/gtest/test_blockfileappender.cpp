@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include "blockfileappender.h"
+#include "chainparams.h"
+#include "clientversion.h"
+#include "main.h"
+#include "streams.h"
+#include "util.h"
+
+#include <boost/filesystem.hpp>
+
+static const CMessageHeader::MessageStartChars messageStart = {0xf9, 0xee, 0xe4, 0x8d};
+
+class BlockFileAppenderTest : public ::testing::Test {
+protected:
+    boost::filesystem::path pathTemp;
+    std::string strDataDirOld;
+
+    virtual void SetUp() {
+        SelectParams(CBaseChainParams::MAIN);
+        pathTemp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::create_directories(pathTemp);
+        strDataDirOld = GetArg("-datadir", "");
+        mapArgs["-datadir"] = pathTemp.string();
+        ClearDatadirCache();
+    }
+
+    virtual void TearDown() {
+        blockFileAppender.CloseAll();
+        // Other tests may have set up a data directory of their own
+        if (strDataDirOld.empty())
+            mapArgs.erase("-datadir");
+        else
+            mapArgs["-datadir"] = strDataDirOld;
+        ClearDatadirCache();
+        boost::filesystem::remove_all(pathTemp);
+    }
+
+    uintmax_t FileSize(const CDiskBlockPos& pos, const char* prefix) {
+        return boost::filesystem::file_size(GetBlockPosFilename(pos, prefix));
+    }
+
+    /** Read the record whose data starts at pos, as Append left it. */
+    std::string ReadRecord(const CDiskBlockPos& pos, const char* prefix) {
+        FILE* file = fopen(GetBlockPosFilename(pos, prefix).string().c_str(), "rb");
+        if (file == NULL) {
+            ADD_FAILURE() << "can't open " << GetBlockPosFilename(pos, prefix).string();
+            return std::string();
+        }
+        EXPECT_EQ(0, fseek(file, pos.nPos - MESSAGE_START_SIZE - sizeof(uint32_t), SEEK_SET));
+        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+        CMessageHeader::MessageStartChars start;
+        uint32_t nSize;
+        std::string str;
+        filein >> FLATDATA(start) >> nSize >> str;
+        EXPECT_EQ(0, memcmp(start, messageStart, MESSAGE_START_SIZE));
+        EXPECT_EQ(::GetSerializeSize(str, SER_DISK, CLIENT_VERSION), nSize);
+        return str;
+    }
+
+    static unsigned int RecordSize(const std::string& str) {
+        return MESSAGE_START_SIZE + sizeof(uint32_t) + ::GetSerializeSize(str, SER_DISK, CLIENT_VERSION);
+    }
+};
+
+TEST_F(BlockFileAppenderTest, AppendsInOrderAndAfterSeek) {
+    CBlockFileAppender appender;
+    std::string a("first"), b("second"), c("after a gap");
+
+    CDiskBlockPos posA(0, 0);
+    ASSERT_TRUE(appender.Append(posA, "blk", messageStart, a));
+    EXPECT_EQ(MESSAGE_START_SIZE + sizeof(uint32_t), posA.nPos);
+    CDiskBlockPos posB(0, RecordSize(a));
+    ASSERT_TRUE(appender.Append(posB, "blk", messageStart, b));
+    CDiskBlockPos posC(0, RecordSize(a) + RecordSize(b) + 1000);
+    ASSERT_TRUE(appender.Append(posC, "blk", messageStart, c));
+    EXPECT_EQ(1U, appender.Count());
+
+    ASSERT_TRUE(appender.CloseAll());
+    EXPECT_EQ(0U, appender.Count());
+    EXPECT_EQ(RecordSize(a) + RecordSize(b) + 1000 + RecordSize(c), FileSize(posA, "blk"));
+    EXPECT_EQ(a, ReadRecord(posA, "blk"));
+    EXPECT_EQ(b, ReadRecord(posB, "blk"));
+    EXPECT_EQ(c, ReadRecord(posC, "blk"));
+}
+
+TEST_F(BlockFileAppenderTest, ReadsBackWhileBuffered) {
+    std::string str("buffered");
+    CDiskBlockPos pos(0, 0);
+    ASSERT_TRUE(blockFileAppender.Append(pos, "blk", messageStart, str));
+    EXPECT_EQ(0U, FileSize(pos, "blk"));
+
+    // Opening the file hands the buffer to the OS
+    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+    ASSERT_FALSE(filein.IsNull());
+    std::string strRead;
+    filein >> strRead;
+    EXPECT_EQ(str, strRead);
+    EXPECT_EQ(RecordSize(str), FileSize(pos, "blk"));
+}
+
+TEST_F(BlockFileAppenderTest, CommitsOlderRevFile) {
+    CBlockFileAppender appender;
+    std::string undo("undo"), block("block");
+
+    CDiskBlockPos posUndoOld(0, 0);
+    ASSERT_TRUE(appender.Append(posUndoOld, "rev", messageStart, undo));
+    ASSERT_TRUE(appender.Commit());
+
+    CDiskBlockPos posBlock(1, 0);
+    ASSERT_TRUE(appender.Append(posBlock, "blk", messageStart, block));
+    // Undo data of a block in an older file goes to that file's rev file
+    CDiskBlockPos posUndo(0, RecordSize(undo));
+    ASSERT_TRUE(appender.Append(posUndo, "rev", messageStart, undo));
+    EXPECT_EQ(RecordSize(undo), FileSize(posUndo, "rev"));
+
+    ASSERT_TRUE(appender.Commit());
+    EXPECT_EQ(2 * RecordSize(undo), FileSize(posUndo, "rev"));
+    EXPECT_EQ(RecordSize(block), FileSize(posBlock, "blk"));
+    EXPECT_EQ(undo, ReadRecord(posUndo, "rev"));
+    EXPECT_EQ(2U, appender.Count());
+}
+
+TEST_F(BlockFileAppenderTest, ClosesBeforeTruncation) {
+    CBlockFileAppender appender;
+    std::string keep("kept"), drop("dropped"), next("next");
+
+    CDiskBlockPos posKeep(0, 0);
+    ASSERT_TRUE(appender.Append(posKeep, "blk", messageStart, keep));
+    CDiskBlockPos posDrop(0, RecordSize(keep));
+    ASSERT_TRUE(appender.Append(posDrop, "blk", messageStart, drop));
+    ASSERT_TRUE(appender.Close(posKeep, "blk"));
+    EXPECT_EQ(0U, appender.Count());
+    EXPECT_EQ(RecordSize(keep) + RecordSize(drop), FileSize(posKeep, "blk"));
+
+    // Nothing buffered is left to extend the file again after truncating it
+    FILE* file = OpenBlockFile(CDiskBlockPos(0, 0));
+    ASSERT_TRUE(file != NULL);
+    ASSERT_TRUE(TruncateFile(file, RecordSize(keep)));
+    fclose(file);
+    EXPECT_EQ(RecordSize(keep), FileSize(posKeep, "blk"));
+
+    CDiskBlockPos posNext(0, RecordSize(keep));
+    ASSERT_TRUE(appender.Append(posNext, "blk", messageStart, next));
+    ASSERT_TRUE(appender.CloseAll());
+    EXPECT_EQ(RecordSize(keep) + RecordSize(next), FileSize(posKeep, "blk"));
+    EXPECT_EQ(keep, ReadRecord(posKeep, "blk"));
+    EXPECT_EQ(next, ReadRecord(posNext, "blk"));
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "blockfilemap.h"
+#include "clientversion.h"
+#include "streams.h"
+#include "uint256.h"
+#include "version.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+class BlockFileMapTest : public ::testing::Test {
+protected:
+    boost::filesystem::path pathTemp;
+
+    virtual void SetUp() {
+        pathTemp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::create_directories(pathTemp);
+    }
+
+    virtual void TearDown() {
+        boost::filesystem::remove_all(pathTemp);
+    }
+
+    boost::filesystem::path WriteFile(const std::string& name, const CPlainDataStream& ss) {
+        boost::filesystem::path path = pathTemp / name;
+        boost::filesystem::ofstream file(path, std::ios::binary);
+        file.write(&ss[0], ss.size());
+        return path;
+    }
+};
+
+#ifndef WIN32
+TEST_F(BlockFileMapTest, DeserializesFromMapping) {
+    CPlainDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << std::string("block") << uint256S("0x1234") << (uint32_t)42;
+    boost::filesystem::path path = WriteFile("blk00000.dat", ss);
+
+    CBlockFileMapCache cache(2);
+    CBlockFileMapCache::Mapping mapping = cache.Get(path);
+    ASSERT_TRUE(mapping);
+    EXPECT_EQ(ss.size(), mapping->size());
+    EXPECT_EQ(mapping, cache.Get(path));
+
+    std::string str;
+    uint256 hash;
+    uint32_t n;
+    CMemoryReader reader(mapping->data(), mapping->data() + mapping->size(), SER_DISK, CLIENT_VERSION);
+    reader >> str >> hash >> n;
+    EXPECT_EQ("block", str);
+    EXPECT_EQ(uint256S("0x1234"), hash);
+    EXPECT_EQ(42, n);
+    EXPECT_TRUE(reader.empty());
+    EXPECT_THROW(reader >> n, std::ios_base::failure);
+}
+
+TEST_F(BlockFileMapTest, BoundsOpenMappings) {
+    CPlainDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << (uint32_t)1;
+    boost::filesystem::path a = WriteFile("blk00000.dat", ss);
+    boost::filesystem::path b = WriteFile("blk00001.dat", ss);
+    boost::filesystem::path c = WriteFile("blk00002.dat", ss);
+
+    CBlockFileMapCache cache(2);
+    CBlockFileMapCache::Mapping held = cache.Get(a);
+    cache.Get(b);
+    cache.Get(a);
+    cache.Get(c);
+    EXPECT_EQ(2, cache.Count());
+
+    // b was least recently used, a is still mapped
+    cache.Erase(a);
+    EXPECT_EQ(1, cache.Count());
+    EXPECT_EQ(ss.size(), held->size());
+    EXPECT_EQ(0, memcmp(held->data(), &ss[0], ss.size()));
+
+    cache.SetMaxMaps(0);
+    EXPECT_EQ(0, cache.Count());
+    EXPECT_FALSE(cache.Get(a));
+}
+#endif
+
+TEST_F(BlockFileMapTest, MissingOrEmptyFilesAreNotMapped) {
+    CBlockFileMapCache cache(2);
+    EXPECT_FALSE(cache.Get(pathTemp / "blk00000.dat"));
+    EXPECT_FALSE(cache.Get(WriteFile("rev00000.dat", CPlainDataStream(SER_DISK, CLIENT_VERSION))));
+    EXPECT_EQ(0, cache.Count());
+}
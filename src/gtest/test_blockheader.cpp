@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include "crypto/verus_hash.h"
+#include "primitives/block.h"
+#include "uint256.h"
+
+static CBlockHeader MakeHeader(uint32_t nTime)
+{
+    CBlockHeader header;
+    header.hashPrevBlock = uint256S("0x1234");
+    header.hashMerkleRoot = uint256S("0x5678");
+    header.nTime = nTime;
+    header.nBits = 0x200f0f0f;
+    header.nNonce = uint256S("0x9abc");
+    header.nSolution.assign(1344, 0x42);
+    return header;
+}
+
+// The hash computed from scratch, bypassing the memo
+static uint256 FreshHash(const CBlockHeader& header)
+{
+    return (header.*CBlockHeader::hashFunction)();
+}
+
+TEST(BlockHeaderHash, FollowsMutations) {
+    CBlockHeader header = MakeHeader(1);
+    uint256 hash = header.GetHash();
+    EXPECT_EQ(FreshHash(header), hash);
+    EXPECT_EQ(hash, header.GetHash());
+
+    header.nNonce = uint256S("0x9abd");
+    EXPECT_NE(hash, header.GetHash());
+    EXPECT_EQ(FreshHash(header), header.GetHash());
+
+    hash = header.GetHash();
+    header.nSolution[700] ^= 1;
+    EXPECT_NE(hash, header.GetHash());
+    EXPECT_EQ(FreshHash(header), header.GetHash());
+
+    hash = header.GetHash();
+    header.nTime++;
+    EXPECT_NE(hash, header.GetHash());
+    EXPECT_EQ(FreshHash(header), header.GetHash());
+
+    hash = header.GetHash();
+    header.nSolution.pop_back();
+    EXPECT_NE(hash, header.GetHash());
+    EXPECT_EQ(FreshHash(header), header.GetHash());
+}
+
+TEST(BlockHeaderHash, CopiesShareTheMemo) {
+    CBlock block(MakeHeader(1));
+    uint256 hash = block.GetHash();
+
+    CBlockHeader copy = block.GetBlockHeader();
+    EXPECT_EQ(hash, copy.GetHash());
+
+    // Changing the copy doesn't affect the original
+    copy.nNonce = uint256S("0xdef0");
+    EXPECT_EQ(FreshHash(copy), copy.GetHash());
+    EXPECT_EQ(hash, block.GetHash());
+}
+
+TEST(BlockHeaderHash, FollowsHashFunction) {
+    CBlockHeader header = MakeHeader(1);
+    uint256 hashSHA256D = header.GetHash();
+
+    CVerusHash::init();
+    CBlockHeader::SetVerusHash();
+    uint256 hashVerus = header.GetHash();
+    CBlockHeader::SetSHA256DHash();
+
+    EXPECT_NE(hashSHA256D, hashVerus);
+    EXPECT_EQ(header.GetVerusHash(), hashVerus);
+    EXPECT_EQ(hashSHA256D, header.GetHash());
+}
+
+TEST(BlockHeaderHash, PrecomputeHashes) {
+    for (int nThreads : {0, 1, 4}) {
+        std::vector<CBlockHeader> headers;
+        for (uint32_t i = 0; i < 100; i++)
+            headers.push_back(MakeHeader(i));
+
+        CBlockHeader::PrecomputeHashes(headers, nThreads);
+        for (const CBlockHeader& header : headers) {
+            EXPECT_EQ(FreshHash(header), header.GetHash());
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include "chain.h"
+#include "crypto/verus_hash.h"
+#include "primitives/block.h"
+
+TEST(BlockIndexArena, AllocatesAcrossChunks) {
+    CBlockIndexArena arena;
+    EXPECT_EQ(0u, arena.Size());
+
+    CBlockHeader header;
+    header.nTime = 1234;
+    header.nBits = 0x200f0f0f;
+    header.nSolution.assign(32, 0x42);
+
+    std::vector<CBlockIndex*> entries;
+    size_t nEntries = 2 * CBlockIndexArena::ENTRIES_PER_CHUNK + 10;
+    for (size_t i = 0; i < nEntries; i++) {
+        CBlockIndex* pindex = (i % 2) ? arena.Allocate(header) : arena.Allocate();
+        pindex->nHeight = i;
+        pindex->pprev = entries.empty() ? NULL : entries.back();
+        entries.push_back(pindex);
+    }
+    EXPECT_EQ(nEntries, arena.Size());
+
+    for (size_t i = 0; i < nEntries; i++) {
+        EXPECT_EQ((int)i, entries[i]->nHeight);
+        EXPECT_EQ(i ? entries[i - 1] : NULL, entries[i]->pprev);
+        EXPECT_EQ(-1, entries[i]->nPoWClass);
+        EXPECT_EQ((i % 2) ? 1234u : 0u, entries[i]->nTime);
+        EXPECT_EQ((i % 2) ? 32u : 0u, entries[i]->nSolution.size());
+    }
+
+    // Entries within a chunk are contiguous
+    EXPECT_EQ(entries[0] + 1, entries[1]);
+
+    arena.Clear();
+    EXPECT_EQ(0u, arena.Size());
+    CBlockIndex* pindex = arena.Allocate(header);
+    EXPECT_EQ(1u, arena.Size());
+    EXPECT_EQ(1234u, pindex->nTime);
+}
+
+TEST(BlockIndex, VerusPOSFromNonce) {
+    CVerusHash::init();
+
+    CBlockHeader header;
+    header.nNonce = uint256S("0x9abc");
+    CBlockIndex indexPoW(header);
+    EXPECT_FALSE(indexPoW.IsVerusPOSBlock());
+    EXPECT_EQ(header.IsVerusPOSBlock(), indexPoW.IsVerusPOSBlock());
+
+    header.SetVerusPOSTarget(0x1d00ffff);
+    ASSERT_TRUE(header.IsVerusPOSBlock());
+    CBlockIndex indexPoS(header);
+    EXPECT_TRUE(indexPoS.IsVerusPOSBlock());
+    EXPECT_TRUE(indexPoS.IsVerusPOSBlock());
+    EXPECT_EQ(header.GetVerusPOSTarget(), indexPoS.GetVerusPOSTarget());
+}
@@ -60,3 +60,26 @@ TEST(HTTPRPC, FailsWithBadAuth) {
     EXPECT_FALSE(HTTPReq_JSONRPC(&req, ""));
     req.CleanUp();
 }
+
+TEST(HTTPRPC, MethodPriority) {
+    mapMultiArgs["-rpcmethodclass"] = {"getblock:low", "getaddressutxos:normal"};
+    ASSERT_TRUE(InitRPCMethodPriorities());
+
+    EXPECT_EQ(HTTP_PRIORITY_HIGH, RPCMethodPriority("{\"jsonrpc\":\"1.0\",\"id\":1,\"method\":\"getblockcount\",\"params\":[]}"));
+    EXPECT_EQ(HTTP_PRIORITY_HIGH, RPCMethodPriority("{\"method\" : \"getblocktemplate\", \"params\":[]}"));
+    EXPECT_EQ(HTTP_PRIORITY_NORMAL, RPCMethodPriority("{\"method\":\"getrawtransaction\",\"params\":[\"00\"]}"));
+    EXPECT_EQ(HTTP_PRIORITY_LOW, RPCMethodPriority("{\"method\":\"getaddressdeltas\",\"params\":[]}"));
+    EXPECT_EQ(HTTP_PRIORITY_LOW, RPCMethodPriority("{\"method\":\"getblock\",\"params\":[\"1\"]}"));
+    EXPECT_EQ(HTTP_PRIORITY_NORMAL, RPCMethodPriority("{\"method\":\"getaddressutxos\",\"params\":[]}"));
+
+    // A batch is queued according to its most expensive call
+    EXPECT_EQ(HTTP_PRIORITY_LOW, RPCMethodPriority("[{\"method\":\"getinfo\"},{\"method\":\"getaddresstxids\"}]"));
+    EXPECT_EQ(HTTP_PRIORITY_HIGH, RPCMethodPriority("[{\"method\":\"getinfo\"},{\"method\":\"ping\"}]"));
+
+    // Unparseable bodies fall back to the default class
+    EXPECT_EQ(HTTP_PRIORITY_NORMAL, RPCMethodPriority(""));
+    EXPECT_EQ(HTTP_PRIORITY_NORMAL, RPCMethodPriority("{\"method\":"));
+
+    mapMultiArgs.erase("-rpcmethodclass");
+    ASSERT_TRUE(InitRPCMethodPriorities());
+}
@@ -4,6 +4,8 @@
 
 #include <boost/foreach.hpp>
 
+#include <thread>
+
 #include "zcash/prf.h"
 #include "util.h"
 
@@ -510,6 +512,79 @@ TEST(joinsplit, full_api_test)
     test_full_api(params);
 }
 
+// A JoinSplit can spend the output of another one whose proof has not been
+// generated yet, and both proofs can then be generated concurrently.
+TEST(joinsplit, deferred_proof)
+{
+    auto verifier = libzcash::ProofVerifier::Strict();
+    uint256 pubKeyHash = random_uint256();
+    SpendingKey key = SpendingKey::random();
+    PaymentAddress addr = key.address();
+    ZCIncrementalMerkleTree tree;
+
+    struct Public {
+        uint256 rt;
+        uint256 ephemeralKey;
+        uint256 randomSeed;
+        boost::array<uint256, 2> macs;
+        boost::array<uint256, 2> nullifiers;
+        boost::array<uint256, 2> commitments;
+        boost::array<ZCNoteEncryption::Ciphertext, 2> ciphertexts;
+        boost::array<Note, 2> notes;
+        uint64_t vpub_old;
+        uint64_t vpub_new;
+    } js[2];
+    ZCJSProofWitness witness[2];
+
+    // Shield 10 into a note for key
+    {
+        boost::array<JSInput, 2> inputs = {JSInput(), JSInput()};
+        boost::array<JSOutput, 2> outputs = {JSOutput(addr, 10), JSOutput()};
+        js[0].rt = tree.root();
+        js[0].vpub_old = 10;
+        js[0].vpub_new = 0;
+        ZCProof proof = params->prove(inputs, outputs, js[0].notes, js[0].ciphertexts,
+            js[0].ephemeralKey, pubKeyHash, js[0].randomSeed, js[0].macs,
+            js[0].nullifiers, js[0].commitments, js[0].vpub_old, js[0].vpub_new,
+            js[0].rt, false, nullptr, &witness[0]);
+        ASSERT_TRUE(proof == ZCProof());
+    }
+
+    // Spend it again before the first proof exists
+    tree.append(js[0].commitments[0]);
+    ZCIncrementalWitness w = tree.witness();
+    tree.append(js[0].commitments[1]);
+    w.append(js[0].commitments[1]);
+    {
+        boost::array<JSInput, 2> inputs = {JSInput(w, js[0].notes[0], key), JSInput()};
+        boost::array<JSOutput, 2> outputs = {JSOutput(), JSOutput()};
+        js[1].rt = tree.root();
+        js[1].vpub_old = 0;
+        js[1].vpub_new = 10;
+        params->prove(inputs, outputs, js[1].notes, js[1].ciphertexts,
+            js[1].ephemeralKey, pubKeyHash, js[1].randomSeed, js[1].macs,
+            js[1].nullifiers, js[1].commitments, js[1].vpub_old, js[1].vpub_new,
+            js[1].rt, false, nullptr, &witness[1]);
+    }
+
+    ZCProof proofs[2];
+    std::thread t0([&]() { proofs[0] = params->prove(witness[0]); });
+    std::thread t1([&]() { proofs[1] = params->prove(witness[1]); });
+    t0.join();
+    t1.join();
+
+    for (int i = 0; i < 2; i++) {
+        ASSERT_TRUE(params->verify(proofs[i], verifier, pubKeyHash, js[i].randomSeed,
+            js[i].macs, js[i].nullifiers, js[i].commitments,
+            js[i].vpub_old, js[i].vpub_new, js[i].rt));
+    }
+
+    // The proofs are bound to their own JoinSplit
+    ASSERT_FALSE(params->verify(proofs[0], verifier, pubKeyHash, js[1].randomSeed,
+        js[1].macs, js[1].nullifiers, js[1].commitments,
+        js[1].vpub_old, js[1].vpub_new, js[1].rt));
+}
+
 TEST(joinsplit, note_plaintexts)
 {
     uint252 a_sk = uint252(uint256S("f6da8716682d600f74fc16bd0187faad6a26b4aa4c24d5c055b216d94516840e"));
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include "chainparams.h"
+#include "main.h"
+#include "primitives/block.h"
+#include "txdb.h"
+#include "util.h"
+#include "utilstrencodings.h"
+
+#include <boost/filesystem.hpp>
+
+int32_t komodo_block2pubkey33(uint8_t *pubkey33,CBlock *block);
+
+static const std::string strMinerPubKey = "03a34b99f22c790c4e36b2b3c2c35a36db06226e41c692fc82b8b56ac1c540c5bd";
+
+class MinerPubKeyTest : public ::testing::Test {
+protected:
+    boost::filesystem::path pathTemp;
+    std::string strDataDirOld;
+    CBlockTreeDB* pblocktreeOld;
+
+    virtual void SetUp() {
+        SelectParams(CBaseChainParams::MAIN);
+        pathTemp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::create_directories(pathTemp);
+        strDataDirOld = GetArg("-datadir", "");
+        mapArgs["-datadir"] = pathTemp.string();
+        ClearDatadirCache();
+        pblocktreeOld = pblocktree;
+    }
+
+    virtual void TearDown() {
+        pblocktree = pblocktreeOld;
+        blockFileAppender.CloseAll();
+        if (strDataDirOld.empty())
+            mapArgs.erase("-datadir");
+        else
+            mapArgs["-datadir"] = strDataDirOld;
+        ClearDatadirCache();
+        boost::filesystem::remove_all(pathTemp);
+    }
+
+    /** A block whose coinbase pays the miner's pubkey, like a notary's. */
+    static CBlock MinerBlock() {
+        CMutableTransaction coinbase;
+        coinbase.vin.resize(1);
+        coinbase.vin[0].prevout.SetNull();
+        coinbase.vout.push_back(CTxOut(3 * COIN, CScript() << ParseHex(strMinerPubKey) << OP_CHECKSIG));
+        CBlock block;
+        block.vtx.push_back(coinbase);
+        block.hashMerkleRoot = block.BuildMerkleTree();
+        return block;
+    }
+};
+
+TEST_F(MinerPubKeyTest, RoundTripsThroughBlockTree) {
+    CBlockTreeDB db(1 << 20, true);
+    CBlock block = MinerBlock();
+    uint256 hash = block.GetHash();
+    CBlockIndex index(block);
+    index.phashBlock = &hash;
+
+    // What AcceptBlock keeps
+    komodo_block2pubkey33(index.minerPubKey33, &block);
+    index.fMinerPubKey = true;
+    EXPECT_EQ(strMinerPubKey, HexStr(index.minerPubKey33, index.minerPubKey33 + 33));
+
+    std::vector<std::pair<int, const CBlockFileInfo*> > vFiles;
+    std::vector<const CBlockIndex*> vBlocks(1, &index);
+    ASSERT_TRUE(db.WriteBatchSync(vFiles, 0, vBlocks));
+    std::vector<unsigned char> vch;
+    ASSERT_TRUE(db.ReadMinerPubKey(hash, vch));
+    EXPECT_EQ(ParseHex(strMinerPubKey), vch);
+
+    // Entries without a pubkey don't get a record
+    CBlock block2 = MinerBlock();
+    block2.nTime = 1;
+    uint256 hash2 = block2.GetHash();
+    CBlockIndex index2(block2);
+    index2.phashBlock = &hash2;
+    vBlocks.assign(1, &index2);
+    ASSERT_TRUE(db.WriteBatchSync(vFiles, 0, vBlocks));
+    EXPECT_FALSE(db.ReadMinerPubKey(hash2, vch));
+}
+
+TEST_F(MinerPubKeyTest, ReadsOlderEntriesBlockOnce) {
+    CBlockTreeDB db(1 << 20, true);
+    pblocktree = &db;
+
+    CBlock block = MinerBlock();
+    CDiskBlockPos pos(0, 0);
+    ASSERT_TRUE(WriteBlockToDisk(block, pos, Params().MessageStart()));
+    uint256 hash = block.GetHash();
+    CBlockIndex index(block);
+    index.phashBlock = &hash;
+    index.nFile = pos.nFile;
+    index.nDataPos = pos.nPos;
+    index.nStatus |= BLOCK_HAVE_DATA;
+
+    // Indexed by a version that didn't keep the pubkey
+    std::vector<unsigned char> vch;
+    ASSERT_FALSE(index.fMinerPubKey);
+    ASSERT_FALSE(db.ReadMinerPubKey(hash, vch));
+
+    uint8_t pubkey33[33];
+    ASSERT_TRUE(GetBlockMinerPubKey(&index, pubkey33));
+    EXPECT_EQ(strMinerPubKey, HexStr(pubkey33, pubkey33 + 33));
+    EXPECT_TRUE(index.fMinerPubKey);
+    ASSERT_TRUE(db.ReadMinerPubKey(hash, vch));
+    EXPECT_EQ(ParseHex(strMinerPubKey), vch);
+
+    // Once the record is written the block isn't needed any more
+    boost::filesystem::remove(GetBlockPosFilename(pos, "blk"));
+    memset(pubkey33, 0, sizeof(pubkey33));
+    ASSERT_TRUE(GetBlockMinerPubKey(&index, pubkey33));
+    EXPECT_EQ(strMinerPubKey, HexStr(pubkey33, pubkey33 + 33));
+
+    index.fMinerPubKey = false;
+    memset(index.minerPubKey33, 0, sizeof(index.minerPubKey33));
+    ASSERT_TRUE(GetBlockMinerPubKey(&index, pubkey33));
+    EXPECT_EQ(strMinerPubKey, HexStr(pubkey33, pubkey33 + 33));
+
+    // Without the record or the block there is nothing to go on
+    CBlock block2 = MinerBlock();
+    block2.nTime = 1;
+    uint256 hash2 = block2.GetHash();
+    CBlockIndex index2(block2);
+    index2.phashBlock = &hash2;
+    EXPECT_FALSE(GetBlockMinerPubKey(&index2, pubkey33));
+}
@@ -68,3 +68,21 @@ TEST(PoW, DifficultyAveraging) {
                                         params),
               GetNextWorkRequired(&blocks[lastBlk], nullptr, params));
 }
+
+TEST(PoW, CheckEquihashSolutions) {
+    SelectParams(CBaseChainParams::MAIN);
+    CBlockHeader header = Params().GenesisBlock().GetBlockHeader();
+    ASSERT_TRUE(CheckEquihashSolution(&header, Params()));
+
+    std::vector<CBlockHeader> headers(9, header);
+    headers[5].nSolution[0] ^= 1;
+    EXPECT_EQ(8, CheckEquihashSolutions(headers, Params(), 3));
+
+    // Valid solutions are picked up by the single checks, failures are not
+    // remembered and get checked again
+    EXPECT_TRUE(CheckEquihashSolution(&headers[0], Params()));
+    EXPECT_FALSE(CheckEquihashSolution(&headers[5], Params()));
+
+    // Don't leave the genesis header remembered for other tests
+    ForgetVerifiedEquihashSolutions();
+}
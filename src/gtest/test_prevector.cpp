@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include "prevector.h"
+#include "script/script.h"
+#include "serialize.h"
+#include "streams.h"
+#include "version.h"
+
+#include <vector>
+
+typedef prevector<8, int> small_vector;
+
+static void ExpectSame(const std::vector<int>& expected, const small_vector& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(expected[i], actual[i]);
+    }
+    EXPECT_EQ(expected.empty(), actual.empty());
+    EXPECT_EQ(expected.size(), (size_t)(actual.end() - actual.begin()));
+}
+
+TEST(Prevector, MatchesVectorAcrossInlineLimit) {
+    std::vector<int> expected;
+    small_vector actual;
+
+    for (int i = 0; i < 20; i++) {
+        expected.push_back(i);
+        actual.push_back(i);
+        ExpectSame(expected, actual);
+    }
+    EXPECT_GT(actual.allocated_memory(), 0u);
+
+    expected.insert(expected.begin() + 3, 5, -1);
+    actual.insert(actual.begin() + 3, 5u, -1);
+    ExpectSame(expected, actual);
+
+    expected.erase(expected.begin() + 1, expected.begin() + 20);
+    actual.erase(actual.begin() + 1, actual.begin() + 20);
+    ExpectSame(expected, actual);
+
+    // Erasing keeps the heap buffer until asked to shrink
+    actual.shrink_to_fit();
+    ExpectSame(expected, actual);
+    EXPECT_EQ(0u, actual.allocated_memory());
+
+    expected.resize(12);
+    actual.resize(12);
+    ExpectSame(expected, actual);
+
+    small_vector copy(actual);
+    ExpectSame(expected, copy);
+    small_vector other(3u, 7);
+    copy.swap(other);
+    ExpectSame(std::vector<int>(3, 7), copy);
+    ExpectSame(expected, other);
+
+    expected.clear();
+    actual.clear();
+    ExpectSame(expected, actual);
+}
+
+TEST(Prevector, OrdersLikeVector) {
+    std::vector<int> a = {1, 2, 3}, b = {1, 3};
+    small_vector pa(a.begin(), a.end()), pb(b.begin(), b.end());
+    EXPECT_EQ(a < b, pa < pb);
+    EXPECT_EQ(b < a, pb < pa);
+    EXPECT_FALSE(pa < pa);
+    EXPECT_TRUE(pa == small_vector(a.begin(), a.end()));
+    EXPECT_TRUE(pa != pb);
+}
+
+TEST(Prevector, ScriptSerializesLikeVector) {
+    for (size_t nSize : {0, 1, 25, 28, 29, 107, 300}) {
+        std::vector<unsigned char> data(nSize);
+        for (size_t i = 0; i < nSize; i++) {
+            data[i] = i;
+        }
+        CScript script(data.begin(), data.end());
+        EXPECT_EQ(nSize <= 28, script.allocated_memory() == 0);
+
+        CDataStream ssScript(SER_NETWORK, PROTOCOL_VERSION);
+        ssScript << script;
+        CDataStream ssData(SER_NETWORK, PROTOCOL_VERSION);
+        ssData << data;
+        EXPECT_EQ(ssData.str(), ssScript.str());
+        EXPECT_EQ(ssData.size(), ::GetSerializeSize(script, SER_NETWORK, PROTOCOL_VERSION));
+
+        CScript result;
+        ssScript >> result;
+        EXPECT_TRUE(result == script);
+    }
+}
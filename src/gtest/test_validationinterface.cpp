@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include "chain.h"
+#include "primitives/block.h"
+#include "validationinterface.h"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+class OrderRecorder : public CValidationInterface
+{
+public:
+    std::mutex cs;
+    std::vector<int> heights;
+    std::vector<uint256> blockHashes;
+    int nDelayMs = 0;
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindex) {
+        if (nDelayMs) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(nDelayMs));
+        }
+        std::lock_guard<std::mutex> lock(cs);
+        heights.push_back(pindex->nHeight);
+    }
+
+    void SyncTransaction(const CTransaction &tx, const CBlock *pblock) {
+        std::lock_guard<std::mutex> lock(cs);
+        blockHashes.push_back(pblock ? pblock->GetHash() : uint256());
+    }
+};
+
+TEST(ValidationInterfaceQueue, CallbacksRunInOrderBeforeBarrier) {
+    OrderRecorder recorder;
+    recorder.nDelayMs = 1;
+    StartValidationInterfaceQueue(5);
+    RegisterAsyncValidationInterface(&recorder);
+
+    std::vector<CBlockIndex> indices(20);
+    for (size_t i = 0; i < indices.size(); i++) {
+        indices[i].nHeight = i;
+        LimitValidationInterfaceQueue();
+        EXPECT_LE(ValidationInterfaceQueueSize(), 5u);
+        GetMainSignals().UpdatedBlockTip(&indices[i]);
+    }
+    SyncWithValidationInterfaceQueue();
+    EXPECT_EQ(0u, ValidationInterfaceQueueSize());
+    {
+        std::lock_guard<std::mutex> lock(recorder.cs);
+        ASSERT_EQ(indices.size(), recorder.heights.size());
+        for (size_t i = 0; i < indices.size(); i++) {
+            EXPECT_EQ((int)i, recorder.heights[i]);
+        }
+    }
+
+    UnregisterValidationInterface(&recorder);
+    StopValidationInterfaceQueue();
+}
+
+TEST(ValidationInterfaceQueue, ListenersSeeACopyOfTheBlock) {
+    OrderRecorder recorder;
+    StartValidationInterfaceQueue();
+    RegisterAsyncValidationInterface(&recorder);
+
+    uint256 hash;
+    {
+        CBlock block;
+        block.nTime = 1234;
+        block.vtx.resize(3);
+        hash = block.GetHash();
+        for (const CTransaction& tx : block.vtx) {
+            SyncWithWallets(tx, &block);
+        }
+        block.SetNull();
+    }
+    SyncWithValidationInterfaceQueue();
+    {
+        std::lock_guard<std::mutex> lock(recorder.cs);
+        ASSERT_EQ(3u, recorder.blockHashes.size());
+        for (const uint256& blockHash : recorder.blockHashes) {
+            EXPECT_EQ(hash, blockHash);
+        }
+    }
+
+    UnregisterValidationInterface(&recorder);
+    StopValidationInterfaceQueue();
+
+    // Without the queue running, listeners are called synchronously
+    RegisterAsyncValidationInterface(&recorder);
+    CBlockIndex index;
+    index.nHeight = 7;
+    GetMainSignals().UpdatedBlockTip(&index);
+    {
+        std::lock_guard<std::mutex> lock(recorder.cs);
+        ASSERT_EQ(1u, recorder.heights.size());
+        EXPECT_EQ(7, recorder.heights[0]);
+    }
+    UnregisterValidationInterface(&recorder);
+}
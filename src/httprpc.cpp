@@ -11,7 +11,10 @@
 #include "utilstrencodings.h"
 #include "ui_interface.h"
 
+#include <map>
+
 #include <boost/algorithm/string.hpp> // boost::trim
+#include <boost/foreach.hpp>
 
 // WWW-Authenticate to present with 401 Unauthorized response
 static const char *WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
@@ -87,6 +90,97 @@ static bool RPCAuthorized(const std::string& strAuth)
     return TimingResistantEqual(strUserPass, strRPCUserColonPass);
 }
 
+/** Methods that must stay responsive under load: health checks and mining. */
+static const char* const rpcHighPriorityMethods[] = {
+    "getbestblockhash", "getblockcount", "getblockhash", "getblocktemplate",
+    "getconnectioncount", "getinfo", "getmininginfo", "getnetworkinfo",
+    "getrpcqueueinfo", "help", "ping", "stop", "submitblock",
+};
+
+/** Methods that can run for a long time, mostly index scans and full wallet walks. */
+static const char* const rpcLowPriorityMethods[] = {
+    "getaddressbalance", "getaddressdeltas", "getaddressmempool", "getaddresstxids",
+    "getaddressutxos", "getblockdeltas", "getblockhashes", "getchaintips",
+    "gettxoutsetinfo", "verifychain", "allMoMs", "kvsearch",
+    "dumpwallet", "importwallet", "z_exportwallet", "z_importwallet",
+    "importprivkey", "importaddress", "z_importkey", "z_importviewingkey",
+    "listtransactions", "listsinceblock", "listunspent", "listreceivedbyaddress",
+    "z_getbalance", "z_gettotalbalance", "z_listreceivedbyaddress", "z_listunspent",
+};
+
+static std::map<std::string, HTTPRequestPriority> mapRPCMethodPriority;
+
+static bool InitRPCMethodPriorities()
+{
+    mapRPCMethodPriority.clear();
+    BOOST_FOREACH(const char* strMethod, rpcHighPriorityMethods)
+        mapRPCMethodPriority[strMethod] = HTTP_PRIORITY_HIGH;
+    BOOST_FOREACH(const char* strMethod, rpcLowPriorityMethods)
+        mapRPCMethodPriority[strMethod] = HTTP_PRIORITY_LOW;
+
+    // -rpcmethodclass=<method>:<high|normal|low> overrides the defaults
+    BOOST_FOREACH(const std::string& strArg, mapMultiArgs["-rpcmethodclass"]) {
+        size_t nSep = strArg.find(':');
+        std::string strClass = nSep == std::string::npos ? "" : strArg.substr(nSep + 1);
+        HTTPRequestPriority priority;
+        if (strClass == "high")
+            priority = HTTP_PRIORITY_HIGH;
+        else if (strClass == "normal")
+            priority = HTTP_PRIORITY_NORMAL;
+        else if (strClass == "low")
+            priority = HTTP_PRIORITY_LOW;
+        else {
+            uiInterface.ThreadSafeMessageBox(
+                strprintf("Invalid -rpcmethodclass specification: %s. Expected <method>:<high|normal|low>.", strArg),
+                "", CClientUIInterface::MSG_ERROR);
+            return false;
+        }
+        mapRPCMethodPriority[strArg.substr(0, nSep)] = priority;
+    }
+    return true;
+}
+
+/** Return the priority class of a JSON-RPC request body without parsing it.
+ * For batches the lowest class of any contained call wins, so a batch cannot
+ * be used to smuggle expensive calls into a fast lane.
+ */
+static HTTPRequestPriority RPCMethodPriority(const std::string& strBody)
+{
+    HTTPRequestPriority priority = HTTP_PRIORITY_HIGH;
+    bool fFound = false;
+    size_t nPos = 0;
+    while ((nPos = strBody.find("\"method\"", nPos)) != std::string::npos) {
+        nPos += 8;
+        while (nPos < strBody.size() && isspace(strBody[nPos]))
+            nPos++;
+        if (nPos >= strBody.size() || strBody[nPos] != ':')
+            continue;
+        nPos++;
+        while (nPos < strBody.size() && isspace(strBody[nPos]))
+            nPos++;
+        if (nPos >= strBody.size() || strBody[nPos] != '"')
+            continue;
+        size_t nEnd = strBody.find('"', ++nPos);
+        if (nEnd == std::string::npos)
+            break;
+
+        HTTPRequestPriority methodPriority = HTTP_PRIORITY_NORMAL;
+        std::map<std::string, HTTPRequestPriority>::const_iterator it =
+            mapRPCMethodPriority.find(strBody.substr(nPos, nEnd - nPos));
+        if (it != mapRPCMethodPriority.end())
+            methodPriority = it->second;
+        priority = std::max(priority, methodPriority);
+        fFound = true;
+        nPos = nEnd + 1;
+    }
+    return fFound ? priority : HTTP_PRIORITY_NORMAL;
+}
+
+static HTTPRequestPriority HTTPReq_JSONRPCPriority(HTTPRequest* req, const std::string &)
+{
+    return RPCMethodPriority(req->PeekBody());
+}
+
 static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 {
     // JSONRPC handles only POST
@@ -181,8 +275,10 @@ bool StartHTTPRPC()
     LogPrint("rpc", "Starting HTTP RPC server\n");
     if (!InitRPCAuthentication())
         return false;
+    if (!InitRPCMethodPriorities())
+        return false;
 
-    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
+    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC, HTTPReq_JSONRPCPriority);
 
     assert(EventBase());
     httpRPCTimerInterface = new HTTPRPCTimerInterface(EventBase());
@@ -11,6 +11,7 @@
 #include "rpcprotocol.h" // For HTTP status codes
 #include "sync.h"
 #include "ui_interface.h"
+#include "utiltime.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -34,6 +35,9 @@
 #endif
 #endif
 
+#include <deque>
+#include <map>
+
 #include <boost/algorithm/string/case_conv.hpp> // for to_lower()
 #include <boost/foreach.hpp>
 #include <boost/scoped_ptr.hpp>
@@ -58,20 +62,36 @@ private:
     HTTPRequestHandler func;
 };
 
-/** Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
+/** Work queue for distributing work over multiple threads.
+ * Work items are simply callable objects. Each item is tagged with a
+ * priority class and a client key; every priority class has its own bounded
+ * FIFO, higher classes are always served first, low-priority work may only
+ * occupy a limited number of workers, and a single client may only occupy a
+ * limited number of workers at a time.
  */
 template <typename WorkItem>
 class WorkQueue
 {
 private:
+    struct Entry
+    {
+        WorkItem* item;
+        std::string client;
+        int64_t nEnqueueTime;
+    };
+    typedef std::deque<Entry> Lane;
+
     /** Mutex protects entire object */
     CWaitableCriticalSection cs;
     CConditionVariable cond;
     /* XXX in C++11 we can use std::unique_ptr here and avoid manual cleanup */
-    std::deque<WorkItem*> queue;
+    Lane lanes[HTTP_PRIORITY_COUNT];
+    HTTPWorkQueueLaneStats stats[HTTP_PRIORITY_COUNT];
+    std::map<std::string, int> mapClientRunning;
     bool running;
     size_t maxDepth;
+    int maxLowPriorityRunning;
+    int maxPerClientRunning;
     int numThreads;
 
     /** RAII object to keep track of number of running worker threads */
@@ -92,50 +112,109 @@ private:
         }
     };
 
+    static void Record(std::vector<uint64_t>& hist, int64_t nMicros)
+    {
+        size_t nBucket = 0;
+        while (nBucket + 1 < hist.size() && nMicros >= (1000LL << nBucket))
+            nBucket++;
+        hist[nBucket]++;
+    }
+
+    /** Find the next runnable entry, honouring lane order and concurrency limits.
+     * Must be called with cs held. */
+    bool Pop(int& nLaneRet, Entry& entryRet)
+    {
+        for (int nLane = 0; nLane < HTTP_PRIORITY_COUNT; nLane++) {
+            if (nLane == HTTP_PRIORITY_LOW && stats[nLane].nRunning >= maxLowPriorityRunning)
+                continue;
+            for (typename Lane::iterator it = lanes[nLane].begin(); it != lanes[nLane].end(); ++it) {
+                if (maxPerClientRunning > 0) {
+                    std::map<std::string, int>::const_iterator mi = mapClientRunning.find(it->client);
+                    if (mi != mapClientRunning.end() && mi->second >= maxPerClientRunning)
+                        continue;
+                }
+                nLaneRet = nLane;
+                entryRet = *it;
+                lanes[nLane].erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
 public:
-    WorkQueue(size_t maxDepth) : running(true),
+    WorkQueue(size_t maxDepth, int maxLowPriorityRunning, int maxPerClientRunning) :
+                                 running(true),
                                  maxDepth(maxDepth),
+                                 maxLowPriorityRunning(maxLowPriorityRunning),
+                                 maxPerClientRunning(maxPerClientRunning),
                                  numThreads(0)
     {
+        for (int nLane = 0; nLane < HTTP_PRIORITY_COUNT; nLane++) {
+            stats[nLane].vQueueWaitHist.assign(HTTP_WORKQUEUE_HIST_BUCKETS, 0);
+            stats[nLane].vExecHist.assign(HTTP_WORKQUEUE_HIST_BUCKETS, 0);
+        }
     }
     /*( Precondition: worker threads have all stopped
      * (call WaitExit)
      */
     ~WorkQueue()
     {
-        while (!queue.empty()) {
-            delete queue.front();
-            queue.pop_front();
+        for (int nLane = 0; nLane < HTTP_PRIORITY_COUNT; nLane++) {
+            while (!lanes[nLane].empty()) {
+                delete lanes[nLane].front().item;
+                lanes[nLane].pop_front();
+            }
         }
     }
     /** Enqueue a work item */
-    bool Enqueue(WorkItem* item)
+    bool Enqueue(WorkItem* item, HTTPRequestPriority priority, const std::string& client)
     {
         boost::unique_lock<boost::mutex> lock(cs);
-        if (queue.size() >= maxDepth) {
+        if (lanes[priority].size() >= maxDepth) {
+            stats[priority].nRejected++;
             return false;
         }
-        queue.push_back(item);
-        cond.notify_one();
+        Entry entry;
+        entry.item = item;
+        entry.client = client;
+        entry.nEnqueueTime = GetTimeMicros();
+        lanes[priority].push_back(entry);
+        // Workers may be parked on entries they cannot take; wake them all
+        cond.notify_all();
         return true;
     }
     /** Thread function */
     void Run()
     {
         ThreadCounter count(*this);
-        while (running) {
-            WorkItem* i = 0;
+        while (true) {
+            int nLane = 0;
+            Entry entry;
+            int64_t nStart = 0;
             {
                 boost::unique_lock<boost::mutex> lock(cs);
-                while (running && queue.empty())
+                while (running && !Pop(nLane, entry))
                     cond.wait(lock);
                 if (!running)
                     break;
-                i = queue.front();
-                queue.pop_front();
+                nStart = GetTimeMicros();
+                Record(stats[nLane].vQueueWaitHist, nStart - entry.nEnqueueTime);
+                stats[nLane].nRunning++;
+                mapClientRunning[entry.client]++;
+            }
+            (*entry.item)();
+            delete entry.item;
+            {
+                boost::unique_lock<boost::mutex> lock(cs);
+                Record(stats[nLane].vExecHist, GetTimeMicros() - nStart);
+                stats[nLane].nRunning--;
+                stats[nLane].nProcessed++;
+                if (--mapClientRunning[entry.client] == 0)
+                    mapClientRunning.erase(entry.client);
+                // Finishing may have unblocked a lane or client limit
+                cond.notify_all();
             }
-            (*i)();
-            delete i;
         }
     }
     /** Interrupt and exit loops */
@@ -157,20 +236,36 @@ public:
     size_t Depth()
     {
         boost::unique_lock<boost::mutex> lock(cs);
-        return queue.size();
+        size_t nDepth = 0;
+        for (int nLane = 0; nLane < HTTP_PRIORITY_COUNT; nLane++)
+            nDepth += lanes[nLane].size();
+        return nDepth;
+    }
+
+    /** Return a snapshot of per-lane statistics */
+    std::vector<HTTPWorkQueueLaneStats> GetStats()
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        std::vector<HTTPWorkQueueLaneStats> vStats(stats, stats + HTTP_PRIORITY_COUNT);
+        for (int nLane = 0; nLane < HTTP_PRIORITY_COUNT; nLane++) {
+            vStats[nLane].nDepth = lanes[nLane].size();
+            vStats[nLane].nMaxDepth = maxDepth;
+        }
+        return vStats;
     }
 };
 
 struct HTTPPathHandler
 {
     HTTPPathHandler() {}
-    HTTPPathHandler(std::string prefix, bool exactMatch, HTTPRequestHandler handler):
-        prefix(prefix), exactMatch(exactMatch), handler(handler)
+    HTTPPathHandler(std::string prefix, bool exactMatch, HTTPRequestHandler handler, HTTPRequestClassifier classifier):
+        prefix(prefix), exactMatch(exactMatch), handler(handler), classifier(classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPRequestClassifier classifier;
 };
 
 /** HTTP module state */
@@ -285,9 +380,11 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
+        HTTPRequestPriority priority = i->classifier ? i->classifier(hreq.get(), path) : HTTP_PRIORITY_NORMAL;
+        std::string client = hreq->GetPeer().ToStringIP();
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(hreq.release(), path, i->handler));
         assert(workQueue);
-        if (workQueue->Enqueue(item.get()))
+        if (workQueue->Enqueue(item.get(), priority, client))
             item.release(); /* if true, queue took ownership */
         else
             item->req->WriteReply(HTTP_INTERNAL, "Work queue depth exceeded");
@@ -430,9 +527,15 @@ bool InitHTTPServer()
 
     LogPrint("http", "Initialized HTTP server\n");
     int workQueueDepth = std::max((long)GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
-    LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
-
-    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
+    int rpcThreads = std::max((long)GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
+    int slowThreads = GetArg("-rpcslowthreads", std::max(rpcThreads / 2, 1));
+    // Always leave at least one worker for cheap calls when possible
+    slowThreads = std::max(1, std::min(slowThreads, rpcThreads > 1 ? rpcThreads - 1 : 1));
+    int clientThreads = std::max((long)GetArg("-rpcclientthreads", DEFAULT_HTTP_CLIENT_THREADS), 0L);
+    LogPrintf("HTTP: creating work queue of depth %d per priority class (%d slow workers, %d per client)\n",
+              workQueueDepth, slowThreads, clientThreads);
+
+    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth, slowThreads, clientThreads);
     eventBase = base;
     eventHTTP = http;
     return true;
@@ -560,6 +663,18 @@ std::pair<bool, std::string> HTTPRequest::GetHeader(const std::string& hdr)
         return std::make_pair(false, "");
 }
 
+std::string HTTPRequest::PeekBody()
+{
+    struct evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return "";
+    size_t size = evbuffer_get_length(buf);
+    const char* data = (const char*)evbuffer_pullup(buf, size);
+    if (!data)
+        return "";
+    return std::string(data, size);
+}
+
 std::string HTTPRequest::ReadBody()
 {
     struct evbuffer* buf = evhttp_request_get_input_buffer(req);
@@ -646,10 +761,17 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod()
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier)
 {
     LogPrint("http", "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, classifier));
+}
+
+std::vector<HTTPWorkQueueLaneStats> GetHTTPWorkQueueStats()
+{
+    if (!workQueue)
+        return std::vector<HTTPWorkQueueLaneStats>();
+    return workQueue->GetStats();
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
@@ -6,6 +6,7 @@
 #define BITCOIN_HTTPSERVER_H
 
 #include <string>
+#include <vector>
 #include <stdint.h>
 #include <boost/thread.hpp>
 #include <boost/scoped_ptr.hpp>
@@ -14,6 +15,10 @@
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
+/** Max concurrently running requests per client address (0 = unlimited) */
+static const int DEFAULT_HTTP_CLIENT_THREADS=0;
+/** Histogram buckets: bucket i counts samples below 2^i ms, the last one the rest */
+static const int HTTP_WORKQUEUE_HIST_BUCKETS=17;
 
 struct evhttp_request;
 struct event_base;
@@ -34,16 +39,50 @@ void InterruptHTTPServer();
 /** Stop HTTP server */
 void StopHTTPServer();
 
+/** Cost class of a request. Each class has its own queue; higher classes
+ * are always dispatched first and low-priority work is limited to
+ * -rpcslowthreads workers so cheap calls are never starved.
+ */
+enum HTTPRequestPriority {
+    HTTP_PRIORITY_HIGH = 0,
+    HTTP_PRIORITY_NORMAL,
+    HTTP_PRIORITY_LOW,
+    HTTP_PRIORITY_COUNT
+};
+
 /** Handler for requests to a certain HTTP path */
 typedef boost::function<void(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+/** Classifier deciding the priority of a request before it is queued.
+ * Runs on the event thread, so it must be cheap and must not consume the body.
+ */
+typedef boost::function<HTTPRequestPriority(HTTPRequest* req, const std::string &)> HTTPRequestClassifier;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. Requests are queued as HTTP_PRIORITY_NORMAL unless a
+ * classifier is given.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler,
+                         const HTTPRequestClassifier &classifier = HTTPRequestClassifier());
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Work queue statistics for one priority class */
+struct HTTPWorkQueueLaneStats
+{
+    size_t nDepth;
+    size_t nMaxDepth;
+    int nRunning;
+    uint64_t nProcessed;
+    uint64_t nRejected;
+    std::vector<uint64_t> vQueueWaitHist;
+    std::vector<uint64_t> vExecHist;
+
+    HTTPWorkQueueLaneStats() : nDepth(0), nMaxDepth(0), nRunning(0), nProcessed(0), nRejected(0) {}
+};
+
+/** Return per-priority work queue statistics, indexed by HTTPRequestPriority */
+std::vector<HTTPWorkQueueLaneStats> GetHTTPWorkQueueStats();
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
@@ -99,6 +138,11 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Return a copy of the request body without consuming it.
+     */
+    std::string PeekBody();
+
     /**
      * Write output header.
      *
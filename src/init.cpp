@@ -9,12 +9,14 @@
 
 #include "init.h"
 #include "crypto/common.h"
+#include "crypto/sha256.h"
 #include "primitives/block.h"
 #include "addrman.h"
 #include "amount.h"
 #ifdef ENABLE_MINING
 #include "base58.h"
 #endif
+#include "blockencodings.h"
 #include "checkpoints.h"
 #include "compat/sanity.h"
 #include "consensus/upgrades.h"
@@ -36,6 +38,7 @@
 #include "utilmoneystr.h"
 #include "validationinterface.h"
 #ifdef ENABLE_WALLET
+#include "wallet/asyncjoinsplitprover.h"
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
 #endif
@@ -211,6 +214,7 @@ void Shutdown()
     StopNode();
     StopTorControl();
     UnregisterNodeSignals(GetNodeSignals());
+    StopValidationInterfaceQueue();
 
     if (fFeeEstimatesInitialized)
     {
@@ -378,7 +382,10 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-addnode=<ip>", _("Add a node to connect to and attempt to keep the connection open"));
     strUsage += HelpMessageOpt("-banscore=<n>", strprintf(_("Threshold for disconnecting misbehaving peers (default: %u)"), 100));
     strUsage += HelpMessageOpt("-bantime=<n>", strprintf(_("Number of seconds to keep misbehaving peers from reconnecting (default: %u)"), 86400));
+    strUsage += HelpMessageOpt("-blockfilemaps=<n>", strprintf(_("Map up to <n> block and undo files that are no longer written to into memory to read blocks from, 0 to disable (default: %u)"), DEFAULT_BLOCKFILE_MAPS));
+    strUsage += HelpMessageOpt("-blockservecache=<n>", strprintf(_("Keep up to <n> MiB of recent blocks serialized in memory to answer block requests from peers, 0 to disable (default: %u)"), DEFAULT_BLOCK_SERVE_CACHE));
     strUsage += HelpMessageOpt("-bind=<addr>", _("Bind to given address and always listen on it. Use [host]:port notation for IPv6"));
+    strUsage += HelpMessageOpt("-compactblocks", strprintf(_("Relay new blocks as compact blocks to and from peers that support them (default: %u)"), DEFAULT_COMPACT_BLOCKS));
     strUsage += HelpMessageOpt("-connect=<ip>", _("Connect only to the specified node(s)"));
     strUsage += HelpMessageOpt("-discover", _("Discover own IP addresses (default: 1 when listening and no -externalip or -proxy)"));
     strUsage += HelpMessageOpt("-dns", _("Allow DNS lookups for -addnode, -seednode and -connect") + " " + _("(default: 1)"));
@@ -427,6 +434,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-walletnotify=<cmd>", _("Execute command when a wallet transaction changes (%s in cmd is replaced by TxID)"));
     strUsage += HelpMessageOpt("-zapwallettxes=<mode>", _("Delete all wallet transactions and only recover those parts of the blockchain through -rescan on startup") +
         " " + _("(1 = keep tx meta data e.g. account owner and payment request information, 2 = drop tx meta data)"));
+    strUsage += HelpMessageOpt("-zproofthreads=<n>", strprintf(_("Number of JoinSplit proofs z_sendmany and z_mergetoaddress may generate at once, each needing about 1GB of memory (0 = one per core, default: %d)"), DEFAULT_ZPROOF_THREADS));
 #endif
 
 #if ENABLE_ZMQ
@@ -436,6 +444,9 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-zmqpubrawblock=<address>", _("Enable publish raw block in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawtx=<address>", _("Enable publish raw transaction in <address>"));
 #endif
+#if ENABLE_ZMQ || ENABLE_PROTON
+    strUsage += HelpMessageOpt("-maxnotifyqueue=<n>", strprintf(_("Maximum number of pending ZeroMQ/AMQP notifications before block processing waits for them (default: %u)"), DEFAULT_MAX_NOTIFY_QUEUE));
+#endif
 
 #if ENABLE_PROTON
     strUsage += HelpMessageGroup(_("AMQP 1.0 notification options:"));
@@ -471,6 +482,7 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-limitfreerelay=<n>", strprintf("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default: %u)", 15));
         strUsage += HelpMessageOpt("-relaypriority", strprintf("Require high priority for relaying free or low-fee transactions (default: %u)", 0));
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf("Limit size of signature cache to <n> entries (default: %u)", 50000));
+        strUsage += HelpMessageOpt("-maxcccachesize=<n>", strprintf("Limit size of the verified crypto-condition cache to <n> entries (default: %u)", 10000));
     }
     strUsage += HelpMessageOpt("-minrelaytxfee=<amt>", strprintf(_("Fees (in %s/kB) smaller than this are considered zero fee for relaying (default: %s)"),
         CURRENCY_UNIT, FormatMoney(::minRelayTxFee.GetFeePerK())));
@@ -521,6 +533,9 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-rpcport=<port>", strprintf(_("Listen for JSON-RPC connections on <port> (default: %u or testnet: %u)"), 7771, 17771));
     strUsage += HelpMessageOpt("-rpcallowip=<ip>", _("Allow JSON-RPC connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times"));
     strUsage += HelpMessageOpt("-rpcthreads=<n>", strprintf(_("Set the number of threads to service RPC calls (default: %d)"), DEFAULT_HTTP_THREADS));
+    strUsage += HelpMessageOpt("-rpcslowthreads=<n>", _("Maximum number of RPC threads that may run low-priority (expensive) calls at once (default: half of -rpcthreads)"));
+    strUsage += HelpMessageOpt("-rpcclientthreads=<n>", strprintf(_("Maximum number of RPC calls from a single client address that may run at once, 0 = unlimited (default: %d)"), DEFAULT_HTTP_CLIENT_THREADS));
+    strUsage += HelpMessageOpt("-rpcmethodclass=<method>:<class>", _("Set the priority class (high, normal or low) used to queue calls to an RPC method. This option can be specified multiple times"));
     if (showDebug) {
         strUsage += HelpMessageOpt("-rpcworkqueue=<n>", strprintf("Set the depth of the work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE));
         strUsage += HelpMessageOpt("-rpcservertimeout=<n>", strprintf("Timeout during HTTP requests (default: %d)", DEFAULT_HTTP_SERVER_TIMEOUT));
@@ -1096,6 +1111,9 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
         return false;
     }
 
+    // Pick the fastest SHA-256 implementation before any hashing threads start
+    std::string sha256_algo = SHA256AutoDetect();
+
     // Initialize elliptic curve code
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1143,6 +1161,7 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
 
     if (fPrintToDebugLog)
         OpenDebugLog();
+    LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
     LogPrintf("Using OpenSSL version %s\n", SSLeay_version(SSLEAY_VERSION));
 #ifdef ENABLE_WALLET
     LogPrintf("Using BerkeleyDB version %s\n", DbEnv::version(0, 0, 0));
@@ -1323,11 +1342,13 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     BOOST_FOREACH(const std::string& strDest, mapMultiArgs["-seednode"])
         AddOneShot(strDest);
 
+    StartValidationInterfaceQueue(std::max<int64_t>(GetArg("-maxnotifyqueue", DEFAULT_MAX_NOTIFY_QUEUE), 1));
+
 #if ENABLE_ZMQ
     pzmqNotificationInterface = CZMQNotificationInterface::CreateWithArguments(mapArgs);
 
     if (pzmqNotificationInterface) {
-        RegisterValidationInterface(pzmqNotificationInterface);
+        RegisterAsyncValidationInterface(pzmqNotificationInterface);
     }
 #endif
 
@@ -1342,7 +1363,7 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
             return InitError(_("AMQP support requires -experimentalfeatures."));
         }
 
-        RegisterValidationInterface(pAMQPNotificationInterface);
+        RegisterAsyncValidationInterface(pAMQPNotificationInterface);
     }
 #endif
 
@@ -1408,6 +1429,10 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set\n", nCoinCacheUsage * (1.0 / 1024 / 1024));
+    int64_t nBlockServeCache = std::max((int64_t)0, GetArg("-blockservecache", DEFAULT_BLOCK_SERVE_CACHE)) << 20;
+    recentBlockCache.SetMaxBytes(nBlockServeCache);
+    blockFileMapCache.SetMaxMaps(std::max((int64_t)0, GetArg("-blockfilemaps", DEFAULT_BLOCKFILE_MAPS)));
+    LogPrintf("* Using %.1fMiB for recently connected blocks served to peers\n", nBlockServeCache * (1.0 / 1024 / 1024));
 
     bool fLoaded = false;
     while (!fLoaded) {
@@ -1705,6 +1730,9 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
 
     // ********************************************************* Step 9: data directory maintenance
 
+    if (GetBoolArg("-compactblocks", DEFAULT_COMPACT_BLOCKS))
+        nLocalServices |= NODE_COMPACT_BLOCKS;
+
     // if pruning, unset the service bit and perform the initial blockstore prune
     // after any wallet rescanning has taken place.
     if (fPruneMode) {
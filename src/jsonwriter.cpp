@@ -0,0 +1,112 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "jsonwriter.h"
+
+#include "tinyformat.h"
+
+#include <iomanip>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+
+// Must stay in sync with univalue/lib/univalue_escapes.h
+static void JSONEscapeAppend(std::string& out, const char* s, size_t len)
+{
+    static const char hexdigits[] = "0123456789abcdef";
+
+    out += '"';
+    for (size_t i = 0; i < len; i++) {
+        unsigned char ch = s[i];
+        switch (ch) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\t': out += "\\t"; break;
+        case '\n': out += "\\n"; break;
+        case '\f': out += "\\f"; break;
+        case '\r': out += "\\r"; break;
+        default:
+            if (ch < 0x20 || ch == 0x7f) {
+                out += "\\u00";
+                out += hexdigits[ch >> 4];
+                out += hexdigits[ch & 0xf];
+            } else {
+                out += (char)ch;
+            }
+        }
+    }
+    out += '"';
+}
+
+void CJSONWriter::Key(const char* key)
+{
+    Separator();
+    JSONEscapeAppend(strOut, key, strlen(key));
+    strOut += ':';
+}
+
+void CJSONWriter::Key(const std::string& key)
+{
+    Separator();
+    JSONEscapeAppend(strOut, key.data(), key.size());
+    strOut += ':';
+}
+
+void CJSONWriter::String(const std::string& val)
+{
+    Separator();
+    JSONEscapeAppend(strOut, val.data(), val.size());
+    fNeedComma = true;
+}
+
+void CJSONWriter::String(const char* val)
+{
+    Separator();
+    JSONEscapeAppend(strOut, val, strlen(val));
+    fNeedComma = true;
+}
+
+void CJSONWriter::Int(int64_t val)
+{
+    Separator();
+    char buf[24];
+    int n = snprintf(buf, sizeof(buf), "%lld", (long long)val);
+    strOut.append(buf, n);
+    fNeedComma = true;
+}
+
+void CJSONWriter::Bool(bool val)
+{
+    Separator();
+    strOut += val ? "true" : "false";
+    fNeedComma = true;
+}
+
+void CJSONWriter::Double(double val)
+{
+    Separator();
+    std::ostringstream oss;
+    oss << std::setprecision(16) << val;
+    strOut += oss.str();
+    fNeedComma = true;
+}
+
+void CJSONWriter::Amount(const CAmount& amount)
+{
+    Separator();
+    bool sign = amount < 0;
+    int64_t n_abs = (sign ? -amount : amount);
+    int64_t quotient = n_abs / COIN;
+    int64_t remainder = n_abs % COIN;
+    strOut += strprintf("%s%d.%08d", sign ? "-" : "", quotient, remainder);
+    fNeedComma = true;
+}
+
+void CJSONWriter::Raw(const std::string& json)
+{
+    Separator();
+    strOut += json;
+    fNeedComma = true;
+}
@@ -0,0 +1,61 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_JSONWRITER_H
+#define BITCOIN_JSONWRITER_H
+
+#include "amount.h"
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Append-only JSON text builder for hot RPC/REST endpoints.
+ *
+ * Produces exactly the bytes UniValue::write() (compact form) would produce
+ * for the equivalent UniValue tree, without allocating the tree. Callers are
+ * responsible for emitting well-formed nesting; the writer only tracks where
+ * separators are needed.
+ */
+class CJSONWriter
+{
+private:
+    std::string strOut;
+    bool fNeedComma;
+
+    void Separator()
+    {
+        if (fNeedComma)
+            strOut += ',';
+        fNeedComma = false;
+    }
+
+public:
+    CJSONWriter() : fNeedComma(false) { strOut.reserve(4096); }
+
+    void BeginObject() { Separator(); strOut += '{'; }
+    void EndObject() { strOut += '}'; fNeedComma = true; }
+    void BeginArray() { Separator(); strOut += '['; }
+    void EndArray() { strOut += ']'; fNeedComma = true; }
+
+    /** Start an object member; must be followed by exactly one value. */
+    void Key(const char* key);
+    void Key(const std::string& key);
+
+    void String(const std::string& val);
+    void String(const char* val);
+    void Int(int64_t val);
+    void Bool(bool val);
+    /** Formatted like UniValue::setFloat (16 significant digits). */
+    void Double(double val);
+    /** Formatted like ValueFromAmount(). */
+    void Amount(const CAmount& amount);
+    /** Append an already-serialized JSON value verbatim. */
+    void Raw(const std::string& json);
+
+    const std::string& str() const { return strOut; }
+    std::string& str() { return strOut; }
+};
+
+#endif // BITCOIN_JSONWRITER_H
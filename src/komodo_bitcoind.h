@@ -772,12 +772,11 @@ uint32_t komodo_heightstamp(int32_t height)
 
 void komodo_index2pubkey33(uint8_t *pubkey33,CBlockIndex *pindex,int32_t height)
 {
-    int32_t num,i; CBlock block;
     memset(pubkey33,0,33);
     if ( pindex != 0 )
     {
-        if ( komodo_blockload(block,pindex) == 0 )
-            komodo_block2pubkey33(pubkey33,&block);
+        if ( GetBlockMinerPubKey(pindex,pubkey33) == 0 )
+            memset(pubkey33,0,33);
     }
 }
 
@@ -811,7 +810,7 @@ void komodo_index2pubkey33(uint8_t *pubkey33,CBlockIndex *pindex,int32_t height)
 
 int32_t komodo_eligiblenotary(uint8_t pubkeys[66][33],int32_t *mids,uint32_t blocktimes[66],int32_t *nonzpkeysp,int32_t height)
 {
-    int32_t i,j,n,duplicate; CBlock block; CBlockIndex *pindex; uint8_t notarypubs33[64][33];
+    int32_t i,j,n,duplicate; CBlockIndex *pindex; uint8_t notarypubs33[64][33];
     memset(mids,-1,sizeof(*mids)*66);
     n = komodo_notaries(notarypubs33,height,0);
     for (i=duplicate=0; i<66; i++)
@@ -819,9 +818,8 @@ int32_t komodo_eligiblenotary(uint8_t pubkeys[66][33],int32_t *mids,uint32_t blo
         if ( (pindex= komodo_chainactive(height-i)) != 0 )
         {
             blocktimes[i] = pindex->nTime;
-            if ( komodo_blockload(block,pindex) == 0 )
+            if ( GetBlockMinerPubKey(pindex,pubkeys[i]) != 0 )
             {
-                komodo_block2pubkey33(pubkeys[i],&block);
                 for (j=0; j<n; j++)
                 {
                     if ( memcmp(notarypubs33[j],pubkeys[i],33) == 0 )
@@ -843,7 +841,7 @@ int32_t komodo_eligiblenotary(uint8_t pubkeys[66][33],int32_t *mids,uint32_t blo
 
 int32_t komodo_minerids(uint8_t *minerids,int32_t height,int32_t width)
 {
-    int32_t i,j,n,nonz,numnotaries; CBlock block; CBlockIndex *pindex; uint8_t notarypubs33[64][33],pubkey33[33];
+    int32_t i,j,n,nonz,numnotaries; CBlockIndex *pindex; uint8_t notarypubs33[64][33],pubkey33[33];
     numnotaries = komodo_notaries(notarypubs33,height,0);
     for (i=nonz=0; i<width; i++,n++)
     {
@@ -851,9 +849,8 @@ int32_t komodo_minerids(uint8_t *minerids,int32_t height,int32_t width)
             continue;
         if ( (pindex= komodo_chainactive(height-width+i+1)) != 0 )
         {
-            if ( komodo_blockload(block,pindex) == 0 )
+            if ( GetBlockMinerPubKey(pindex,pubkey33) != 0 )
             {
-                komodo_block2pubkey33(pubkey33,&block);
                 for (j=0; j<numnotaries; j++)
                 {
                     if ( memcmp(notarypubs33[j],pubkey33,33) == 0 )
@@ -1146,38 +1143,103 @@ uint32_t komodo_stake(int32_t validateflag,arith_uint256 bnTarget,int32_t nHeigh
     return(blocktime * winner);
 }
 
+/*
+ komodo_PoWtarget looks at the KOMODO_POWWINDOW blocks below the height: how many of them were PoS and the
+ average hash of the PoW ones. Rather than walking them on every call, the PoS count and PoW hash sum of the
+ window ending at the tip are kept up to date as blocks are connected and disconnected, and each block is
+ classified only once, in its index.
+ */
+#define KOMODO_POWWINDOW 100
+struct komodo_powwindow { CBlockIndex *last; int32_t numPoS,numPoW; arith_uint256 sum; };
+struct komodo_powwindow KOMODO_POWWINDOW_TIP;
+pthread_mutex_t komodo_powwindow_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+int32_t komodo_powclass(CBlockIndex *pindex)
+{
+    arith_uint256 bnTarget; bool fNegative,fOverflow;
+    if ( pindex->nPoWClass < 0 )
+    {
+        bnTarget.SetCompact(pindex->nBits,&fNegative,&fOverflow);
+        bnTarget = (bnTarget / arith_uint256(KOMODO_POWMINMULT));
+        // PoW is never as easy as PoS/64, some PoS will be counted as PoW
+        pindex->nPoWClass = (UintToArith256(pindex->GetBlockHash()) <= bnTarget);
+    }
+    return(pindex->nPoWClass);
+}
+
+void komodo_powwindow_add(struct komodo_powwindow *wp,CBlockIndex *pindex,int32_t dir)
+{
+    if ( komodo_powclass(pindex) != 0 )
+    {
+        if ( dir > 0 )
+            wp->sum += UintToArith256(pindex->GetBlockHash());
+        else wp->sum -= UintToArith256(pindex->GetBlockHash());
+        wp->numPoW += dir;
+    }
+    else wp->numPoS += dir;
+}
+
+// the window of the blocks below height on the active chain
+void komodo_powwindow_build(struct komodo_powwindow *wp,int32_t height)
+{
+    CBlockIndex *pindex; int32_t ht;
+    wp->numPoS = wp->numPoW = 0;
+    wp->sum = arith_uint256(0);
+    for (ht=height-KOMODO_POWWINDOW; ht<height; ht++)
+        if ( (pindex= komodo_chainactive(ht)) != 0 )
+            komodo_powwindow_add(wp,pindex,1);
+    wp->last = komodo_chainactive(height-1);
+}
+
+// called with cs_main held once pindex is the new tip
+void komodo_powwindow_connect(CBlockIndex *pindex)
+{
+    CBlockIndex *pexpired;
+    pthread_mutex_lock(&komodo_powwindow_mutex);
+    if ( KOMODO_POWWINDOW_TIP.last != 0 && KOMODO_POWWINDOW_TIP.last == pindex->pprev )
+    {
+        komodo_powwindow_add(&KOMODO_POWWINDOW_TIP,pindex,1);
+        if ( (pexpired= pindex->GetAncestor(pindex->nHeight - KOMODO_POWWINDOW)) != 0 )
+            komodo_powwindow_add(&KOMODO_POWWINDOW_TIP,pexpired,-1);
+        KOMODO_POWWINDOW_TIP.last = pindex;
+    } else KOMODO_POWWINDOW_TIP.last = 0; // rebuilt when next needed
+    pthread_mutex_unlock(&komodo_powwindow_mutex);
+}
+
+// called with cs_main held once pindex is no longer the tip
+void komodo_powwindow_disconnect(CBlockIndex *pindex)
+{
+    CBlockIndex *preturned;
+    pthread_mutex_lock(&komodo_powwindow_mutex);
+    if ( KOMODO_POWWINDOW_TIP.last != 0 && KOMODO_POWWINDOW_TIP.last == pindex )
+    {
+        komodo_powwindow_add(&KOMODO_POWWINDOW_TIP,pindex,-1);
+        if ( (preturned= pindex->GetAncestor(pindex->nHeight - KOMODO_POWWINDOW)) != 0 )
+            komodo_powwindow_add(&KOMODO_POWWINDOW_TIP,preturned,1);
+        KOMODO_POWWINDOW_TIP.last = pindex->pprev;
+    } else KOMODO_POWWINDOW_TIP.last = 0;
+    pthread_mutex_unlock(&komodo_powwindow_mutex);
+}
+
 arith_uint256 komodo_PoWtarget(int32_t *percPoSp,arith_uint256 target,int32_t height,int32_t goalperc)
 {
-    CBlockIndex *pindex; arith_uint256 bnTarget,hashval,sum,ave; bool fNegative,fOverflow; int32_t i,n,ht,percPoS,diff,val;
+    struct komodo_powwindow window; CBlockIndex *plast; arith_uint256 bnTarget,sum,ave; int32_t n,percPoS;
     *percPoSp = percPoS = 0;
     if ( height < 3 )
         return(target);
-    sum = arith_uint256(0);
-    ave = sum;
-    for (i=n=0; i<100; i++)
+    pthread_mutex_lock(&komodo_powwindow_mutex);
+    if ( (plast= komodo_chainactive(height-1)) != 0 && KOMODO_POWWINDOW_TIP.last == plast )
+        window = KOMODO_POWWINDOW_TIP;
+    else
     {
-        ht = height - 100 + i;
-        if ( (pindex= komodo_chainactive(ht)) != 0 )
-        {
-            bnTarget.SetCompact(pindex->nBits,&fNegative,&fOverflow);
-            bnTarget = (bnTarget / arith_uint256(KOMODO_POWMINMULT));
-            hashval = UintToArith256(pindex->GetBlockHash());
-            if ( hashval <= bnTarget ) // PoW is never as easy as PoS/64, some PoS will be counted as PoW
-            {
-                fprintf(stderr,"1");
-                sum += hashval;
-                n++;
-            }
-            else
-            {
-                percPoS++;
-                fprintf(stderr,"0");
-            }
-            if ( (i % 10) == 9 )
-                fprintf(stderr," %d, ",percPoS);
-        }
+        komodo_powwindow_build(&window,height);
+        if ( plast != 0 && plast == chainActive.Tip() )
+            KOMODO_POWWINDOW_TIP = window;
     }
-    fprintf(stderr," -> %d%% percPoS ht.%d\n",percPoS,height);
+    pthread_mutex_unlock(&komodo_powwindow_mutex);
+    percPoS = window.numPoS;
+    n = window.numPoW;
+    sum = window.sum;
     *percPoSp = percPoS;
     target = (target / arith_uint256(KOMODO_POWMINMULT));
     if ( n > 0 )
@@ -1189,34 +1251,10 @@ arith_uint256 komodo_PoWtarget(int32_t *percPoSp,arith_uint256 target,int32_t he
     if ( percPoS < goalperc ) // increase PoW diff -> lower bnTarget
     {
         bnTarget = (ave * arith_uint256(percPoS * percPoS)) / arith_uint256((goalperc) * (goalperc));
-        if ( 1 )
-        {
-            for (i=31; i>=24; i--)
-                fprintf(stderr,"%02x",((uint8_t *)&ave)[i]);
-            fprintf(stderr," increase diff -> ");
-            for (i=31; i>=24; i--)
-                fprintf(stderr,"%02x",((uint8_t *)&bnTarget)[i]);
-            fprintf(stderr," floor diff ");
-            for (i=31; i>=24; i--)
-                fprintf(stderr,"%02x",((uint8_t *)&target)[i]);
-            fprintf(stderr," ht.%d percPoS.%d vs goal.%d -> diff %d\n",height,percPoS,goalperc,goalperc - percPoS);
-        }
     }
     else if ( percPoS > goalperc ) // decrease PoW diff -> raise bnTarget
     {
         bnTarget = ((ave * arith_uint256(goalperc)) + (target * arith_uint256(percPoS))) / arith_uint256(percPoS + goalperc);
-        if ( 1 )
-        {
-            for (i=31; i>=24; i--)
-                fprintf(stderr,"%02x",((uint8_t *)&ave)[i]);
-            fprintf(stderr," decrease diff -> ");
-            for (i=31; i>=24; i--)
-                fprintf(stderr,"%02x",((uint8_t *)&bnTarget)[i]);
-            fprintf(stderr," floor diff ");
-            for (i=31; i>=24; i--)
-                fprintf(stderr,"%02x",((uint8_t *)&target)[i]);
-            fprintf(stderr," ht.%d percPoS.%d vs goal.%d -> diff %d\n",height,percPoS,goalperc,goalperc - percPoS);
-        }
     }
     else bnTarget = ave; // recent ave is perfect
     return(bnTarget);
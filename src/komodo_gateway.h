@@ -16,6 +16,12 @@
 // paxdeposit equivalent in reverse makes opreturn and KMD does the same in reverse
 #include "komodo_defs.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
 int32_t pax_fiatstatus(uint64_t *available,uint64_t *deposited,uint64_t *issued,uint64_t *withdrawn,uint64_t *approved,uint64_t *redeemed,char *base)
 {
     int32_t baseid; struct komodo_state *sp; int64_t netliability,maxallowed,maxval;
@@ -1348,13 +1354,244 @@ int32_t komodo_faststateinit(struct komodo_state *sp,char *fname,char *symbol,ch
     return(-1);
 }
 
+/*
+ The komodostate files of other chains are only ever appended to, so instead of
+ being reopened and reread every pass they are followed: each one is mapped
+ read-only and parsed from where the previous pass stopped. On linux an inotify
+ watch says which files were written at all, so a pass over idle chains makes no
+ system calls on their files.
+ */
+struct komodo_statetail
+{
+    char fname[512];
+    int32_t isopen,fd,wd,dirty;
+    uint8_t *filedata; long maplen,filesize,fpos;
+    uint32_t pendingsince,lastparsed; int64_t records;
+};
+struct komodo_statetail KOMODO_STATETAILS[33]; int32_t KOMODO_INOTIFYFD = -1;
+
+// length of the complete record at fpos, 0 if the writer hasnt finished it yet
+long komodo_staterecordlen(uint8_t *filedata,long fpos,long datalen)
+{
+    long len = 1 + sizeof(int32_t); uint16_t olen;
+    if ( fpos+len > datalen )
+        return(0);
+    switch ( filedata[fpos] )
+    {
+        case 'P':
+            if ( fpos+(++len) <= datalen )
+                len += 33 * filedata[fpos+len-1];
+            break;
+        case 'N': len += sizeof(int32_t) + 2*sizeof(uint256); break;
+        case 'M': len += sizeof(int32_t) + 3*sizeof(uint256) + sizeof(int32_t); break;
+        case 'U': len += 2 + sizeof(uint64_t) + sizeof(uint256); break;
+        case 'K': len += sizeof(int32_t); break;
+        case 'T': len += 2*sizeof(int32_t); break;
+        case 'R':
+            len += sizeof(uint256) + sizeof(uint16_t) + sizeof(uint64_t) + sizeof(olen);
+            if ( fpos+len <= datalen )
+            {
+                memcpy(&olen,&filedata[fpos+len-sizeof(olen)],sizeof(olen));
+                len += olen;
+            }
+            break;
+        case 'V':
+            if ( fpos+(++len) <= datalen )
+                len += sizeof(uint32_t) * filedata[fpos+len-1];
+            break;
+    }
+    return(fpos+len <= datalen ? len : 0);
+}
+
+int32_t komodo_statetail_open(struct komodo_statetail *tp,char *fname)
+{
+    if ( tp->isopen != 0 )
+        return(0);
+#ifdef _WIN32
+    if ( (tp->fd= open(fname,O_RDONLY | O_BINARY)) < 0 )
+#else
+    if ( (tp->fd= open(fname,O_RDONLY)) < 0 )
+#endif
+        return(-1);
+    safecopy(tp->fname,fname,sizeof(tp->fname));
+    tp->wd = -1;
+#ifdef __linux__
+    if ( KOMODO_INOTIFYFD < 0 && (KOMODO_INOTIFYFD= inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0 )
+        fprintf(stderr,"inotify_init1 error %d, polling komodostate files\n",errno);
+    // IN_ATTRIB catches the file being unlinked while we still hold it open, as -reindex does
+    if ( KOMODO_INOTIFYFD >= 0 )
+        tp->wd = inotify_add_watch(KOMODO_INOTIFYFD,fname,IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF);
+#endif
+    tp->isopen = tp->dirty = 1;
+    return(0);
+}
+
+// forget the followed file, so the next komodo_statetail_open starts over from its beginning
+void komodo_statetail_close(struct komodo_statetail *tp)
+{
+    if ( tp->isopen == 0 )
+        return;
+#ifdef __linux__
+    if ( KOMODO_INOTIFYFD >= 0 && tp->wd >= 0 )
+        inotify_rm_watch(KOMODO_INOTIFYFD,tp->wd);
+#endif
+    if ( tp->filedata != 0 )
+    {
+#ifdef _WIN32
+        free(tp->filedata);
+#else
+        munmap(tp->filedata,tp->maplen);
+#endif
+    }
+    close(tp->fd);
+    pthread_mutex_lock(&komodo_mutex);
+    tp->filedata = 0;
+    tp->maplen = tp->filesize = tp->fpos = 0;
+    tp->pendingsince = 0;
+    tp->records = 0;
+    tp->isopen = tp->dirty = 0;
+    tp->fd = tp->wd = -1;
+    pthread_mutex_unlock(&komodo_mutex);
+}
+
+// mark the followed files that were written to since the last pass
+void komodo_statetail_events()
+{
+#ifdef __linux__
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event)))); struct inotify_event *event; ssize_t len; char *ptr; int32_t i;
+    if ( KOMODO_INOTIFYFD < 0 )
+        return;
+    while ( (len= read(KOMODO_INOTIFYFD,buf,sizeof(buf))) > 0 )
+    {
+        for (ptr=buf; ptr<buf+len; ptr+=sizeof(struct inotify_event)+event->len)
+        {
+            event = (struct inotify_event *)ptr;
+            for (i=0; i<33; i++)
+            {
+                if ( KOMODO_STATETAILS[i].isopen != 0 && KOMODO_STATETAILS[i].wd == event->wd )
+                {
+                    KOMODO_STATETAILS[i].dirty = 1;
+                    if ( (event->mask & IN_IGNORED) != 0 ) // file is gone, fall back to polling it
+                        KOMODO_STATETAILS[i].wd = -1;
+                }
+            }
+        }
+    }
+#endif
+}
+
+int32_t komodo_statetail_map(struct komodo_statetail *tp)
+{
+#ifdef _WIN32
+    uint8_t *ptr; long n;
+    if ( (ptr= (uint8_t *)realloc(tp->filedata,tp->filesize)) == 0 )
+        return(-1);
+    tp->filedata = ptr;
+    if ( lseek(tp->fd,tp->maplen,SEEK_SET) != tp->maplen || (n= read(tp->fd,&ptr[tp->maplen],tp->filesize - tp->maplen)) < 0 )
+        return(-1);
+    tp->maplen += n;
+#else
+    void *ptr;
+    if ( (ptr= mmap(0,tp->filesize,PROT_READ,MAP_SHARED,tp->fd,0)) == MAP_FAILED )
+        return(-1);
+    if ( tp->filedata != 0 )
+        munmap(tp->filedata,tp->maplen);
+    tp->filedata = (uint8_t *)ptr;
+    tp->maplen = tp->filesize;
+#endif
+    return(0);
+}
+
+/*
+ parses the records appended to the file since the last call, stopping once deadline
+ has passed (0 for none). returns the number of records parsed or -1 on error
+ */
+int32_t komodo_statetail_update(struct komodo_statetail *tp,struct komodo_state *sp,char *symbol,char *dest,uint32_t deadline)
+{
+    struct stat st,namest; long len,fpos; int32_t n = 0; uint32_t now; char fname[sizeof(tp->fname)];
+    if ( tp->wd >= 0 && tp->dirty == 0 )
+        return(0);
+    tp->dirty = 0;
+    if ( fstat(tp->fd,&st) != 0 )
+        return(-1);
+    // the other chain rewrites its komodostate on -reindex: follow the new file by name
+    if ( stat(tp->fname,&namest) != 0 || namest.st_ino != st.st_ino || namest.st_dev != st.st_dev || namest.st_size < tp->filesize )
+    {
+        fprintf(stderr,"%s was replaced, reading it again from the start\n",tp->fname);
+        safecopy(fname,tp->fname,sizeof(fname));
+        komodo_statetail_close(tp);
+        if ( komodo_statetail_open(tp,fname) < 0 || fstat(tp->fd,&st) != 0 )
+            return(-1);
+    }
+    now = (uint32_t)time(NULL);
+    if ( st.st_size > tp->filesize )
+    {
+        pthread_mutex_lock(&komodo_mutex);
+        if ( tp->fpos == tp->filesize )
+            tp->pendingsince = now;
+        tp->filesize = st.st_size;
+        pthread_mutex_unlock(&komodo_mutex);
+    }
+    if ( tp->fpos >= tp->filesize )
+        return(0);
+    if ( tp->filesize > tp->maplen && komodo_statetail_map(tp) < 0 )
+    {
+        fprintf(stderr,"error mapping %s %ldKB\n",tp->fname,tp->filesize/1024);
+        return(-1);
+    }
+    while ( (len= komodo_staterecordlen(tp->filedata,tp->fpos,tp->maplen)) > 0 )
+    {
+        fpos = tp->fpos;
+        if ( komodo_parsestatefiledata(sp,tp->filedata,&fpos,tp->fpos+len,symbol,dest) < 0 )
+            break;
+        tp->fpos = fpos, n++;
+        if ( deadline != 0 && time(NULL) >= deadline )
+        {
+            tp->dirty = 1; // pick up from here on the next pass
+            break;
+        }
+    }
+    pthread_mutex_lock(&komodo_mutex);
+    tp->records += n;
+    if ( n > 0 )
+        tp->lastparsed = (uint32_t)time(NULL);
+    if ( tp->fpos < tp->filesize && tp->pendingsince == 0 )
+        tp->pendingsince = now;
+    else if ( tp->fpos >= tp->filesize )
+        tp->pendingsince = 0;
+    pthread_mutex_unlock(&komodo_mutex);
+    return(n);
+}
+
+// how far behind the komodostate file of baseid this node is, 0 if it isnt followed
+int32_t komodo_statetail_info(int32_t baseid,char *symbol,long *filesizep,long *fposp,int32_t *lagsecondsp,uint32_t *lastparsedp,int64_t *recordsp)
+{
+    struct komodo_statetail *tp; int32_t retval = 0;
+    if ( baseid < 0 || baseid > 32 )
+        return(0);
+    tp = &KOMODO_STATETAILS[baseid];
+    pthread_mutex_lock(&komodo_mutex);
+    if ( tp->isopen != 0 )
+    {
+        strcpy(symbol,baseid < 32 ? CURRENCIES[baseid] : "KMD");
+        *filesizep = tp->filesize;
+        *fposp = tp->fpos;
+        *lagsecondsp = tp->pendingsince != 0 ? (int32_t)(time(NULL) - tp->pendingsince) : 0;
+        *lastparsedp = tp->lastparsed;
+        *recordsp = tp->records;
+        retval = 1;
+    }
+    pthread_mutex_unlock(&komodo_mutex);
+    return(retval);
+}
+
 uint64_t komodo_interestsum();
 
 void komodo_passport_iteration()
 {
-    static long lastpos[34]; static char userpass[33][1024]; static uint32_t lasttime,callcounter,lastinterest;
+    static char userpass[33][1024]; static uint32_t lasttime,lastinterest;
     int32_t maxseconds = 10;
-    FILE *fp; uint8_t *filedata; long fpos,datalen,lastfpos; int32_t baseid,limit,n,ht,isrealtime,expired,refid,blocks,longest; struct komodo_state *sp,*refsp; char *retstr,fname[512],*base,symbol[KOMODO_ASSETCHAIN_MAXLEN],dest[KOMODO_ASSETCHAIN_MAXLEN]; uint32_t buf[3],starttime; cJSON *infoobj,*result; uint64_t RTmask = 0;
+    FILE *fp; long fpos; int32_t baseid,n,isrealtime,expired,refid,blocks,longest; struct komodo_state *sp,*refsp; struct komodo_statetail *tp; char *retstr,fname[512],*base,symbol[KOMODO_ASSETCHAIN_MAXLEN],dest[KOMODO_ASSETCHAIN_MAXLEN]; uint32_t buf[3],starttime; cJSON *infoobj,*result; uint64_t RTmask = 0;
     expired = 0;
     while ( KOMODO_INITDONE == 0 )
     {
@@ -1371,12 +1608,10 @@ void komodo_passport_iteration()
     if ( ASSETCHAINS_SYMBOL[0] == 0 )
     {
         refid = 33;
-        limit = 10000000;
         jumblr_iteration();
     }
     else
     {
-        limit = 10000000;
         refid = komodo_baseid(ASSETCHAINS_SYMBOL)+1; // illegal base -> baseid.-1 -> 0
         if ( refid == 0 )
         {
@@ -1390,9 +1625,8 @@ void komodo_passport_iteration()
         return;
     }*/
     starttime = (uint32_t)time(NULL);
-    if ( callcounter++ < 1 )
-        limit = 10000;
     lasttime = starttime;
+    komodo_statetail_events();
     for (baseid=32; baseid>=0; baseid--)
     {
         if ( time(NULL) >= starttime+maxseconds )
@@ -1409,46 +1643,16 @@ void komodo_passport_iteration()
                 komodo_statefname(fname,baseid<32?base:(char *)"",(char *)"komodostate");
                 komodo_nameset(symbol,dest,base);
                 sp = komodo_stateptrget(symbol);
-                n = 0;
-                if ( lastpos[baseid] == 0 && (filedata= OS_fileptr(&datalen,fname)) != 0 )
-                {
-                    fpos = 0;
-                    fprintf(stderr,"%s processing %s %ldKB\n",ASSETCHAINS_SYMBOL,fname,datalen/1024);
-                    while ( komodo_parsestatefiledata(sp,filedata,&fpos,datalen,symbol,dest) >= 0 )
-                        lastfpos = fpos;
-                    fprintf(stderr,"%s took %d seconds to process %s %ldKB\n",ASSETCHAINS_SYMBOL,(int32_t)(time(NULL)-starttime),fname,datalen/1024);
-                    lastpos[baseid] = lastfpos;
-                    free(filedata), filedata = 0;
-                    datalen = 0;
-                }
-                else if ( (fp= fopen(fname,"rb")) != 0 && sp != 0 )
+                tp = &KOMODO_STATETAILS[baseid];
+                if ( sp != 0 && komodo_statetail_open(tp,fname) == 0 )
                 {
-                    fseek(fp,0,SEEK_END);
-                    //fprintf(stderr,"couldnt OS_fileptr(%s), freading %ldKB\n",fname,ftell(fp)/1024);
-                    if ( ftell(fp) > lastpos[baseid] )
-                    {
-                        if ( ASSETCHAINS_SYMBOL[0] != 0 )
-                            printf("%s passport refid.%d %s fname.(%s) base.%s %ld %ld\n",ASSETCHAINS_SYMBOL,refid,symbol,fname,base,ftell(fp),lastpos[baseid]);
-                        fseek(fp,lastpos[baseid],SEEK_SET);
-                        while ( komodo_parsestatefile(sp,fp,symbol,dest) >= 0 && n < limit )
-                        {
-                            if ( n == limit-1 )
-                            {
-                                if ( time(NULL) < starttime+maxseconds )
-                                    n = 0;
-                                else
-                                {
-                                    //printf("expire passport loop %s -> %s at %ld\n",ASSETCHAINS_SYMBOL,base,lastpos[baseid]);
-                                    expired++;
-                                }
-                            }
-                            n++;
-                        }
-                        lastpos[baseid] = ftell(fp);
-                        if ( 0 && lastpos[baseid] == 0 && strcmp(symbol,"KMD") == 0 )
-                            printf("from.(%s) lastpos[%s] %ld isrt.%d\n",ASSETCHAINS_SYMBOL,CURRENCIES[baseid],lastpos[baseid],komodo_isrealtime(&ht));
-                    } //else fprintf(stderr,"%s.%ld ",CURRENCIES[baseid],ftell(fp));
-                    fclose(fp);
+                    if ( (fpos= tp->fpos) == 0 )
+                        fprintf(stderr,"%s processing %s\n",ASSETCHAINS_SYMBOL,fname);
+                    // the initial load runs to completion, later ones share the time budget
+                    if ( (n= komodo_statetail_update(tp,sp,symbol,dest,fpos == 0 ? 0 : starttime+maxseconds)) > 0 && fpos == 0 )
+                        fprintf(stderr,"%s took %d seconds to process %s %ldKB\n",ASSETCHAINS_SYMBOL,(int32_t)(time(NULL)-starttime),fname,tp->fpos/1024);
+                    if ( tp->fpos < tp->filesize && tp->dirty != 0 )
+                        expired++;
                 } else fprintf(stderr,"load error.(%s) %p\n",fname,sp);
                 komodo_statefname(fname,baseid<32?base:(char *)"",(char *)"realtime");
                 if ( (fp= fopen(fname,"rb")) != 0 )
@@ -386,33 +386,30 @@ int32_t komodo_chosennotary(int32_t *notaryidp,int32_t height,uint8_t *pubkey33,
 
 struct notarized_checkpoint *komodo_npptr(int32_t height)
 {
-    char symbol[KOMODO_ASSETCHAIN_MAXLEN],dest[KOMODO_ASSETCHAIN_MAXLEN]; int32_t i; struct komodo_state *sp; struct notarized_checkpoint *np = 0;
+    char symbol[KOMODO_ASSETCHAIN_MAXLEN],dest[KOMODO_ASSETCHAIN_MAXLEN]; struct komodo_state *sp; struct notarized_checkpoint *np = 0;
+    std::map<int32_t,std::pair<int32_t,int32_t> >::iterator it;
     if ( (sp= komodo_stateptr(symbol,dest)) != 0 )
     {
-        for (i=sp->NUM_NPOINTS-1; i>=0; i--)
-        {
-            np = &sp->NPOINTS[i];
-            if ( np->MoMdepth > 0 && height > np->notarized_height-np->MoMdepth && height <= np->notarized_height )
-                return(np);
-        }
+        // the latest notarization whose MoM range covers height
+        portable_mutex_lock(&komodo_mutex);
+        if ( (it= sp->NPOINTS_MoMranges.upper_bound(height)) != sp->NPOINTS_MoMranges.begin() && (--it)->second.first >= height )
+            np = &sp->NPOINTS[it->second.second];
+        portable_mutex_unlock(&komodo_mutex);
     }
-    return(0);
+    return(np);
 }
 
 int32_t komodo_prevMoMheight()
 {
-    static uint256 zero;
-    char symbol[KOMODO_ASSETCHAIN_MAXLEN],dest[KOMODO_ASSETCHAIN_MAXLEN]; int32_t i; struct komodo_state *sp; struct notarized_checkpoint *np = 0;
+    char symbol[KOMODO_ASSETCHAIN_MAXLEN],dest[KOMODO_ASSETCHAIN_MAXLEN]; struct komodo_state *sp; int32_t height = 0;
     if ( (sp= komodo_stateptr(symbol,dest)) != 0 )
     {
-        for (i=sp->NUM_NPOINTS-1; i>=0; i--)
-        {
-            np = &sp->NPOINTS[i];
-            if ( np->MoM != zero )
-                return(np->notarized_height);
-        }
+        portable_mutex_lock(&komodo_mutex);
+        if ( sp->lastMoM_NPOINTSi > 0 )
+            height = sp->NPOINTS[sp->lastMoM_NPOINTSi-1].notarized_height;
+        portable_mutex_unlock(&komodo_mutex);
     }
-    return(0);
+    return(height);
 }
 
 int32_t komodo_notarized_height(int32_t *prevMoMheightp,uint256 *hashp,uint256 *txidp)
@@ -458,58 +455,57 @@ int32_t komodo_MoMdata(int32_t *notarized_htp,uint256 *MoMp,uint256 *kmdtxidp,in
 
 int32_t komodo_notarizeddata(int32_t nHeight,uint256 *notarized_hashp,uint256 *notarized_desttxidp)
 {
-    struct notarized_checkpoint *np = 0; int32_t i=0,flag = 0; char symbol[KOMODO_ASSETCHAIN_MAXLEN],dest[KOMODO_ASSETCHAIN_MAXLEN]; struct komodo_state *sp;
+    struct notarized_checkpoint *np = 0; int32_t i,notarized_height = 0; char symbol[KOMODO_ASSETCHAIN_MAXLEN],dest[KOMODO_ASSETCHAIN_MAXLEN]; struct komodo_state *sp;
+    memset(notarized_hashp,0,sizeof(*notarized_hashp));
+    memset(notarized_desttxidp,0,sizeof(*notarized_desttxidp));
     if ( (sp= komodo_stateptr(symbol,dest)) != 0 )
     {
-        if ( sp->NUM_NPOINTS > 0 )
+        // the notarization before the first one recorded at nHeight or above
+        portable_mutex_lock(&komodo_mutex);
+        i = (int32_t)(std::lower_bound(sp->NPOINTS_maxheight.begin(),sp->NPOINTS_maxheight.end(),nHeight) - sp->NPOINTS_maxheight.begin());
+        if ( i > 0 )
         {
-            flag = 0;
-            if ( sp->last_NPOINTSi < sp->NUM_NPOINTS && sp->last_NPOINTSi > 0 )
-            {
-                np = &sp->NPOINTS[sp->last_NPOINTSi-1];
-                if ( np->nHeight < nHeight )
-                {
-                    for (i=sp->last_NPOINTSi; i<sp->NUM_NPOINTS; i++)
-                    {
-                        if ( sp->NPOINTS[i].nHeight >= nHeight )
-                        {
-                            //printf("flag.1 i.%d np->ht %d [%d].ht %d >= nHeight.%d, last.%d num.%d\n",i,np->nHeight,i,sp->NPOINTS[i].nHeight,nHeight,sp->last_NPOINTSi,sp->NUM_NPOINTS);
-                            flag = 1;
-                            break;
-                        }
-                        np = &sp->NPOINTS[i];
-                        sp->last_NPOINTSi = i;
-                    }
-                }
-            }
-            if ( flag == 0 )
-            {
-                np = 0;
-                for (i=0; i<sp->NUM_NPOINTS; i++)
-                {
-                    if ( sp->NPOINTS[i].nHeight >= nHeight )
-                    {
-                        //printf("i.%d np->ht %d [%d].ht %d >= nHeight.%d\n",i,np->nHeight,i,sp->NPOINTS[i].nHeight,nHeight);
-                        break;
-                    }
-                    np = &sp->NPOINTS[i];
-                    sp->last_NPOINTSi = i;
-                }
-            }
-        }
-        if ( np != 0 )
-        {
-            //char str[65],str2[65]; printf("[%s] notarized_ht.%d\n",ASSETCHAINS_SYMBOL,np->notarized_height);
-            if ( np->nHeight >= nHeight || (i < sp->NUM_NPOINTS && np[1].nHeight < nHeight) )
-                printf("warning: flag.%d i.%d np->ht %d [1].ht %d >= nHeight.%d\n",flag,i,np->nHeight,np[1].nHeight,nHeight);
+            np = &sp->NPOINTS[i-1];
             *notarized_hashp = np->notarized_hash;
             *notarized_desttxidp = np->notarized_desttxid;
-            return(np->notarized_height);
+            notarized_height = np->notarized_height;
         }
+        portable_mutex_unlock(&komodo_mutex);
     }
-    memset(notarized_hashp,0,sizeof(*notarized_hashp));
-    memset(notarized_desttxidp,0,sizeof(*notarized_desttxidp));
-    return(0);
+    return(notarized_height);
+}
+
+/// Record NPOINTS[i] in the search indexes. The caller holds komodo_mutex.
+void komodo_notarized_index(struct komodo_state *sp,int32_t i)
+{
+    struct notarized_checkpoint *np = &sp->NPOINTS[i]; int32_t lo,hi; std::pair<int32_t,int32_t> seg;
+    std::map<int32_t,std::pair<int32_t,int32_t> > &ranges = sp->NPOINTS_MoMranges;
+    std::map<int32_t,std::pair<int32_t,int32_t> >::iterator it;
+    sp->NPOINTS_maxheight.push_back(i > 0 ? std::max(sp->NPOINTS_maxheight[i-1],np->nHeight) : np->nHeight);
+    if ( np->MoM != uint256() )
+        sp->lastMoM_NPOINTSi = i + 1;
+    if ( np->MoMdepth <= 0 )
+        return;
+    // the newest notarization wins wherever MoM ranges overlap, so paint its
+    // range over the existing ones, keeping the parts that stick out
+    lo = np->notarized_height - np->MoMdepth + 1;
+    hi = np->notarized_height;
+    if ( (it= ranges.lower_bound(lo)) != ranges.begin() && std::prev(it)->second.first >= lo )
+    {
+        --it;
+        seg = it->second;
+        it->second.first = lo - 1;
+        if ( seg.first > hi )
+            ranges[hi+1] = std::make_pair(seg.first,seg.second);
+    }
+    it = ranges.lower_bound(lo);
+    while ( it != ranges.end() && it->first <= hi )
+    {
+        if ( it->second.first > hi )
+            ranges[hi+1] = it->second;
+        it = ranges.erase(it);
+    }
+    ranges[lo] = std::make_pair(hi,i);
 }
 
 void komodo_notarized_update(struct komodo_state *sp,int32_t nHeight,int32_t notarized_height,uint256 notarized_hash,uint256 notarized_desttxid,uint256 MoM,int32_t MoMdepth)
@@ -532,6 +528,7 @@ void komodo_notarized_update(struct komodo_state *sp,int32_t nHeight,int32_t not
     sp->NOTARIZED_DESTTXID = np->notarized_desttxid = notarized_desttxid;
     sp->MoM = np->MoM = MoM;
     sp->MoMdepth = np->MoMdepth = MoMdepth;
+    komodo_notarized_index(sp,sp->NUM_NPOINTS-1);
     portable_mutex_unlock(&komodo_mutex);
 }
 
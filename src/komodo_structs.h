@@ -18,6 +18,9 @@
 #include "uthash.h"
 #include "utlist.h"
 
+#include <map>
+#include <vector>
+
 /*#ifdef _WIN32
 #define PACKED
 #else
@@ -119,7 +122,11 @@ struct komodo_state
     int32_t SAVEDHEIGHT,CURRENT_HEIGHT,NOTARIZED_HEIGHT,MoMdepth;
     uint32_t SAVEDTIMESTAMP;
     uint64_t deposited,issued,withdrawn,approved,redeemed,shorted;
-    struct notarized_checkpoint *NPOINTS; int32_t NUM_NPOINTS,last_NPOINTSi;
+    struct notarized_checkpoint *NPOINTS; int32_t NUM_NPOINTS;
+    // search indexes over NPOINTS, maintained by komodo_notarized_update under komodo_mutex
+    std::vector<int32_t> NPOINTS_maxheight; // [i] is the highest nHeight in NPOINTS[0..i]
+    std::map<int32_t,std::pair<int32_t,int32_t> > NPOINTS_MoMranges; // disjoint ranges, first height -> (last height, latest NPOINTS index whose MoM covers them)
+    int32_t lastMoM_NPOINTSi; // 1 + index of the latest NPOINTS entry with a MoM, 0 if none
     struct komodo_event **Komodo_events; int32_t Komodo_numevents;
     uint32_t RTbufs[64][3]; uint64_t RTmask;
 };
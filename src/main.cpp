@@ -10,11 +10,13 @@
 #include "addrman.h"
 #include "alert.h"
 #include "arith_uint256.h"
+#include "blockencodings.h"
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "checkqueue.h"
 #include "consensus/upgrades.h"
 #include "consensus/validation.h"
+#include "crypto/common.h"
 #include "deprecation.h"
 #include "init.h"
 #include "merkleblock.h"
@@ -31,8 +33,12 @@
 #include "wallet/asyncrpcoperation_sendmany.h"
 #include "wallet/asyncrpcoperation_shieldcoinbase.h"
 
+#include <condition_variable>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 
 #include <boost/algorithm/string/replace.hpp>
@@ -58,9 +64,13 @@ extern uint8_t NOTARY_PUBKEY33[33];
 extern int32_t KOMODO_LOADINGBLOCKS,KOMODO_LONGESTCHAIN;
 int32_t KOMODO_NEWBLOCKS;
 int32_t komodo_block2pubkey33(uint8_t *pubkey33,CBlock *block);
+int32_t komodo_blockload(CBlock& block,CBlockIndex *pindex);
 void komodo_broadcast(CBlock *pblock,int32_t limit);
+void komodo_powwindow_connect(CBlockIndex *pindex);
+void komodo_powwindow_disconnect(CBlockIndex *pindex);
 
 BlockMap mapBlockIndex;
+CBlockIndexArena blockIndexArena;
 CChain chainActive;
 CBlockIndex *pindexBestHeader = NULL;
 int64_t nTimeBestReceived = 0;
@@ -91,6 +101,10 @@ CFeeRate minRelayTxFee = CFeeRate(DEFAULT_MIN_RELAY_TX_FEE);
 
 CTxMemPool mempool(::minRelayTxFee);
 
+CRecentBlockCache recentBlockCache(DEFAULT_BLOCK_SERVE_CACHE << 20);
+CBlockFileMapCache blockFileMapCache(DEFAULT_BLOCKFILE_MAPS);
+CBlockFileAppender blockFileAppender;
+
 struct COrphanTx {
     CTransaction tx;
     NodeId fromPeer;
@@ -204,15 +218,24 @@ namespace {
         int64_t nTime;  //! Time of "getdata" request in microseconds.
         bool fValidatedHeaders;  //! Whether this block has validated headers at the time of request.
         int64_t nTimeDisconnect; //! The timeout for this block request (for disconnecting a slow peer)
+        std::shared_ptr<PartiallyDownloadedBlock> partialBlock;  //! Set while waiting for the rest of a compact block.
     };
     map<uint256, pair<NodeId, list<QueuedBlock>::iterator> > mapBlocksInFlight;
     
+    /** The compact block last pushed to peers for the tip, serialized once and shared between them. */
+    CCriticalSection cs_mostRecentCompactBlock;
+    uint256 hashMostRecentCompactBlock;
+    std::shared_ptr<const CPlainDataStream> pMostRecentCompactBlock;
+    
     /** Number of blocks in flight with validated headers. */
     int nQueuedValidatedHeaders = 0;
     
     /** Number of preferable block download peers. */
     int nPreferredDownload = 0;
     
+    /** Sum of the in-flight limits of all peers, the download window grows with it. */
+    int nBlocksInFlightLimitTotal = 0;
+    
     /** Dirty block index entries. */
     set<CBlockIndex*> setDirtyBlockIndex;
     
@@ -267,6 +290,24 @@ namespace {
         int nBlocksInFlightValidHeaders;
         //! Whether we consider this a preferred download peer.
         bool fPreferredDownload;
+        //! Compact blocks received from this peer.
+        int nCompactBlocks;
+        //! Compact blocks rebuilt from the mempool without asking for any transaction.
+        int nCompactBlocksReconstructed;
+        //! Transactions of compact blocks we had to request with "getblocktxn".
+        int nCompactBlockTxRequested;
+        //! How many blocks may be in flight from this peer, follows its download rate.
+        int nBlocksInFlightLimit;
+        //! Moving average of the rate this peer delivers requested blocks at in bytes per second, 0 until measured.
+        double dBlockBytesPerSec;
+        //! Moving average of the size of blocks from this peer.
+        double dBlockBytes;
+        //! Moving average of the time from "getdata" to the block arriving in microseconds.
+        int64_t nBlockLatency;
+        //! When the last requested block arrived from this peer (in microseconds).
+        int64_t nLastBlockDelivery;
+        //! Blocks requested from another peer because this one held up the download window.
+        int nBlocksReassigned;
         
         CNodeState() {
             fCurrentlyConnected = false;
@@ -280,6 +321,15 @@ namespace {
             nBlocksInFlight = 0;
             nBlocksInFlightValidHeaders = 0;
             fPreferredDownload = false;
+            nCompactBlocks = 0;
+            nCompactBlocksReconstructed = 0;
+            nCompactBlockTxRequested = 0;
+            nBlocksInFlightLimit = MAX_BLOCKS_IN_TRANSIT_PER_PEER;
+            dBlockBytesPerSec = 0;
+            dBlockBytes = 0;
+            nBlockLatency = 0;
+            nLastBlockDelivery = 0;
+            nBlocksReassigned = 0;
         }
     };
     
@@ -321,6 +371,7 @@ namespace {
         CNodeState &state = mapNodeState.insert(std::make_pair(nodeid, CNodeState())).first->second;
         state.name = pnode->addrName;
         state.address = pnode->addr;
+        nBlocksInFlightLimitTotal += state.nBlocksInFlightLimit;
     }
     
     void FinalizeNode(NodeId nodeid) {
@@ -338,6 +389,7 @@ namespace {
         mapBlocksInFlight.erase(entry.hash);
         EraseOrphansFor(nodeid);
         nPreferredDownload -= state->fPreferredDownload;
+        nBlocksInFlightLimitTotal -= state->nBlocksInFlightLimit;
         
         mapNodeState.erase(nodeid);
     }
@@ -388,6 +440,58 @@ namespace {
         mapBlocksInFlight[hash] = std::make_pair(nodeid, it);
     }
     
+    // Requires cs_main.
+    /** Measure the download rate of the peer a block was requested from, and size its in-flight limit to it. */
+    void UpdateBlockDownloadRate(NodeId nodeid, const uint256& hash, size_t nBytes) {
+        map<uint256, pair<NodeId, list<QueuedBlock>::iterator> >::iterator itInFlight = mapBlocksInFlight.find(hash);
+        if (itInFlight == mapBlocksInFlight.end() || itInFlight->second.first != nodeid)
+            return;
+        CNodeState *state = State(nodeid);
+        
+        // Peers send blocks one after the other, so this one was being worked on since it was requested
+        // or since the previous one arrived, whichever is later.
+        int64_t nNow = GetTimeMicros();
+        int64_t nRequested = itInFlight->second.second->nTime;
+        int64_t nElapsed = std::max<int64_t>(nNow - std::max(nRequested, state->nLastBlockDelivery), 1000);
+        double dRate = nBytes * 1000000.0 / nElapsed;
+        if (state->dBlockBytesPerSec == 0) {
+            state->dBlockBytesPerSec = dRate;
+            state->dBlockBytes = nBytes;
+            state->nBlockLatency = nNow - nRequested;
+        } else {
+            state->dBlockBytesPerSec += (dRate - state->dBlockBytesPerSec) / 8;
+            state->dBlockBytes += (nBytes - state->dBlockBytes) / 8;
+            state->nBlockLatency += (nNow - nRequested - state->nBlockLatency) / 8;
+        }
+        state->nLastBlockDelivery = nNow;
+        
+        int nLimit = GetBlocksInFlightLimit(state->dBlockBytesPerSec, state->dBlockBytes);
+        if (nLimit != state->nBlocksInFlightLimit) {
+            LogPrint("net", "Block download limit %d -> %d peer=%d (%.0f bytes/s, latency %dms)\n", state->nBlocksInFlightLimit,
+                     nLimit, nodeid, state->dBlockBytesPerSec, state->nBlockLatency / 1000);
+            nBlocksInFlightLimitTotal += nLimit - state->nBlocksInFlightLimit;
+            state->nBlocksInFlightLimit = nLimit;
+        }
+    }
+    
+    // Requires cs_main.
+    /**
+     * Whether a block holding up the download window should be requested from
+     * nodeid instead of the peer it is in flight from: it has been in flight for
+     * well over that peer's usual latency, and nodeid is measured to be faster.
+     */
+    bool ShouldReassignBlock(NodeId nodeid, NodeId nodeStaller, const uint256& hash, int64_t nNow) {
+        map<uint256, pair<NodeId, list<QueuedBlock>::iterator> >::iterator itInFlight = mapBlocksInFlight.find(hash);
+        if (itInFlight == mapBlocksInFlight.end() || itInFlight->second.first != nodeStaller || nodeStaller == nodeid)
+            return false;
+        CNodeState *state = State(nodeid);
+        CNodeState *stateStaller = State(nodeStaller);
+        int64_t nTimeout = std::max<int64_t>(1000000 * BLOCK_REASSIGN_TIMEOUT, 2 * stateStaller->nBlockLatency);
+        if (itInFlight->second.second->nTime > nNow - nTimeout)
+            return false;
+        return state->dBlockBytesPerSec > stateStaller->dBlockBytesPerSec;
+    }
+    
     /** Check whether the last unknown block a peer advertized is not yet known. */
     void ProcessBlockAvailability(NodeId nodeid) {
         CNodeState *state = State(nodeid);
@@ -444,7 +548,7 @@ namespace {
     
     /** Update pindexLastCommonBlock and add not-in-flight missing successors to vBlocks, until it has
      *  at most count entries. */
-    void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<CBlockIndex*>& vBlocks, NodeId& nodeStaller) {
+    void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<CBlockIndex*>& vBlocks, NodeId& nodeStaller, CBlockIndex*& pindexStalled) {
         if (count == 0)
             return;
         
@@ -474,12 +578,13 @@ namespace {
         
         std::vector<CBlockIndex*> vToFetch;
         CBlockIndex *pindexWalk = state->pindexLastCommonBlock;
-        // Never fetch further than the best block we know the peer has, or more than BLOCK_DOWNLOAD_WINDOW + 1 beyond the last
+        // Never fetch further than the best block we know the peer has, or more than GetBlockDownloadWindow() + 1 beyond the last
         // linked block we have in common with this peer. The +1 is so we can detect stalling, namely if we would be able to
         // download that next block if the window were 1 larger.
-        int nWindowEnd = state->pindexLastCommonBlock->nHeight + BLOCK_DOWNLOAD_WINDOW;
+        int nWindowEnd = state->pindexLastCommonBlock->nHeight + GetBlockDownloadWindow();
         int nMaxHeight = std::min<int>(state->pindexBestKnownBlock->nHeight, nWindowEnd + 1);
         NodeId waitingfor = -1;
+        CBlockIndex *pindexWaitingFor = NULL;
         while (pindexWalk->nHeight < nMaxHeight) {
             // Read up to 128 (or more, if more blocks than that are needed) successors of pindexWalk (towards
             // pindexBestKnownBlock) into vToFetch. We fetch 128, because CBlockIndex::GetAncestor may be as expensive
@@ -511,6 +616,7 @@ namespace {
                         if (vBlocks.size() == 0 && waitingfor != nodeid) {
                             // We aren't able to fetch anything, but we would be if the download window was one larger.
                             nodeStaller = waitingfor;
+                            pindexStalled = pindexWaitingFor;
                         }
                         return;
                     }
@@ -521,6 +627,7 @@ namespace {
                 } else if (waitingfor == -1) {
                     // This is the first already-in-flight block.
                     waitingfor = mapBlocksInFlight[pindex->GetBlockHash()].first;
+                    pindexWaitingFor = pindex;
                 }
             }
         }
@@ -540,9 +647,34 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
         if (queue.pindex)
             stats.vHeightInFlight.push_back(queue.pindex->nHeight);
     }
+    stats.nCompactBlocks = state->nCompactBlocks;
+    stats.nCompactBlocksReconstructed = state->nCompactBlocksReconstructed;
+    stats.nCompactBlockTxRequested = state->nCompactBlockTxRequested;
+    stats.nBlocksInFlightLimit = state->nBlocksInFlightLimit;
+    stats.nBlockBytesPerSec = state->dBlockBytesPerSec;
+    stats.nBlockLatency = state->nBlockLatency;
+    stats.nBlocksReassigned = state->nBlocksReassigned;
     return true;
 }
 
+int GetBlocksInFlightLimit(double dBytesPerSec, double dBlockBytes)
+{
+    if (dBytesPerSec <= 0 || dBlockBytes <= 0)
+        return MAX_BLOCKS_IN_TRANSIT_PER_PEER;
+    // Enough to keep the peer busy for a while, so its queue doesn't run dry between our requests
+    double dLimit = dBytesPerSec * BLOCK_DOWNLOAD_QUEUE_SECONDS / dBlockBytes;
+    return std::max<int>(MIN_BLOCKS_IN_TRANSIT_PER_PEER, std::min<double>(MAX_BLOCKS_IN_TRANSIT_PER_PEER_ADAPTIVE, dLimit));
+}
+
+int GetBlockDownloadWindow()
+{
+    // Keep the window wide enough for every peer to fill its limit. Pruning
+    // needs blocks stored close to in order, so it keeps the fixed window.
+    if (fPruneMode)
+        return BLOCK_DOWNLOAD_WINDOW;
+    return std::min<int>(BLOCK_DOWNLOAD_WINDOW_MAX, std::max<int>(BLOCK_DOWNLOAD_WINDOW, 4 * nBlocksInFlightLimitTotal));
+}
+
 void RegisterNodeSignals(CNodeSignals& nodeSignals)
 {
     nodeSignals.GetHeight.connect(&GetHeight);
@@ -1689,41 +1821,65 @@ bool GetTransaction(const uint256 &hash, CTransaction &txOut, uint256 &hashBlock
 
 bool WriteBlockToDisk(CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart)
 {
-    // Open history file to append
-    CAutoFile fileout(OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("WriteBlockToDisk: OpenBlockFile failed");
-    
-    // Write index header
-    unsigned int nSize = fileout.GetSerializeSize(block);
-    fileout << FLATDATA(messageStart) << nSize;
-    
-    // Write block
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0)
-        return error("WriteBlockToDisk: ftell failed");
-    pos.nPos = (unsigned int)fileOutPos;
-    fileout << block;
+    // Append index header and block to the history file
+    if (!blockFileAppender.Append(pos, "blk", messageStart, block))
+        return error("WriteBlockToDisk: write to %s failed", pos.ToString());
     
     return true;
 }
 
+/**
+ * Find the record at pos in the mapping of a blk or rev file, if that file is
+ * no longer appended to. Records are preceded by the message start and their
+ * size; nTrailer covers what follows the record, like the undo checksum.
+ * Returns NULL if the record has to be read from the file instead.
+ */
+static CBlockFileMapCache::Mapping MapDiskRecord(const CDiskBlockPos& pos, const char* prefix, size_t nTrailer, size_t& nRecordSize)
+{
+    // Undo data may still be appended to older rev files
+    blockFileAppender.Flush(pos, prefix);
+    {
+        LOCK(cs_LastBlockFile);
+        if (pos.IsNull() || pos.nFile >= nLastBlockFile)
+            return CBlockFileMapCache::Mapping();
+    }
+    CBlockFileMapCache::Mapping mapping = blockFileMapCache.Get(GetBlockPosFilename(pos, prefix));
+    const size_t nHeaderSize = MESSAGE_START_SIZE + sizeof(uint32_t);
+    if (!mapping || pos.nPos < nHeaderSize || pos.nPos > mapping->size())
+        return CBlockFileMapCache::Mapping();
+    const char* pheader = mapping->data() + pos.nPos - nHeaderSize;
+    if (memcmp(pheader, Params().MessageStart(), MESSAGE_START_SIZE) != 0)
+        return CBlockFileMapCache::Mapping();
+    nRecordSize = ReadLE32((const unsigned char*)pheader + MESSAGE_START_SIZE) + nTrailer;
+    // Appended to the file after it was mapped
+    if (nRecordSize > mapping->size() - pos.nPos)
+        return CBlockFileMapCache::Mapping();
+    mapping->WillNeed(pos.nPos, nRecordSize);
+    return mapping;
+}
+
 bool ReadBlockFromDisk(int32_t height,CBlock& block, const CDiskBlockPos& pos,bool checkPOW)
 {
     uint8_t pubkey33[33];
     block.SetNull();
     
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-    {
-        //fprintf(stderr,"readblockfromdisk err A\n");
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
-    }
-    
     // Read block
     try {
-        filein >> block;
+        size_t nSize;
+        CBlockFileMapCache::Mapping mapping = MapDiskRecord(pos, "blk", 0, nSize);
+        if (mapping) {
+            CMemoryReader filein(mapping->data() + pos.nPos, mapping->data() + pos.nPos + nSize, SER_DISK, CLIENT_VERSION);
+            filein >> block;
+        } else {
+            // Open history file to read
+            CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+            if (filein.IsNull())
+            {
+                //fprintf(stderr,"readblockfromdisk err A\n");
+                return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+            }
+            filein >> block;
+        }
     }
     catch (const std::exception& e) {
         fprintf(stderr,"readblockfromdisk err B\n");
@@ -1757,6 +1913,28 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex,bool checkPOW)
     return true;
 }
 
+bool GetBlockMinerPubKey(CBlockIndex *pindex, uint8_t *pubkey33)
+{
+    LOCK(cs_main);
+    if (!pindex->fMinerPubKey) {
+        std::vector<unsigned char> vch;
+        if (pblocktree != NULL && pblocktree->ReadMinerPubKey(pindex->GetBlockHash(), vch)) {
+            memcpy(pindex->minerPubKey33, vch.data(), 33);
+        } else {
+            // Indexed before the pubkey was kept, look it up once
+            CBlock block;
+            if (!(pindex->nStatus & BLOCK_HAVE_DATA) || komodo_blockload(block, pindex) != 0)
+                return false;
+            komodo_block2pubkey33(pindex->minerPubKey33, &block);
+            if (pblocktree != NULL)
+                pblocktree->WriteMinerPubKey(pindex->GetBlockHash(), std::vector<unsigned char>(pindex->minerPubKey33, pindex->minerPubKey33 + 33));
+        }
+        pindex->fMinerPubKey = true;
+    }
+    memcpy(pubkey33, pindex->minerPubKey33, 33);
+    return true;
+}
+
 //uint64_t komodo_moneysupply(int32_t height);
 extern char ASSETCHAINS_SYMBOL[KOMODO_ASSETCHAIN_MAXLEN];
 extern uint64_t ASSETCHAINS_ENDSUBSIDY[ASSETCHAINS_MAX_ERAS], ASSETCHAINS_REWARD[ASSETCHAINS_MAX_ERAS], ASSETCHAINS_HALVING[ASSETCHAINS_MAX_ERAS];
@@ -2233,43 +2411,38 @@ namespace {
     
     bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint256& hashBlock, const CMessageHeader::MessageStartChars& messageStart)
     {
-        // Open history file to append
-        CAutoFile fileout(OpenUndoFile(pos), SER_DISK, CLIENT_VERSION);
-        if (fileout.IsNull())
-            return error("%s: OpenUndoFile failed", __func__);
-        
-        // Write index header
-        unsigned int nSize = fileout.GetSerializeSize(blockundo);
-        fileout << FLATDATA(messageStart) << nSize;
-        
-        // Write undo data
-        long fileOutPos = ftell(fileout.Get());
-        if (fileOutPos < 0)
-            return error("%s: ftell failed", __func__);
-        pos.nPos = (unsigned int)fileOutPos;
-        fileout << blockundo;
-        
-        // calculate & write checksum
+        // calculate checksum
         CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
         hasher << hashBlock;
         hasher << blockundo;
-        fileout << hasher.GetHash();
+        uint256 hashChecksum = hasher.GetHash();
+        
+        // Append index header, undo data and checksum to the history file
+        if (!blockFileAppender.Append(pos, "rev", messageStart, blockundo, &hashChecksum))
+            return error("%s: write to %s failed", __func__, pos.ToString());
         
         return true;
     }
     
     bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashBlock)
     {
-        // Open history file to read
-        CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-        if (filein.IsNull())
-            return error("%s: OpenBlockFile failed", __func__);
-        
         // Read block
         uint256 hashChecksum;
         try {
-            filein >> blockundo;
-            filein >> hashChecksum;
+            size_t nSize;
+            CBlockFileMapCache::Mapping mapping = MapDiskRecord(pos, "rev", sizeof(hashChecksum), nSize);
+            if (mapping) {
+                CMemoryReader filein(mapping->data() + pos.nPos, mapping->data() + pos.nPos + nSize, SER_DISK, CLIENT_VERSION);
+                filein >> blockundo;
+                filein >> hashChecksum;
+            } else {
+                // Open history file to read
+                CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+                if (filein.IsNull())
+                    return error("%s: OpenBlockFile failed", __func__);
+                filein >> blockundo;
+                filein >> hashChecksum;
+            }
         }
         catch (const std::exception& e) {
             return error("%s: Deserialize or I/O error - %s", __func__, e.what());
@@ -2489,27 +2662,38 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
     return fClean;
 }
 
-void static FlushBlockFile(bool fFinalize = false)
+bool static FlushBlockFile(bool fFinalize = false)
 {
     LOCK(cs_LastBlockFile);
     
     CDiskBlockPos posOld(nLastBlockFile, 0);
     
+    // Everything appended since the last flush goes to disk first, undo data
+    // may have gone to older rev files as well.
+    bool fOk = blockFileAppender.Commit();
+    if (!fFinalize)
+        return fOk;
+    
+    // Never truncate a file under a mapping or with writes buffered
+    blockFileMapCache.Erase(GetBlockPosFilename(posOld, "blk"));
+    blockFileMapCache.Erase(GetBlockPosFilename(posOld, "rev"));
+    fOk &= blockFileAppender.Close(posOld, "blk");
+    fOk &= blockFileAppender.Close(posOld, "rev");
+    
     FILE *fileOld = OpenBlockFile(posOld);
     if (fileOld) {
-        if (fFinalize)
-            TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nSize);
+        TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nSize);
         FileCommit(fileOld);
         fclose(fileOld);
     }
     
     fileOld = OpenUndoFile(posOld);
     if (fileOld) {
-        if (fFinalize)
-            TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nUndoSize);
+        TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nUndoSize);
         FileCommit(fileOld);
         fclose(fileOld);
     }
+    return fOk;
 }
 
 bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos, unsigned int nAddSize);
@@ -3014,7 +3198,8 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode) {
             if (!CheckDiskSpace(0))
                 return state.Error("out of disk space");
             // First make sure all block and undo data is flushed to disk.
-            FlushBlockFile();
+            if (!FlushBlockFile())
+                return AbortNode(state, "Failed to write block files to disk");
             // Then update all block file information (which may refer to block and undo files).
             {
                 std::vector<std::pair<int, const CBlockFileInfo*> > vFiles;
@@ -3163,6 +3348,7 @@ bool static DisconnectTip(CValidationState &state, bool fBare = false) {
     
     // Update chainActive and related variables.
     UpdateTip(pindexDelete->pprev);
+    komodo_powwindow_disconnect(pindexDelete);
     // Get the current commitment tree
     ZCIncrementalMerkleTree newTree;
     assert(pcoinsTip->GetAnchorAt(pcoinsTip->GetBestAnchor(), newTree));
@@ -3245,6 +3431,10 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pindexNew, CBlock *
     
     // Update chainActive & related variables.
     UpdateTip(pindexNew);
+    komodo_powwindow_connect(pindexNew);
+    // Our peers are about to ask for this block, have it ready to send
+    if (!IsInitialBlockDownload())
+        recentBlockCache.Insert(pindexNew->GetBlockHash(), *pblock);
     // Tell wallet about transactions that went from mempool
     // to conflicted:
     BOOST_FOREACH(const CTransaction &tx, txConflicted) {
@@ -3495,10 +3685,35 @@ bool ActivateBestChain(CValidationState &state, CBlock *pblock) {
             // Don't relay blocks if pruning -- could cause a peer to try to download, resulting
             // in a stalled download if the block file is pruned before the request.
             if (nLocalServices & NODE_NETWORK) {
+                // Peers that asked for it get the new tip pushed as a compact
+                // block right away, instead of an inv they have to answer with
+                // getheaders and getdata. It is built and serialized only once.
+                std::shared_ptr<const CPlainDataStream> pcmpctblock;
+                if ((nLocalServices & NODE_COMPACT_BLOCKS) && pblock && pblock->GetHash() == hashNewTip) {
+                    std::shared_ptr<CPlainDataStream> ss = std::make_shared<CPlainDataStream>(SER_NETWORK, PROTOCOL_VERSION);
+                    *ss << CBlockHeaderAndShortTxIDs(*pblock);
+                    pcmpctblock = ss;
+                    LOCK(cs_mostRecentCompactBlock);
+                    hashMostRecentCompactBlock = hashNewTip;
+                    pMostRecentCompactBlock = pcmpctblock;
+                }
+                CInv inv(MSG_BLOCK, hashNewTip);
                 LOCK(cs_vNodes);
                 BOOST_FOREACH(CNode* pnode, vNodes)
-                if (chainActive.Height() > (pnode->nStartingHeight != -1 ? pnode->nStartingHeight - 2000 : nBlockEstimate))
-                    pnode->PushInventory(CInv(MSG_BLOCK, hashNewTip));
+                if (chainActive.Height() > (pnode->nStartingHeight != -1 ? pnode->nStartingHeight - 2000 : nBlockEstimate)) {
+                    if (pcmpctblock && pnode->fPreferCompactBlocks) {
+                        // Skip the peer we got the block from
+                        bool fNew;
+                        {
+                            LOCK(pnode->cs_inventory);
+                            fNew = pnode->setInventoryKnown.insert(inv).second;
+                        }
+                        if (fNew)
+                            pnode->PushMessage("cmpctblock", *pcmpctblock);
+                    } else {
+                        pnode->PushInventory(inv);
+                    }
+                }
             }
             // Notify external listeners about the new tip.
             GetMainSignals().UpdatedBlockTip(pindexNewTip);
@@ -3610,8 +3825,7 @@ CBlockIndex* AddToBlockIndex(const CBlockHeader& block)
         }
     }
     // Construct new block index object
-    CBlockIndex* pindexNew = new CBlockIndex(block);
-    assert(pindexNew);
+    CBlockIndex* pindexNew = blockIndexArena.Allocate(block);
     // We assign the sequence id to blocks only when the full data is available,
     // to avoid miners withholding blocks but broadcasting headers, to get a
     // competitive advantage.
@@ -3724,7 +3938,8 @@ bool FindBlockPos(CValidationState &state, CDiskBlockPos &pos, unsigned int nAdd
         if (!fKnown) {
             LogPrintf("Leaving block file %i: %s\n", nFile, vinfoBlockFile[nFile].ToString());
         }
-        FlushBlockFile(!fKnown);
+        if (!FlushBlockFile(!fKnown))
+            return AbortNode(state, "Failed to write block files to disk");
         nLastBlockFile = nFile;
     }
     
@@ -4221,6 +4436,9 @@ bool AcceptBlock(int32_t *futureblockp,CBlock& block, CValidationState& state, C
                 AbortNode(state, "Failed to write block");
         if (!ReceivedBlockTransactions(block, state, pindex, blockPos))
             return error("AcceptBlock(): ReceivedBlockTransactions failed");
+        // Keep the miner's pubkey for the notary checks, it is persisted with the index entry
+        komodo_block2pubkey33(pindex->minerPubKey33, (CBlock *)&block);
+        pindex->fMinerPubKey = true;
     } catch (const std::runtime_error& e) {
         return AbortNode(state, std::string("System error: ") + e.what());
     }
@@ -4279,9 +4497,7 @@ CBlockIndex *oldkomodo_ensure(CBlock *pblock,uint256 hash)
     CBlockIndex *pindex=0,*previndex=0;
     if ( (pindex= mapBlockIndex[hash]) == 0 )
     {
-        pindex = new CBlockIndex();
-        if (!pindex)
-            throw runtime_error("komodo_ensure: new CBlockIndex failed");
+        pindex = blockIndexArena.Allocate();
         BlockMap::iterator mi = mapBlockIndex.insert(make_pair(hash, pindex)).first;
         pindex->phashBlock = &((*mi).first);
     }
@@ -4371,6 +4587,9 @@ bool ProcessNewBlock(bool from_miner,int32_t height,CValidationState &state, CNo
         //else fprintf(stderr,"added block %s %p\n",pindex->GetBlockHash().ToString().c_str(),pindex->pprev);
     }
     
+    // Don't let slow asynchronous notifiers fall arbitrarily far behind
+    LimitValidationInterfaceQueue();
+
     if (futureblock == 0 && !ActivateBestChain(state, pblock))
         return error("%s: ActivateBestChain failed", __func__);
     
@@ -4467,6 +4686,8 @@ void UnlinkPrunedFiles(std::set<int>& setFilesToPrune)
 {
     for (set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         CDiskBlockPos pos(*it, 0);
+        blockFileMapCache.Erase(GetBlockPosFilename(pos, "blk"));
+        blockFileMapCache.Erase(GetBlockPosFilename(pos, "rev"));
         boost::filesystem::remove(GetBlockPosFilename(pos, "blk"));
         boost::filesystem::remove(GetBlockPosFilename(pos, "rev"));
         LogPrintf("Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
@@ -4536,6 +4757,8 @@ FILE* OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
     static int32_t didinit[64];
     if (pos.IsNull())
         return NULL;
+    // Whoever opens the file sees everything appended to it so far
+    blockFileAppender.Flush(pos, prefix);
     boost::filesystem::path path = GetBlockPosFilename(pos, prefix);
     boost::filesystem::create_directories(path.parent_path());
     FILE* file = fopen(path.string().c_str(), "rb+");
@@ -4584,9 +4807,7 @@ CBlockIndex * InsertBlockIndex(uint256 hash)
         return (*mi).second;
     
     // Create new
-    CBlockIndex* pindexNew = new CBlockIndex();
-    if (!pindexNew)
-        throw runtime_error("LoadBlockIndex(): new CBlockIndex failed");
+    CBlockIndex* pindexNew = blockIndexArena.Allocate();
     mi = mapBlockIndex.insert(make_pair(hash, pindexNew)).first;
     pindexNew->phashBlock = &((*mi).first);
     //fprintf(stderr,"inserted to block index %s\n",hash.ToString().c_str());
@@ -4764,6 +4985,113 @@ bool static LoadBlockIndexDB()
     return true;
 }
 
+namespace {
+
+/**
+ * Reads the blocks CVerifyDB walks over on worker threads, ahead of the walk,
+ * and does the checks that need no chain state: the merkle root at level 1 and
+ * reading back the undo data at level 2. At most a few blocks per thread are
+ * held in memory at once.
+ */
+class CVerifyDBReadAhead
+{
+public:
+    struct Entry
+    {
+        CBlock block;
+        bool fRead = false;
+        bool fMerkleRoot = false;
+        bool fUndo = false;
+    };
+
+private:
+    static const size_t BLOCKS_PER_THREAD = 4;
+
+    const std::vector<CBlockIndex*>& vIndex;
+    const int nCheckLevel;
+    const size_t nWindow;
+
+    std::mutex cs;
+    std::condition_variable cvReady;
+    std::condition_variable cvSpace;
+    std::vector<std::unique_ptr<Entry>> vEntries;
+    size_t nNext = 0;
+    size_t nConsumed = 0;
+    bool fStop = false;
+    std::vector<std::thread> threads;
+
+    void Check(const CBlockIndex* pindex, Entry& entry)
+    {
+        entry.fRead = ReadBlockFromDisk(entry.block, pindex, 0);
+        if (!entry.fRead)
+            return;
+        if (nCheckLevel >= 1) {
+            bool mutated;
+            uint256 hashMerkleRoot = entry.block.BuildMerkleTree(&mutated);
+            entry.fMerkleRoot = hashMerkleRoot == entry.block.hashMerkleRoot && !mutated;
+        }
+        if (nCheckLevel >= 2) {
+            CBlockUndo undo;
+            CDiskBlockPos pos = pindex->GetUndoPos();
+            entry.fUndo = pos.IsNull() || UndoReadFromDisk(undo, pos, pindex->pprev->GetBlockHash());
+        }
+    }
+
+    void Run()
+    {
+        while (true) {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock(cs);
+                cvSpace.wait(lock, [this] { return fStop || nNext >= vIndex.size() || nNext < nConsumed + nWindow; });
+                if (fStop || nNext >= vIndex.size())
+                    return;
+                i = nNext++;
+            }
+            std::unique_ptr<Entry> entry(new Entry());
+            Check(vIndex[i], *entry);
+            {
+                std::unique_lock<std::mutex> lock(cs);
+                vEntries[i] = std::move(entry);
+            }
+            cvReady.notify_all();
+        }
+    }
+
+public:
+    CVerifyDBReadAhead(const std::vector<CBlockIndex*>& vIndexIn, int nCheckLevelIn, int nThreads) :
+        vIndex(vIndexIn), nCheckLevel(nCheckLevelIn), nWindow(BLOCKS_PER_THREAD * nThreads), vEntries(vIndexIn.size())
+    {
+        for (int i = 0; i < nThreads; i++)
+            threads.emplace_back(&CVerifyDBReadAhead::Run, this);
+    }
+
+    ~CVerifyDBReadAhead()
+    {
+        {
+            std::unique_lock<std::mutex> lock(cs);
+            fStop = true;
+        }
+        cvSpace.notify_all();
+        for (std::thread& t : threads)
+            t.join();
+    }
+
+    /** Wait for the i'th block of the walk, and let the workers move past it */
+    std::unique_ptr<Entry> Get(size_t i)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        cvReady.wait(lock, [this, i] { return vEntries[i] != nullptr; });
+        std::unique_ptr<Entry> entry = std::move(vEntries[i]);
+        nConsumed = i + 1;
+        lock.unlock();
+        cvSpace.notify_all();
+        return entry;
+    }
+};
+
+}
+
 CVerifyDB::CVerifyDB()
 {
     uiInterface.ShowProgress(_("Verifying blocks..."), 0);
@@ -4795,29 +5123,30 @@ bool CVerifyDB::VerifyDB(CCoinsView *coinsview, int nCheckLevel, int nCheckDepth
     // No need to verify JoinSplits twice
     auto verifier = libzcash::ProofVerifier::Disabled();
     //fprintf(stderr,"start VerifyDB %u\n",(uint32_t)time(NULL));
-    for (CBlockIndex* pindex = chainActive.Tip(); pindex && pindex->pprev; pindex = pindex->pprev)
-    {
+    int64_t nStart = GetTimeMillis();
+    std::vector<CBlockIndex*> vIndex;
+    for (CBlockIndex* pindex = chainActive.Tip(); pindex && pindex->pprev && pindex->nHeight >= chainActive.Height()-nCheckDepth; pindex = pindex->pprev)
+        vIndex.push_back(pindex);
+    // Reading, hashing and the context-free checks run ahead on the -par threads;
+    // the checks that need chain state run here, in order
+    CVerifyDBReadAhead readAhead(vIndex, nCheckLevel, std::max(nScriptCheckThreads, 1));
+    for (size_t i = 0; i < vIndex.size(); i++)
+    {
+        CBlockIndex* pindex = vIndex[i];
         boost::this_thread::interruption_point();
         uiInterface.ShowProgress(_("Verifying blocks..."), std::max(1, std::min(99, (int)(((double)(chainActive.Height() - pindex->nHeight)) / (double)nCheckDepth * (nCheckLevel >= 4 ? 50 : 100)))));
-        if (pindex->nHeight < chainActive.Height()-nCheckDepth)
-            break;
-        CBlock block;
+        std::unique_ptr<CVerifyDBReadAhead::Entry> entry = readAhead.Get(i);
+        CBlock& block = entry->block;
         // check level 0: read from disk
-        if (!ReadBlockFromDisk(block, pindex,0))
+        if (!entry->fRead)
             return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
-        // check level 1: verify block validity
+        // check level 1: verify block validity, the merkle root was checked ahead
         int32_t futureblock;
-        if (nCheckLevel >= 1 && !CheckBlock(&futureblock,pindex->nHeight,pindex,block, state, verifier,0) )
+        if (nCheckLevel >= 1 && (!entry->fMerkleRoot || !CheckBlock(&futureblock,pindex->nHeight,pindex,block, state, verifier,0,false)) )
             return error("VerifyDB(): *** found bad block at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
         // check level 2: verify undo validity
-        if (nCheckLevel >= 2 && pindex) {
-            CBlockUndo undo;
-            CDiskBlockPos pos = pindex->GetUndoPos();
-            if (!pos.IsNull()) {
-                if (!UndoReadFromDisk(undo, pos, pindex->pprev->GetBlockHash()))
-                    return error("VerifyDB(): *** found bad undo data at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
-            }
-        }
+        if (nCheckLevel >= 2 && !entry->fUndo)
+            return error("VerifyDB(): *** found bad undo data at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
         // check level 3: check for inconsistencies during memory-only disconnect of tip blocks
         if (nCheckLevel >= 3 && pindex == pindexState && (coins.DynamicMemoryUsage() + pcoinsTip->DynamicMemoryUsage()) <= nCoinCacheUsage) {
             bool fClean = true;
@@ -4833,6 +5162,7 @@ bool CVerifyDB::VerifyDB(CCoinsView *coinsview, int nCheckLevel, int nCheckDepth
         if (ShutdownRequested())
             return true;
     }
+    LogPrintf("Checked %u blocks at level %i in %.2fs\n", vIndex.size(), std::min(nCheckLevel, 3), (GetTimeMillis() - nStart) * 0.001);
     //fprintf(stderr,"end VerifyDB %u\n",(uint32_t)time(NULL));
     if (pindexFailure)
         return error("VerifyDB(): *** coin database inconsistencies found (last %i blocks, %i good transactions before that)\n", chainActive.Height() - pindexFailure->nHeight + 1, nGoodTransactions);
@@ -5006,6 +5336,8 @@ void UnloadBlockIndex()
     mapBlocksUnlinked.clear();
     vinfoBlockFile.clear();
     nLastBlockFile = 0;
+    blockFileMapCache.Clear();
+    blockFileAppender.CloseAll();
     nBlockSequenceId = 1;
     mapBlockSource.clear();
     mapBlocksInFlight.clear();
@@ -5016,10 +5348,8 @@ void UnloadBlockIndex()
     mapNodeState.clear();
     recentRejects.reset(NULL);
     
-    BOOST_FOREACH(BlockMap::value_type& entry, mapBlockIndex) {
-        delete entry.second;
-    }
     mapBlockIndex.clear();
+    blockIndexArena.Clear();
     fHavePruned = false;
 }
 
@@ -5094,22 +5424,84 @@ bool InitBlockIndex() {
 
 
 
-bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos *dbp)
+namespace {
+
+/** A block found in an external block file, deserialized and hashed on a worker thread */
+struct CExternalBlock
 {
-    const CChainParams& chainparams = Params();
-    // Map of disk positions for blocks with unknown parent (only used for reindex)
-    static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
-    int64_t nStart = GetTimeMillis();
-    
-    int nLoaded = 0;
-    try {
-        // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
-        //CBufferedFile blkdat(fileIn, 2*MAX_BLOCK_SIZE, MAX_BLOCK_SIZE+8, SER_DISK, CLIENT_VERSION);
-        CBufferedFile blkdat(fileIn, 32*MAX_BLOCK_SIZE, MAX_BLOCK_SIZE+8, SER_DISK, CLIENT_VERSION);
-        uint64_t nRewind = blkdat.GetPos();
-        while (!blkdat.eof()) {
-            boost::this_thread::interruption_point();
-            
+    uint64_t nHeaderRewind; //! where to resume scanning if the block doesn't deserialize
+    uint64_t nBlockPos;     //! position of the block data, after the magic and size
+    uint64_t nSize;         //! size given in the file
+    uint64_t nEnd;          //! position the block actually ended at
+    CPlainDataStream raw;
+    CBlock block;
+    bool fParsed;
+    std::string strError;
+
+    CExternalBlock() : nHeaderRewind(0), nBlockPos(0), nSize(0), nEnd(0), raw(SER_DISK, CLIENT_VERSION), fParsed(false) {}
+};
+
+void ParseExternalBlocks(std::vector<CExternalBlock>& vBlocks, int nThreads)
+{
+    auto parseRange = [&vBlocks](size_t nBegin, size_t nEnd) {
+        for (size_t i = nBegin; i < nEnd; i++) {
+            CExternalBlock& candidate = vBlocks[i];
+            if (!candidate.strError.empty())
+                continue;
+            try {
+                candidate.raw >> candidate.block;
+                candidate.nEnd = candidate.nBlockPos + candidate.nSize - candidate.raw.size();
+                candidate.block.GetHash();
+                candidate.fParsed = true;
+            } catch (const std::exception& e) {
+                candidate.strError = e.what();
+            }
+        }
+    };
+
+    size_t nChunks = std::min<size_t>(std::max(nThreads, 1), vBlocks.size());
+    if (nChunks <= 1) {
+        parseRange(0, vBlocks.size());
+        return;
+    }
+    size_t nPerChunk = (vBlocks.size() + nChunks - 1) / nChunks;
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nChunks; i++)
+        threads.emplace_back(parseRange, std::min(vBlocks.size(), i * nPerChunk), std::min(vBlocks.size(), (i + 1) * nPerChunk));
+    parseRange(0, std::min(vBlocks.size(), nPerChunk));
+    for (std::thread& t : threads)
+        t.join();
+}
+
+/**
+ * Finds the blocks in an external block file by their magic and size, and
+ * hands their raw bytes to worker threads to deserialize and hash, a batch at
+ * a time. The next batch is read and parsed while the previous one is being
+ * processed, so importing is held up by connecting blocks, not by parsing.
+ */
+class CExternalBlockReader
+{
+private:
+    static const size_t MAX_BATCH_BLOCKS = 256;
+    static const uint64_t MAX_BATCH_BYTES = 8 * MAX_BLOCK_SIZE;
+
+    CBufferedFile& blkdat;
+    int nThreads;
+    uint64_t nRewind;
+    bool fEnd;
+
+    std::vector<CExternalBlock> vNext;
+    std::thread parser;
+
+    void ReadBatch(std::vector<CExternalBlock>& vBatch)
+    {
+        vBatch.clear();
+        uint64_t nBytes = 0;
+        while (!fEnd && vBatch.size() < MAX_BATCH_BLOCKS && nBytes < MAX_BATCH_BYTES) {
+            if (blkdat.eof()) {
+                fEnd = true;
+                break;
+            }
             blkdat.SetPos(nRewind);
             nRewind++; // start one byte further next time, in case of failure
             blkdat.SetLimit(); // remove former limit
@@ -5128,18 +5520,110 @@ bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos *dbp)
                     continue;
             } catch (const std::exception&) {
                 // no valid block header found; don't complain
+                fEnd = true;
                 break;
             }
+            vBatch.push_back(CExternalBlock());
+            CExternalBlock& candidate = vBatch.back();
+            candidate.nHeaderRewind = nRewind;
+            candidate.nBlockPos = blkdat.GetPos();
+            candidate.nSize = nSize;
             try {
-                // read block
-                uint64_t nBlockPos = blkdat.GetPos();
-                if (dbp)
-                    dbp->nPos = nBlockPos;
-                blkdat.SetLimit(nBlockPos + nSize);
-                blkdat.SetPos(nBlockPos);
-                CBlock block;
-                blkdat >> block;
+                blkdat.SetLimit(candidate.nBlockPos + nSize);
+                candidate.raw.resize(nSize);
+                blkdat.read(&candidate.raw[0], nSize);
                 nRewind = blkdat.GetPos();
+                nBytes += nSize;
+            } catch (const std::exception& e) {
+                // rescanning after the header is the caller's call, once it gets here
+                candidate.strError = e.what();
+                candidate.raw.clear();
+                break;
+            }
+        }
+    }
+
+    void StartNext()
+    {
+        ReadBatch(vNext);
+        parser = std::thread(ParseExternalBlocks, std::ref(vNext), nThreads);
+    }
+
+    void JoinNext()
+    {
+        if (parser.joinable())
+            parser.join();
+    }
+
+public:
+    CExternalBlockReader(CBufferedFile& blkdatIn, int nThreadsIn) :
+        blkdat(blkdatIn), nThreads(nThreadsIn), nRewind(blkdatIn.GetPos()), fEnd(false)
+    {
+        StartNext();
+    }
+
+    ~CExternalBlockReader()
+    {
+        JoinNext();
+    }
+
+    /** Take the next batch of parsed blocks, in file order; false once the file is exhausted */
+    bool Next(std::vector<CExternalBlock>& vBatch)
+    {
+        JoinNext();
+        vBatch.swap(vNext);
+        if (vBatch.empty())
+            return false;
+        StartNext();
+        return true;
+    }
+
+    /**
+     * Scan again from nPos, when a block didn't deserialize or ended early.
+     * The batch read ahead of it is dropped.
+     */
+    void Rewind(uint64_t nPos)
+    {
+        JoinNext();
+        vNext.clear();
+        if (!blkdat.SetPos(nPos) && !blkdat.Seek(nPos))
+            throw std::runtime_error("LoadExternalBlockFile: cannot rewind the block file");
+        nRewind = nPos;
+        fEnd = false;
+        StartNext();
+    }
+};
+
+}
+
+bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos *dbp)
+{
+    const CChainParams& chainparams = Params();
+    // Map of disk positions for blocks with unknown parent (only used for reindex)
+    static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
+    int64_t nStart = GetTimeMillis();
+    
+    int nLoaded = 0;
+    try {
+        // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
+        //CBufferedFile blkdat(fileIn, 2*MAX_BLOCK_SIZE, MAX_BLOCK_SIZE+8, SER_DISK, CLIENT_VERSION);
+        CBufferedFile blkdat(fileIn, 32*MAX_BLOCK_SIZE, MAX_BLOCK_SIZE+8, SER_DISK, CLIENT_VERSION);
+        // Blocks are deserialized and hashed on the -par threads, and processed here in file order
+        CExternalBlockReader reader(blkdat, std::max(nScriptCheckThreads, 1));
+        std::vector<CExternalBlock> vBatch;
+        bool fError = false;
+        while (!fError && reader.Next(vBatch)) {
+            for (CExternalBlock& candidate : vBatch) {
+                boost::this_thread::interruption_point();
+                
+                if (!candidate.fParsed) {
+                    LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, candidate.strError);
+                    reader.Rewind(candidate.nHeaderRewind);
+                    break;
+                }
+                if (dbp)
+                    dbp->nPos = candidate.nBlockPos;
+                CBlock& block = candidate.block;
                 
                 // detect out of order blocks, and store them for later
                 uint256 hash = block.GetHash();
@@ -5148,46 +5632,55 @@ bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos *dbp)
                              block.hashPrevBlock.ToString());
                     if (dbp)
                         mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
-                    continue;
-                }
-                
-                // process in case the block isn't known yet
-                if (mapBlockIndex.count(hash) == 0 || (mapBlockIndex[hash]->nStatus & BLOCK_HAVE_DATA) == 0) {
-                    CValidationState state;
-                    if (ProcessNewBlock(0,0,state, NULL, &block, true, dbp))
-                        nLoaded++;
-                    if (state.IsError())
-                        break;
-                } else if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex[hash]->nHeight % 1000 == 0) {
-                    LogPrintf("Block Import: already had block %s at height %d\n", hash.ToString(), mapBlockIndex[hash]->nHeight);
-                }
-                
-                // Recursively process earlier encountered successors of this block
-                deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
-                        if (ReadBlockFromDisk(mapBlockIndex[hash]!=0?mapBlockIndex[hash]->nHeight:0,block, it->second,1))
-                        {
-                            LogPrintf("%s: Processing out of order child %s of %s\n", __func__, block.GetHash().ToString(),
-                                      head.ToString());
-                            CValidationState dummy;
-                            if (ProcessNewBlock(0,0,dummy, NULL, &block, true, &it->second))
-                            {
+                } else {
+                    try {
+                        // process in case the block isn't known yet
+                        if (mapBlockIndex.count(hash) == 0 || (mapBlockIndex[hash]->nStatus & BLOCK_HAVE_DATA) == 0) {
+                            CValidationState state;
+                            if (ProcessNewBlock(0,0,state, NULL, &block, true, dbp))
                                 nLoaded++;
-                                queue.push_back(block.GetHash());
+                            if (state.IsError()) {
+                                fError = true;
+                                break;
                             }
+                        } else if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex[hash]->nHeight % 1000 == 0) {
+                            LogPrintf("Block Import: already had block %s at height %d\n", hash.ToString(), mapBlockIndex[hash]->nHeight);
                         }
-                        range.first++;
-                        mapBlocksUnknownParent.erase(it);
+                        
+                        // Recursively process earlier encountered successors of this block
+                        deque<uint256> queue;
+                        queue.push_back(hash);
+                        while (!queue.empty()) {
+                            uint256 head = queue.front();
+                            queue.pop_front();
+                            std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
+                            while (range.first != range.second) {
+                                std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
+                                if (ReadBlockFromDisk(mapBlockIndex[hash]!=0?mapBlockIndex[hash]->nHeight:0,block, it->second,1))
+                                {
+                                    LogPrintf("%s: Processing out of order child %s of %s\n", __func__, block.GetHash().ToString(),
+                                              head.ToString());
+                                    CValidationState dummy;
+                                    if (ProcessNewBlock(0,0,dummy, NULL, &block, true, &it->second))
+                                    {
+                                        nLoaded++;
+                                        queue.push_back(block.GetHash());
+                                    }
+                                }
+                                range.first++;
+                                mapBlocksUnknownParent.erase(it);
+                            }
+                        }
+                    } catch (const std::exception& e) {
+                        LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
                     }
                 }
-            } catch (const std::exception& e) {
-                LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+                
+                // a block shorter than its given size may be followed by another one inside it
+                if (candidate.nEnd != candidate.nBlockPos + candidate.nSize) {
+                    reader.Rewind(candidate.nEnd);
+                    break;
+                }
             }
         }
     } catch (const std::runtime_error& e) {
@@ -5503,7 +5996,7 @@ void static ProcessGetData(CNode* pfrom)
             boost::this_thread::interruption_point();
             it++;
             
-            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK)
+            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK || inv.type == MSG_CMPCT_BLOCK)
             {
                 bool send = false;
                 BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
@@ -5528,22 +6021,43 @@ void static ProcessGetData(CNode* pfrom)
                 // it's available before trying to send.
                 if (send && (mi->second->nStatus & BLOCK_HAVE_DATA))
                 {
-                    // Send block from disk
-                    CBlock block;
-                    if (!ReadBlockFromDisk(block, (*mi).second,1))
+                    // Compact blocks are only worth it for blocks whose transactions
+                    // the peer is likely to have in its mempool
+                    bool fCompact = inv.type == MSG_CMPCT_BLOCK && mi->second->nHeight > chainActive.Height() - MAX_CMPCTBLOCK_DEPTH;
+                    CRecentBlockCache::Entry cached;
+                    if (fCompact)
+                    {
+                        LOCK(cs_mostRecentCompactBlock);
+                        if (hashMostRecentCompactBlock == inv.hash)
+                            cached = pMostRecentCompactBlock;
+                    }
+                    else if (inv.type != MSG_FILTERED_BLOCK)
+                        cached = recentBlockCache.Get(inv.hash);
+                    if (cached)
                     {
-                        assert(!"cannot load block from disk");
+                        // Already serialized, and shared with every other peer asking for it
+                        pfrom->PushMessage(fCompact ? "cmpctblock" : "block", *cached);
                     }
                     else
                     {
-                        if (inv.type == MSG_BLOCK)
+                        // Send block from disk
+                        CBlock block;
+                        if (!ReadBlockFromDisk(block, (*mi).second,1))
+                        {
+                            assert(!"cannot load block from disk");
+                        }
+                        else if (fCompact)
                         {
-                            //uint256 hash; int32_t z;
-                            //hash = block.GetHash();
-                            //for (z=31; z>=0; z--)
-                            //    fprintf(stderr,"%02x",((uint8_t *)&hash)[z]);
-                            //fprintf(stderr," send block %d\n",komodo_block2height(&block));
-                            pfrom->PushMessage("block", block);
+                            pfrom->PushMessage("cmpctblock", CBlockHeaderAndShortTxIDs(block));
+                        }
+                        else if (inv.type == MSG_BLOCK || inv.type == MSG_CMPCT_BLOCK)
+                        {
+                            // Keep blocks near the tip around for the next peer, but
+                            // don't let a peer syncing old blocks churn the cache
+                            if (mi->second->nHeight > chainActive.Height() - BLOCK_SERVE_CACHE_DEPTH)
+                                pfrom->PushMessage("block", *recentBlockCache.Insert(inv.hash, block));
+                            else
+                                pfrom->PushMessage("block", block);
                         }
                         else // MSG_FILTERED_BLOCK)
                         {
@@ -5793,6 +6307,14 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
             LOCK(cs_main);
             State(pfrom->GetId())->fCurrentlyConnected = true;
         }
+        
+        if ((nLocalServices & NODE_COMPACT_BLOCKS) && (pfrom->nServices & NODE_COMPACT_BLOCKS) &&
+            pfrom->nVersion >= SHORT_IDS_BLOCKS_VERSION) {
+            // Ask the peer to push new blocks to us as compact blocks, version 1
+            bool fAnnounceUsingCMPCTBLOCK = true;
+            uint64_t nCMPCTBLOCKVersion = 1;
+            pfrom->PushMessage("sendcmpct", fAnnounceUsingCMPCTBLOCK, nCMPCTBLOCKVersion);
+        }
     }
     
     
@@ -5920,8 +6442,13 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
                     pfrom->PushMessage("getheaders", chainActive.GetLocator(pindexBestHeader), inv.hash);
                     CNodeState *nodestate = State(pfrom->GetId());
                     if (chainActive.Tip()->GetBlockTime() > GetAdjustedTime() - chainparams.GetConsensus().nPowTargetSpacing * 20 &&
-                        nodestate->nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
-                        vToFetch.push_back(inv);
+                        nodestate->nBlocksInFlight < nodestate->nBlocksInFlightLimit) {
+                        // A peer that speaks compact blocks sends the block as
+                        // one, and we only fetch what our mempool is missing
+                        if (pfrom->fSupportsCompactBlocks)
+                            vToFetch.push_back(CInv(MSG_CMPCT_BLOCK, inv.hash));
+                        else
+                            vToFetch.push_back(inv);
                         // Mark block as in flight already, even though the actual "getdata" message only goes out
                         // later (within the same cs_main lock, though).
                         MarkBlockAsInFlight(pfrom->GetId(), inv.hash, chainparams.GetConsensus());
@@ -6038,9 +6565,6 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
             pfrom->lasthdrsreq = (int32_t)(pindex ? pindex->nHeight : -1);
             for (; pindex; pindex = chainActive.Next(pindex))
             {
-                CBlockHeader h = pindex->GetBlockHeader();
-                //printf("size.%i, solution size.%i\n", (int)sizeof(h), (int)h.nSolution.size());
-                //printf("hash.%s prevhash.%s nonce.%s\n", h.GetHash().ToString().c_str(), h.hashPrevBlock.ToString().c_str(), h.nNonce.ToString().c_str());
                 vHeaders.push_back(pindex->GetBlockHeader());
                 if (--nLimit <= 0 || pindex->GetBlockHash() == hashStop)
                     break;
@@ -6200,6 +6724,29 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
             vRecv >> headers[n];
             ReadCompactSize(vRecv); // ignore tx count; assume it is 0.
         }
+
+        // Hashing the headers and checking their solutions dominates header sync,
+        // do both on the -par threads before taking cs_main; AcceptBlockHeader
+        // then finds them memoized. Headers we already have are accepted without
+        // a check, so their solutions are left alone: a peer replaying known
+        // headers must not make us verify them. Only a continuous chain that
+        // connects to a header we know is checked ahead, anything else goes
+        // through AcceptBlockHeader one by one and stops at the first failure.
+        CBlockHeader::PrecomputeHashes(headers, nScriptCheckThreads);
+        std::vector<CBlockHeader> vNewHeaders;
+        {
+            LOCK(cs_main);
+            bool fConnected = !headers.empty() && mapBlockIndex.count(headers[0].hashPrevBlock) != 0;
+            for (size_t i = 1; fConnected && i < headers.size(); i++)
+                fConnected = headers[i].hashPrevBlock == headers[i - 1].GetHash();
+            if (fConnected) {
+                BOOST_FOREACH(const CBlockHeader& header, headers) {
+                    if (mapBlockIndex.count(header.GetHash()) == 0)
+                        vNewHeaders.push_back(header);
+                }
+            }
+        }
+        CheckEquihashSolutions(vNewHeaders, Params(), nScriptCheckThreads);
         
         LOCK(cs_main);
         
@@ -6252,11 +6799,17 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
     else if (strCommand == "block" && !fImporting && !fReindex) // Ignore blocks received while importing
     {
         CBlock block;
+        size_t nBytes = vRecv.size();
         vRecv >> block;
         
         CInv inv(MSG_BLOCK, block.GetHash());
         LogPrint("net", "received block %s peer=%d\n", inv.hash.ToString(), pfrom->id);
         
+        {
+            LOCK(cs_main);
+            UpdateBlockDownloadRate(pfrom->GetId(), inv.hash, nBytes);
+        }
+        
         pfrom->AddInventoryKnown(inv);
         
         CValidationState state;
@@ -6279,6 +6832,221 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
     }
     
     
+    else if (strCommand == "sendcmpct")
+    {
+        bool fAnnounceUsingCMPCTBLOCK = false;
+        uint64_t nCMPCTBLOCKVersion = 0;
+        vRecv >> fAnnounceUsingCMPCTBLOCK >> nCMPCTBLOCKVersion;
+        // Other versions are encodings we don't know, keep using full blocks with this peer
+        if (nCMPCTBLOCKVersion == 1 && (nLocalServices & NODE_COMPACT_BLOCKS)) {
+            pfrom->fSupportsCompactBlocks = true;
+            pfrom->fPreferCompactBlocks = fAnnounceUsingCMPCTBLOCK;
+        }
+    }
+    
+    
+    else if (strCommand == "cmpctblock" && !fImporting && !fReindex) // Ignore blocks received while importing
+    {
+        CBlockHeaderAndShortTxIDs cmpctblock;
+        vRecv >> cmpctblock;
+        
+        const uint256 hash = cmpctblock.header.GetHash();
+        CInv inv(MSG_BLOCK, hash);
+        LogPrint("net", "received cmpctblock %s peer=%d\n", hash.ToString(), pfrom->id);
+        
+        pfrom->AddInventoryKnown(inv);
+        
+        CBlock block;
+        bool fBlockReconstructed = false;
+        {
+            LOCK(cs_main);
+            
+            if (mapBlockIndex.find(cmpctblock.header.hashPrevBlock) == mapBlockIndex.end()) {
+                // The header doesn't connect to anything we know, catch up on headers first
+                if (!IsInitialBlockDownload())
+                    pfrom->PushMessage("getheaders", chainActive.GetLocator(pindexBestHeader), uint256());
+                return true;
+            }
+            
+            CBlockIndex *pindex = NULL;
+            CValidationState state;
+            int32_t futureblock = 0;
+            if (!AcceptBlockHeader(&futureblock, cmpctblock.header, state, &pindex)) {
+                int nDoS;
+                if (state.IsInvalid(nDoS))
+                {
+                    if (nDoS > 0 && futureblock == 0)
+                        Misbehaving(pfrom->GetId(), nDoS/nDoS);
+                    return error("invalid header received in cmpctblock");
+                }
+            }
+            if (pindex == NULL)
+                return true;
+            
+            UpdateBlockAvailability(pfrom->GetId(), hash);
+            CNodeState *nodestate = State(pfrom->GetId());
+            nodestate->nCompactBlocks++;
+            
+            map<uint256, pair<NodeId, list<QueuedBlock>::iterator> >::iterator itInFlight = mapBlocksInFlight.find(hash);
+            bool fInFlight = itInFlight != mapBlocksInFlight.end();
+            bool fInFlightFromPeer = fInFlight && itInFlight->second.first == pfrom->GetId();
+            
+            if (pindex->nStatus & BLOCK_HAVE_DATA)
+                return true;
+            // Unless we asked for it, a block that doesn't beat our tip is left to the regular download logic
+            if (pindex->nChainWork <= chainActive.Tip()->nChainWork && !fInFlightFromPeer)
+                return true;
+            
+            PartiallyDownloadedBlock partialBlock(&mempool);
+            ReadStatus status = partialBlock.InitData(cmpctblock);
+            if (status == READ_STATUS_INVALID) {
+                if (fInFlightFromPeer)
+                    MarkBlockAsReceived(hash);
+                Misbehaving(pfrom->GetId(), 100);
+                return error("invalid compact block from peer=%d", pfrom->id);
+            }
+            
+            BlockTransactionsRequest req;
+            if (status == READ_STATUS_OK) {
+                for (size_t i = 0; i < partialBlock.BlockTxCount(); i++) {
+                    if (!partialBlock.IsTxAvailable(i))
+                        req.indexes.push_back(i);
+                }
+                if (req.indexes.empty()) {
+                    status = partialBlock.FillBlock(block, std::vector<CTransaction>());
+                    if (status == READ_STATUS_OK) {
+                        fBlockReconstructed = true;
+                        nodestate->nCompactBlocksReconstructed++;
+                    }
+                }
+            }
+            
+            if (!fBlockReconstructed) {
+                // Another peer is already sending us this block
+                if (fInFlight && !fInFlightFromPeer)
+                    return true;
+                
+                MarkBlockAsInFlight(pfrom->GetId(), hash, chainparams.GetConsensus(), pindex);
+                if (status == READ_STATUS_FAILED) {
+                    // Short id collision, or the block doesn't add up: get the whole block
+                    pfrom->PushMessage("getdata", std::vector<CInv>(1, inv));
+                } else {
+                    mapBlocksInFlight[hash].second->partialBlock = std::make_shared<PartiallyDownloadedBlock>(partialBlock);
+                    req.blockhash = hash;
+                    nodestate->nCompactBlockTxRequested += req.indexes.size();
+                    pfrom->PushMessage("getblocktxn", req);
+                }
+                return true;
+            }
+        }
+        
+        // The header has been validated already, so the block is processed
+        // whether or not we asked for it, like one from a whitelisted peer
+        CValidationState state;
+        ProcessNewBlock(0,0,state, pfrom, &block, true, NULL);
+        int nDoS;
+        if (state.IsInvalid(nDoS)) {
+            pfrom->PushMessage("reject", strCommand, state.GetRejectCode(),
+                               state.GetRejectReason().substr(0, MAX_REJECT_MESSAGE_LENGTH), inv.hash);
+            if (nDoS > 0) {
+                LOCK(cs_main);
+                Misbehaving(pfrom->GetId(), nDoS);
+            }
+        }
+    }
+    
+    
+    else if (strCommand == "getblocktxn")
+    {
+        BlockTransactionsRequest req;
+        vRecv >> req;
+        
+        LOCK(cs_main);
+        
+        BlockMap::iterator mi = mapBlockIndex.find(req.blockhash);
+        if (mi == mapBlockIndex.end() || !(mi->second->nStatus & BLOCK_HAVE_DATA)) {
+            LogPrint("net", "peer=%d sent us a getblocktxn for a block we don't have\n", pfrom->id);
+            return true;
+        }
+        
+        if (mi->second->nHeight < chainActive.Height() - MAX_BLOCKTXN_DEPTH) {
+            // Picking transactions out of an old block is not worth it, send
+            // the whole block, subject to the usual getdata rules
+            LogPrint("net", "peer=%d asked for transactions of old block %s, sending the full block\n", pfrom->id, req.blockhash.ToString());
+            pfrom->vRecvGetData.push_back(CInv(MSG_BLOCK, req.blockhash));
+            ProcessGetData(pfrom);
+            return true;
+        }
+        
+        CBlock block;
+        CRecentBlockCache::Entry cached = recentBlockCache.Get(req.blockhash);
+        if (cached) {
+            CPlainDataStream ss(*cached);
+            ss >> block;
+        } else if (!ReadBlockFromDisk(block, mi->second, 1)) {
+            return error("%s: cannot load block %s from disk", __func__, req.blockhash.ToString());
+        }
+        
+        BlockTransactions resp(req);
+        for (size_t i = 0; i < req.indexes.size(); i++) {
+            if (req.indexes[i] >= block.vtx.size()) {
+                Misbehaving(pfrom->GetId(), 100);
+                return error("peer=%d sent us a getblocktxn with out-of-bounds tx indices", pfrom->id);
+            }
+            resp.txn[i] = block.vtx[req.indexes[i]];
+        }
+        pfrom->PushMessage("blocktxn", resp);
+    }
+    
+    
+    else if (strCommand == "blocktxn" && !fImporting && !fReindex) // Ignore blocks received while importing
+    {
+        BlockTransactions resp;
+        vRecv >> resp;
+        
+        CBlock block;
+        bool fBlockRead = false;
+        {
+            LOCK(cs_main);
+            
+            map<uint256, pair<NodeId, list<QueuedBlock>::iterator> >::iterator itInFlight = mapBlocksInFlight.find(resp.blockhash);
+            if (itInFlight == mapBlocksInFlight.end() || !itInFlight->second.second->partialBlock ||
+                itInFlight->second.first != pfrom->GetId()) {
+                LogPrint("net", "peer=%d sent us block transactions for block we weren't expecting\n", pfrom->id);
+                return true;
+            }
+            
+            ReadStatus status = itInFlight->second.second->partialBlock->FillBlock(block, resp.txn);
+            if (status == READ_STATUS_INVALID) {
+                MarkBlockAsReceived(resp.blockhash);
+                Misbehaving(pfrom->GetId(), 100);
+                return error("peer=%d sent us invalid compact block/non-matching block transactions", pfrom->id);
+            } else if (status == READ_STATUS_FAILED) {
+                // Might have been a short id collision, fall back to the full block
+                CBlockIndex *pindex = itInFlight->second.second->pindex;
+                MarkBlockAsInFlight(pfrom->GetId(), resp.blockhash, chainparams.GetConsensus(), pindex);
+                pfrom->PushMessage("getdata", std::vector<CInv>(1, CInv(MSG_BLOCK, resp.blockhash)));
+            } else {
+                fBlockRead = true;
+            }
+        }
+        
+        if (fBlockRead) {
+            CValidationState state;
+            ProcessNewBlock(0,0,state, pfrom, &block, true, NULL);
+            int nDoS;
+            if (state.IsInvalid(nDoS)) {
+                pfrom->PushMessage("reject", strCommand, state.GetRejectCode(),
+                                   state.GetRejectReason().substr(0, MAX_REJECT_MESSAGE_LENGTH), resp.blockhash);
+                if (nDoS > 0) {
+                    LOCK(cs_main);
+                    Misbehaving(pfrom->GetId(), nDoS);
+                }
+            }
+        }
+    }
+    
+    
     // This asymmetric behavior for inbound and outbound connections was introduced
     // to prevent a fingerprinting attack: an attacker can send specific fake addresses
     // to users' AddrMan and later request them by sending getaddr messages.
@@ -6857,17 +7625,25 @@ bool SendMessages(CNode* pto, bool fSendTrickle)
         //
         static uint256 zero;
         vector<CInv> vGetData;
-        if (!pto->fDisconnect && !pto->fClient && (fFetch || !IsInitialBlockDownload()) && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+        if (!pto->fDisconnect && !pto->fClient && (fFetch || !IsInitialBlockDownload()) && state.nBlocksInFlight < state.nBlocksInFlightLimit) {
             vector<CBlockIndex*> vToDownload;
             NodeId staller = -1;
-            FindNextBlocksToDownload(pto->GetId(), MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload, staller);
+            CBlockIndex *pindexStalled = NULL;
+            FindNextBlocksToDownload(pto->GetId(), state.nBlocksInFlightLimit - state.nBlocksInFlight, vToDownload, staller, pindexStalled);
             BOOST_FOREACH(CBlockIndex *pindex, vToDownload) {
                 vGetData.push_back(CInv(MSG_BLOCK, pindex->GetBlockHash()));
                 MarkBlockAsInFlight(pto->GetId(), pindex->GetBlockHash(), consensusParams, pindex);
                 LogPrint("net", "Requesting block %s (%d) peer=%d\n", pindex->GetBlockHash().ToString(),
                          pindex->nHeight, pto->id);
             }
-            if (state.nBlocksInFlight == 0 && staller != -1) {
+            if (staller != -1 && pindexStalled != NULL && ShouldReassignBlock(pto->GetId(), staller, pindexStalled->GetBlockHash(), nNow)) {
+                // Rather than wait for a slow peer to move the window, ask this one for the block holding it up
+                LogPrint("net", "Reassigning block %s (%d) from peer=%d to peer=%d\n", pindexStalled->GetBlockHash().ToString(),
+                         pindexStalled->nHeight, staller, pto->id);
+                State(staller)->nBlocksReassigned++;
+                vGetData.push_back(CInv(MSG_BLOCK, pindexStalled->GetBlockHash()));
+                MarkBlockAsInFlight(pto->GetId(), pindexStalled->GetBlockHash(), consensusParams, pindexStalled);
+            } else if (state.nBlocksInFlight == 0 && staller != -1) {
                 if (State(staller)->nStallingSince == 0) {
                     State(staller)->nStallingSince = nNow;
                     LogPrint("net", "Stall started peer=%d\n", staller);
@@ -6930,10 +7706,8 @@ public:
     CMainCleanup() {}
     ~CMainCleanup() {
         // block headers
-        BlockMap::iterator it1 = mapBlockIndex.begin();
-        for (; it1 != mapBlockIndex.end(); it1++)
-            delete (*it1).second;
         mapBlockIndex.clear();
+        blockIndexArena.Clear();
         
         // orphan transactions
         mapOrphanTransactions.clear();
@@ -11,6 +11,9 @@
 #endif
 
 #include "amount.h"
+#include "blockcache.h"
+#include "blockfileappender.h"
+#include "blockfilemap.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "coins.h"
@@ -84,8 +87,15 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
-/** Number of blocks that can be requested at any given time from a single peer. */
+/** Number of blocks that can be requested at any given time from a single peer, until its download rate is known. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
+/** Bounds of the per-peer in-flight limit once it is derived from the peer's download rate. */
+static const int MIN_BLOCKS_IN_TRANSIT_PER_PEER = 4;
+static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER_ADAPTIVE = 128;
+/** A peer may have as many blocks in flight as it delivers in this many seconds at its measured rate. */
+static const int BLOCK_DOWNLOAD_QUEUE_SECONDS = 4;
+/** Minimum time in seconds a block holding up the download window stays in flight before it is requested from a faster peer. */
+static const unsigned int BLOCK_REASSIGN_TIMEOUT = 1;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
 static const unsigned int BLOCK_STALLING_TIMEOUT = 2;
 /** Number of headers sent in one getheaders result. We rely on the assumption that if a peer sends
@@ -96,6 +106,8 @@ static const unsigned int MAX_HEADERS_RESULTS = 160;
  *  degree of disordering of blocks on disk (which make reindexing and in the future perhaps pruning
  *  harder). We'll probably want to make this a per-peer adaptive value at some point. */
 static const unsigned int BLOCK_DOWNLOAD_WINDOW = 1024;
+/** Largest the download window grows to when the peers' combined in-flight limits exceed it, see GetBlockDownloadWindow. */
+static const unsigned int BLOCK_DOWNLOAD_WINDOW_MAX = 4096;
 /** Time to wait (in seconds) between writing blocks/block index to disk. */
 static const unsigned int DATABASE_WRITE_INTERVAL = 60 * 60;
 /** Time to wait (in seconds) between flushing chainstate to disk. */
@@ -126,8 +138,16 @@ extern unsigned int expiryDelta;
 extern CScript COINBASE_FLAGS;
 extern CCriticalSection cs_main;
 extern CTxMemPool mempool;
+/** Recently connected blocks in serialized form, for answering getdata */
+extern CRecentBlockCache recentBlockCache;
+/** Mappings of blk/rev files that are no longer appended to, for reading blocks and undo data */
+extern CBlockFileMapCache blockFileMapCache;
+/** The blk/rev files blocks and undo data are being appended to */
+extern CBlockFileAppender blockFileAppender;
 typedef boost::unordered_map<uint256, CBlockIndex*, BlockHasher> BlockMap;
 extern BlockMap mapBlockIndex;
+/** Owns the entries of mapBlockIndex */
+extern CBlockIndexArena blockIndexArena;
 extern uint64_t nLastBlockTx;
 extern uint64_t nLastBlockSize;
 extern const std::string strMessageMagic;
@@ -202,6 +222,16 @@ FILE* OpenUndoFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 boost::filesystem::path GetBlockPosFilename(const CDiskBlockPos &pos, const char *prefix);
 /** Import blocks from an external file */
 bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos *dbp = NULL);
+/** Number of blocks a peer delivering dBytesPerSec in blocks of dBlockBytes may have in flight. */
+int GetBlocksInFlightLimit(double dBytesPerSec, double dBlockBytes);
+/** How far beyond the last block in common with a peer blocks are fetched from it. Requires cs_main. */
+int GetBlockDownloadWindow();
+/**
+ * Copy the pubkey33 the block's coinbase pays to. It is kept in the block index
+ * once known and persisted with it, and only blocks indexed before that was
+ * done are read from disk, once.
+ */
+bool GetBlockMinerPubKey(CBlockIndex *pindex, uint8_t *pubkey33);
 /** Initialize a new block tree database + block data on disk */
 bool InitBlockIndex();
 /** Load the block tree and coins database from disk */
@@ -274,6 +304,13 @@ struct CNodeStateStats {
     int nSyncHeight;
     int nCommonHeight;
     std::vector<int> vHeightInFlight;
+    int nCompactBlocks;
+    int nCompactBlocksReconstructed;
+    int nCompactBlockTxRequested;
+    int nBlocksInFlightLimit;
+    int64_t nBlockBytesPerSec;
+    int64_t nBlockLatency;
+    int nBlocksReassigned;
 };
 
 struct CTimestampIndexIteratorKey {
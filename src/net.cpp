@@ -552,6 +552,7 @@ void CNode::copyStats(CNodeStats &stats)
     stats.nSendBytes = nSendBytes;
     stats.nRecvBytes = nRecvBytes;
     stats.fWhitelisted = fWhitelisted;
+    stats.fSupportsCompactBlocks = fSupportsCompactBlocks;
 
     // It is common for nodes with good ping times to suddenly become lagged,
     // due to a new block arriving or other large transfer.
@@ -669,10 +670,10 @@ int CNetMessage::readData(const char *pch, unsigned int nBytes)
 // requires LOCK(cs_vSend)
 void SocketSendData(CNode *pnode)
 {
-    std::deque<CSerializeData>::iterator it = pnode->vSendMsg.begin();
+    std::deque<CPlainSerializeData>::iterator it = pnode->vSendMsg.begin();
 
     while (it != pnode->vSendMsg.end()) {
-        const CSerializeData &data = *it;
+        const CPlainSerializeData &data = *it;
         assert(data.size() > pnode->nSendOffset);
         int nBytes = send(pnode->hSocket, &data[pnode->nSendOffset], data.size() - pnode->nSendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
         if (nBytes > 0) {
@@ -1922,21 +1923,21 @@ void CNode::Fuzz(int nChance)
     case 0:
         // xor a random byte with a random value:
         if (!ssSend.empty()) {
-            CDataStream::size_type pos = GetRand(ssSend.size());
+            CPlainDataStream::size_type pos = GetRand(ssSend.size());
             ssSend[pos] ^= (unsigned char)(GetRand(256));
         }
         break;
     case 1:
         // delete a random byte:
         if (!ssSend.empty()) {
-            CDataStream::size_type pos = GetRand(ssSend.size());
+            CPlainDataStream::size_type pos = GetRand(ssSend.size());
             ssSend.erase(ssSend.begin()+pos);
         }
         break;
     case 2:
         // insert a random byte at a random position
         {
-            CDataStream::size_type pos = GetRand(ssSend.size());
+            CPlainDataStream::size_type pos = GetRand(ssSend.size());
             char ch = (char)GetRand(256);
             ssSend.insert(ssSend.begin()+pos, ch);
         }
@@ -2083,6 +2084,8 @@ CNode::CNode(SOCKET hSocketIn, const CAddress& addrIn, const std::string& addrNa
     nStartingHeight = -1;
     fGetAddr = false;
     fRelayTxes = false;
+    fSupportsCompactBlocks = false;
+    fPreferCompactBlocks = false;
     fSentAddr = false;
     pfilter = new CBloomFilter();
     nPingNonceSent = 0;
@@ -2201,7 +2204,7 @@ void CNode::EndMessage() UNLOCK_FUNCTION(cs_vSend)
 
     LogPrint("net", "(%d bytes) peer=%d\n", nSize, id);
 
-    std::deque<CSerializeData>::iterator it = vSendMsg.insert(vSendMsg.end(), CSerializeData());
+    std::deque<CPlainSerializeData>::iterator it = vSendMsg.insert(vSendMsg.end(), CPlainSerializeData());
     ssSend.GetAndClear(*it);
     nSendSize += (*it).size();
 
@@ -181,6 +181,7 @@ public:
     uint64_t nSendBytes;
     uint64_t nRecvBytes;
     bool fWhitelisted;
+    bool fSupportsCompactBlocks;
     double dPingTime;
     double dPingWait;
     std::string addrLocal;
@@ -238,11 +239,11 @@ public:
     // socket
     uint64_t nServices;
     SOCKET hSocket;
-    CDataStream ssSend;
+    CPlainDataStream ssSend;
     size_t nSendSize; // total size of all vSendMsg entries
     size_t nSendOffset; // offset inside the first vSendMsg already sent
     uint64_t nSendBytes;
-    std::deque<CSerializeData> vSendMsg;
+    std::deque<CPlainSerializeData> vSendMsg;
     CCriticalSection cs_vSend;
 
     std::deque<CInv> vRecvGetData;
@@ -277,6 +278,10 @@ public:
     // b) the peer may tell us in its version message that we should not relay tx invs
     //    until it has initialized its bloom filter.
     bool fRelayTxes;
+    // The peer sent "sendcmpct" and may be asked for compact blocks
+    bool fSupportsCompactBlocks;
+    // The peer wants new blocks pushed as "cmpctblock" instead of announced by inv
+    bool fPreferCompactBlocks;
     bool fSentAddr;
     CSemaphoreGrant grantOutbound;
     CCriticalSection cs_filter;
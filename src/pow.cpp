@@ -16,6 +16,10 @@
 
 #include "sodium.h"
 
+#include <mutex>
+#include <set>
+#include <thread>
+
 #ifdef ENABLE_RUST
 #include "librustzcash.h"
 #endif // ENABLE_RUST
@@ -192,11 +196,9 @@ uint32_t lwmaGetNextPOSRequired(const CBlockIndex* pindexLast, const Consensus::
         if (!pindexFirst)
             return nProofOfStakeLimit;
 
-        CBlockHeader hdr = pindexFirst->GetBlockHeader();
-
-        if (hdr.IsVerusPOSBlock())
+        if (pindexFirst->IsVerusPOSBlock())
         {
-            nBits = hdr.GetVerusPOSTarget();
+            nBits = pindexFirst->GetVerusPOSTarget();
             break;
         }
         pindexFirst = pindexFirst->pprev;
@@ -218,10 +220,9 @@ uint32_t lwmaGetNextPOSRequired(const CBlockIndex* pindexLast, const Consensus::
             if (!pindexFirst)
                 return nProofOfStakeLimit;
 
-            CBlockHeader hdr = pindexFirst->GetBlockHeader();
-            if (hdr.IsVerusPOSBlock())
+            if (pindexFirst->IsVerusPOSBlock())
             {
-                nBits = hdr.GetVerusPOSTarget();
+                nBits = pindexFirst->GetVerusPOSTarget();
                 break;
             }
         }
@@ -298,14 +299,17 @@ uint32_t lwmaGetNextPOSRequired(const CBlockIndex* pindexLast, const Consensus::
     return nextTarget.GetCompact();
 }
 
-bool CheckEquihashSolution(const CBlockHeader *pblock, const CChainParams& params)
-{
-    if (ASSETCHAINS_ALGO != ASSETCHAINS_EQUIHASH)
-        return true;
-
-    unsigned int n = params.EquihashN();
-    unsigned int k = params.EquihashK();
+/**
+ * Headers whose solutions were checked ahead of time by CheckEquihashSolutions.
+ * They are keyed by block hash, which commits to the nonce and the solution, and
+ * are dropped once CheckEquihashSolution has been asked about them.
+ */
+static std::mutex csVerifiedSolutions;
+static std::set<uint256> setVerifiedSolutions;
+static const size_t MAX_VERIFIED_SOLUTIONS = 10000;
 
+static bool IsValidEquihashSolution(const CBlockHeader *pblock, unsigned int n, unsigned int k)
+{
     // Hash state
     crypto_generichash_blake2b_state state;
     EhInitialiseState(n, k, state);
@@ -330,13 +334,73 @@ bool CheckEquihashSolution(const CBlockHeader *pblock, const CChainParams& param
 
     bool isValid;
     EhIsValidSolution(n, k, state, pblock->nSolution, isValid);
+    return isValid;
+}
 
-    if (!isValid)
+bool CheckEquihashSolution(const CBlockHeader *pblock, const CChainParams& params)
+{
+    if (ASSETCHAINS_ALGO != ASSETCHAINS_EQUIHASH)
+        return true;
+
+    {
+        std::lock_guard<std::mutex> lock(csVerifiedSolutions);
+        if (setVerifiedSolutions.erase(pblock->GetHash()))
+            return true;
+    }
+
+    if (!IsValidEquihashSolution(pblock, params.EquihashN(), params.EquihashK()))
         return error("CheckEquihashSolution(): invalid solution");
 
     return true;
 }
 
+size_t CheckEquihashSolutions(const std::vector<CBlockHeader>& headers, const CChainParams& params, int nThreads)
+{
+    // A solution takes about a millisecond to check, so a few headers already fill a thread
+    static const size_t MIN_HEADERS_PER_THREAD = 4;
+
+    if (ASSETCHAINS_ALGO != ASSETCHAINS_EQUIHASH || headers.empty())
+        return headers.size();
+
+    unsigned int n = params.EquihashN();
+    unsigned int k = params.EquihashK();
+    std::vector<char> vValid(headers.size(), 0);
+    auto checkRange = [&](size_t nBegin, size_t nEnd) {
+        for (size_t i = nBegin; i < nEnd; i++) {
+            vValid[i] = IsValidEquihashSolution(&headers[i], n, k);
+        }
+    };
+
+    size_t nChunks = std::min<size_t>(std::max(nThreads, 1),
+                                      (headers.size() + MIN_HEADERS_PER_THREAD - 1) / MIN_HEADERS_PER_THREAD);
+    size_t nPerChunk = (headers.size() + nChunks - 1) / nChunks;
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nChunks; i++)
+        threads.emplace_back(checkRange, i * nPerChunk, std::min(headers.size(), (i + 1) * nPerChunk));
+    checkRange(0, std::min(headers.size(), nPerChunk));
+    for (std::thread& t : threads)
+        t.join();
+
+    size_t nValid = 0;
+    std::lock_guard<std::mutex> lock(csVerifiedSolutions);
+    // Entries that were never asked for belong to headers that were not accepted
+    if (setVerifiedSolutions.size() + headers.size() > MAX_VERIFIED_SOLUTIONS)
+        setVerifiedSolutions.clear();
+    for (size_t i = 0; i < headers.size(); i++) {
+        if (vValid[i]) {
+            setVerifiedSolutions.insert(headers[i].GetHash());
+            nValid++;
+        }
+    }
+    return nValid;
+}
+
+void ForgetVerifiedEquihashSolutions()
+{
+    std::lock_guard<std::mutex> lock(csVerifiedSolutions);
+    setVerifiedSolutions.clear();
+}
+
 int32_t komodo_chosennotary(int32_t *notaryidp,int32_t height,uint8_t *pubkey33,uint32_t timestamp);
 int32_t komodo_is_special(uint8_t pubkeys[66][33],int32_t mids[66],uint32_t blocktimes[66],int32_t height,uint8_t pubkey33[33],uint32_t blocktime);
 int32_t komodo_currentheight();
@@ -9,6 +9,7 @@
 #include "consensus/params.h"
 
 #include <stdint.h>
+#include <vector>
 
 class CBlockHeader;
 class CBlockIndex;
@@ -25,6 +26,14 @@ unsigned int lwmaGetNextPOSRequired(const CBlockIndex* pindexLast, const Consens
 
 /** Check whether the Equihash solution in a block header is valid */
 bool CheckEquihashSolution(const CBlockHeader *pblock, const CChainParams&);
+/**
+ * Check the Equihash solutions of a batch of headers on up to nThreads threads.
+ * The valid ones are remembered, so that CheckEquihashSolution accepts them
+ * without checking them again. Returns the number of valid solutions.
+ */
+size_t CheckEquihashSolutions(const std::vector<CBlockHeader>& headers, const CChainParams&, int nThreads);
+/** Forget the solutions CheckEquihashSolutions remembered, for tests and benchmarks. */
+void ForgetVerifiedEquihashSolutions();
 
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(const CBlockHeader &blkHeader, uint8_t *pubkey33, int32_t height, const Consensus::Params& params);
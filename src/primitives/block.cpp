@@ -9,10 +9,108 @@
 #include "tinyformat.h"
 #include "utilstrencodings.h"
 #include "crypto/common.h"
+#include "crypto/sha256.h"
+
+#include <mutex>
+#include <thread>
+
+static_assert(sizeof(uint256) == 32, "BuildMerkleTree hashes pairs of uint256 as contiguous 64 byte inputs");
 
 // default hash algorithm for block
 uint256 (CBlockHeader::*CBlockHeader::hashFunction)() const = &CBlockHeader::GetSHA256DHash;
 
+struct CBlockHeaderHashCache::Entry
+{
+    uint256 (CBlockHeader::*hashFunction)() const;
+    int32_t nVersion;
+    uint256 hashPrevBlock;
+    uint256 hashMerkleRoot;
+    uint256 hashReserved;
+    uint32_t nTime;
+    uint32_t nBits;
+    uint256 nNonce;
+    std::vector<unsigned char> nSolution;
+    uint256 hash;
+
+    Entry(const CBlockHeader& header, const uint256& hashIn) :
+        hashFunction(CBlockHeader::hashFunction), nVersion(header.nVersion),
+        hashPrevBlock(header.hashPrevBlock), hashMerkleRoot(header.hashMerkleRoot),
+        hashReserved(header.hashReserved), nTime(header.nTime), nBits(header.nBits),
+        nNonce(header.nNonce), nSolution(header.nSolution), hash(hashIn) {}
+
+    bool Matches(const CBlockHeader& header) const
+    {
+        // The solution is by far the largest field, so compare it last
+        return hashFunction == CBlockHeader::hashFunction &&
+               nNonce == header.nNonce &&
+               nTime == header.nTime &&
+               hashMerkleRoot == header.hashMerkleRoot &&
+               hashPrevBlock == header.hashPrevBlock &&
+               nBits == header.nBits &&
+               nVersion == header.nVersion &&
+               hashReserved == header.hashReserved &&
+               nSolution == header.nSolution;
+    }
+};
+
+// Held only to copy or replace a memo pointer, never while hashing
+static std::mutex csHeaderHashCache;
+
+CBlockHeaderHashCache& CBlockHeaderHashCache::operator=(const CBlockHeaderHashCache& other)
+{
+    Set(other.Get());
+    return *this;
+}
+
+std::shared_ptr<const CBlockHeaderHashCache::Entry> CBlockHeaderHashCache::Get() const
+{
+    std::lock_guard<std::mutex> lock(csHeaderHashCache);
+    return entry;
+}
+
+void CBlockHeaderHashCache::Set(const std::shared_ptr<const Entry>& entryIn)
+{
+    std::lock_guard<std::mutex> lock(csHeaderHashCache);
+    entry = entryIn;
+}
+
+uint256 CBlockHeader::GetHash() const
+{
+    std::shared_ptr<const CBlockHeaderHashCache::Entry> entry = hashCache.Get();
+    if (entry && entry->Matches(*this))
+        return entry->hash;
+
+    uint256 hash = (this->*hashFunction)();
+    hashCache.Set(std::make_shared<const CBlockHeaderHashCache::Entry>(*this, hash));
+    return hash;
+}
+
+void CBlockHeader::PrecomputeHashes(const std::vector<CBlockHeader>& headers, int nThreads)
+{
+    // Fewer headers than this per thread aren't worth starting a thread for
+    static const size_t MIN_HEADERS_PER_THREAD = 16;
+
+    size_t nChunks = std::min<size_t>(std::max(nThreads, 1),
+                                      (headers.size() + MIN_HEADERS_PER_THREAD - 1) / MIN_HEADERS_PER_THREAD);
+    if (nChunks <= 1) {
+        for (const CBlockHeader& header : headers)
+            header.GetHash();
+        return;
+    }
+
+    size_t nPerChunk = (headers.size() + nChunks - 1) / nChunks;
+    auto hashRange = [&headers](size_t nBegin, size_t nEnd) {
+        for (size_t i = nBegin; i < nEnd; i++)
+            headers[i].GetHash();
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nChunks; i++)
+        threads.emplace_back(hashRange, i * nPerChunk, std::min(headers.size(), (i + 1) * nPerChunk));
+    hashRange(0, nPerChunk);
+    for (std::thread& t : threads)
+        t.join();
+}
+
 uint256 CBlockHeader::GetSHA256DHash() const
 {
     return SerializeHash(*this);
@@ -88,15 +186,18 @@ uint256 CBlock::BuildMerkleTree(bool* fMutated) const
     bool mutated = false;
     for (int nSize = vtx.size(); nSize > 1; nSize = (nSize + 1) / 2)
     {
-        for (int i = 0; i < nSize; i += 2)
-        {
-            int i2 = std::min(i+1, nSize-1);
-            if (i2 == i + 1 && i2 + 1 == nSize && vMerkleTree[j+i] == vMerkleTree[j+i2]) {
-                // Two identical hashes at the end of the list at a particular level.
-                mutated = true;
-            }
-            vMerkleTree.push_back(Hash(BEGIN(vMerkleTree[j+i]),  END(vMerkleTree[j+i]),
-                                       BEGIN(vMerkleTree[j+i2]), END(vMerkleTree[j+i2])));
+        if ((nSize & 1) == 0 && vMerkleTree[j+nSize-2] == vMerkleTree[j+nSize-1]) {
+            // Two identical hashes at the end of the list at a particular level.
+            mutated = true;
+        }
+        int nNext = j + nSize;
+        vMerkleTree.resize(nNext + (nSize + 1) / 2);
+        // Each pair of adjacent hashes is one 64 byte input, so the whole
+        // level is hashed in a single multi-buffer call
+        SHA256D64(vMerkleTree[nNext].begin(), vMerkleTree[j].begin(), nSize / 2);
+        if (nSize & 1) {
+            vMerkleTree.back() = Hash(BEGIN(vMerkleTree[nNext-1]), END(vMerkleTree[nNext-1]),
+                                      BEGIN(vMerkleTree[nNext-1]), END(vMerkleTree[nNext-1]));
         }
         j += nSize;
     }
@@ -11,6 +11,8 @@
 #include "uint256.h"
 #include "arith_uint256.h"
 
+#include <memory>
+
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
  * requirements.  When they solve the proof-of-work, they broadcast the block
@@ -18,6 +20,32 @@
  * in the block is a special one that creates a new coin owned by the creator
  * of the block.
  */
+/**
+ * Memory only memo of a block header's hash. VerusHash runs over more than
+ * 1400 bytes of header and solution, and the same header is hashed many times
+ * on its way through validation, logging and RPC. The memo keeps a copy of the
+ * fields it was computed from, so a header that has changed since, like the
+ * nonce, solution and time the miner updates, is simply hashed again.
+ *
+ * Copies of a header share its memo. The memo is swapped under a lock, so
+ * concurrent GetHash() calls on one header are safe.
+ */
+class CBlockHeaderHashCache
+{
+public:
+    struct Entry;
+
+    CBlockHeaderHashCache() {}
+    CBlockHeaderHashCache(const CBlockHeaderHashCache& other) : entry(other.Get()) {}
+    CBlockHeaderHashCache& operator=(const CBlockHeaderHashCache& other);
+
+    std::shared_ptr<const Entry> Get() const;
+    void Set(const std::shared_ptr<const Entry>& entryIn);
+
+private:
+    std::shared_ptr<const Entry> entry;
+};
+
 class CBlockHeader
 {
 public:
@@ -36,6 +64,9 @@ public:
     uint256 nNonce;
     std::vector<unsigned char> nSolution;
 
+    // memory only
+    mutable CBlockHeaderHashCache hashCache;
+
     CBlockHeader()
     {
         SetNull();
@@ -73,10 +104,16 @@ public:
         return (nBits == 0);
     }
 
-    uint256 GetHash() const
-    {
-        return (this->*hashFunction)();
-    }
+    /** The block hash, computed with hashFunction and memoized in hashCache */
+    uint256 GetHash() const;
+
+    /**
+     * Fill the hash memo of each header, splitting the work over up to
+     * nThreads threads. Used on "headers" messages, so that the hashes are
+     * computed in parallel and outside cs_main before the headers are
+     * accepted one at a time.
+     */
+    static void PrecomputeHashes(const std::vector<CBlockHeader>& headers, int nThreads);
 
     uint256 GetSHA256DHash() const;
     static void SetSHA256DHash();
@@ -211,6 +248,7 @@ public:
         block.nBits          = nBits;
         block.nNonce         = nNonce;
         block.nSolution      = nSolution;
+        block.hashCache      = hashCache;
         return block;
     }
 
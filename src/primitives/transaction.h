@@ -86,7 +86,8 @@ public:
             CAmount vpub_old,
             CAmount vpub_new,
             bool computeProof = true, // Set to false in some tests
-            uint256 *esk = nullptr // payment disclosure
+            uint256 *esk = nullptr, // payment disclosure
+            ZCJSProofWitness *proofWitness = nullptr // deferred proving
     );
 
     static JSDescription Randomized(
@@ -106,7 +107,10 @@ public:
             CAmount vpub_new,
             bool computeProof = true, // Set to false in some tests
             uint256 *esk = nullptr, // payment disclosure
-            std::function<int(int)> gen = GetRandInt
+            std::function<int(int)> gen = GetRandInt,
+            // Receives the circuit inputs, so that with computeProof = false
+            // the proof can be filled in later from ZCJoinSplit::prove(witness)
+            ZCJSProofWitness *proofWitness = nullptr
     );
 
     // Verifies that the JoinSplit proof is correct.
@@ -71,6 +71,11 @@ enum {
     // set by all Bitcoin Core nodes, and is unset by SPV clients or other peers that just want
     // network services but don't provide them.
     NODE_NETWORK = (1 << 0),
+    // NODE_COMPACT_BLOCKS means the node understands compact block relay
+    // ("sendcmpct", "cmpctblock", "getblocktxn" and "blocktxn"). It is taken
+    // from the experimental range below, so it is only trusted together with
+    // a protocol version of at least SHORT_IDS_BLOCKS_VERSION.
+    NODE_COMPACT_BLOCKS = (1 << 24),
 
     // Bits 24-31 are reserved for temporary experiments. Just pick a bit that
     // isn't getting used, or one not being used much, and notify the
@@ -149,6 +154,9 @@ enum {
     // Nodes may always request a MSG_FILTERED_BLOCK in a getdata, however,
     // MSG_FILTERED_BLOCK should not appear in any invs except as a part of getdata.
     MSG_FILTERED_BLOCK,
+    // MSG_CMPCT_BLOCK is only used in getdata, to ask a peer that sent
+    // "sendcmpct" for a "cmpctblock" instead of the full block.
+    MSG_CMPCT_BLOCK,
 };
 
 #endif // BITCOIN_PROTOCOL_H
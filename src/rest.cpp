@@ -7,6 +7,7 @@
 #include "primitives/transaction.h"
 #include "main.h"
 #include "httpserver.h"
+#include "jsonwriter.h"
 #include "rpcserver.h"
 #include "streams.h"
 #include "sync.h"
@@ -56,8 +57,8 @@ struct CCoin {
     }
 };
 
-extern void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry);
-extern UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
+extern void TxToJSONStream(const CTransaction& tx, const uint256 hashBlock, CJSONWriter& w);
+extern void blockToJSONStream(CJSONWriter& w, const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
 extern UniValue mempoolInfoToJSON();
 extern UniValue mempoolToJSON(bool fVerbose = false);
 extern void ScriptPubKeyToJSON(const CScript& scriptPubKey, UniValue& out, bool fIncludeHex);
@@ -237,8 +238,9 @@ static bool rest_block(HTTPRequest* req,
     }
 
     case RF_JSON: {
-        UniValue objBlock = blockToJSON(block, pblockindex, showTxDetails);
-        string strJSON = objBlock.write() + "\n";
+        CJSONWriter w;
+        blockToJSONStream(w, block, pblockindex, showTxDetails);
+        string strJSON = w.str() + "\n";
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strJSON);
         return true;
@@ -374,9 +376,9 @@ static bool rest_tx(HTTPRequest* req, const std::string& strURIPart)
     }
 
     case RF_JSON: {
-        UniValue objTx(UniValue::VOBJ);
-        TxToJSON(tx, hashBlock, objTx);
-        string strJSON = objTx.write() + "\n";
+        CJSONWriter w;
+        TxToJSONStream(tx, hashBlock, w);
+        string strJSON = w.str() + "\n";
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strJSON);
         return true;
@@ -10,6 +10,7 @@
 #include "base58.h"
 #include "consensus/validation.h"
 #include "cc/betprotocol.h"
+#include "jsonwriter.h"
 #include "main.h"
 #include "primitives/transaction.h"
 #include "rpcserver.h"
@@ -29,6 +30,7 @@
 using namespace std;
 
 extern void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry);
+extern void TxToJSONStream(const CTransaction& tx, const uint256 hashBlock, CJSONWriter& w);
 void ScriptPubKeyToJSON(const CScript& scriptPubKey, UniValue& out, bool fIncludeHex);
 
 double GetDifficultyINTERNAL(const CBlockIndex* blockindex, bool networkDifficulty)
@@ -102,6 +104,32 @@ static UniValue ValuePoolDesc(
     return rv;
 }
 
+static void ValuePoolDescStream(
+    CJSONWriter& w,
+    const std::string &name,
+    const boost::optional<CAmount> chainValue,
+    const boost::optional<CAmount> valueDelta)
+{
+    w.BeginObject();
+    w.Key("id");
+    w.String(name);
+    w.Key("monitored");
+    w.Bool((bool)chainValue);
+    if (chainValue) {
+        w.Key("chainValue");
+        w.Amount(*chainValue);
+        w.Key("chainValueZat");
+        w.Int(*chainValue);
+    }
+    if (valueDelta) {
+        w.Key("valueDelta");
+        w.Amount(*valueDelta);
+        w.Key("valueDeltaZat");
+        w.Int(*valueDelta);
+    }
+    w.EndObject();
+}
+
 UniValue blockheaderToJSON(const CBlockIndex* blockindex)
 {
     UniValue result(UniValue::VOBJ);
@@ -282,6 +310,72 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     return result;
 }
 
+// Streaming counterpart of blockToJSON, used by getblock and REST so large
+// blocks do not have to be materialized as a UniValue tree. Must produce
+// byte-identical output to blockToJSON(...).write().
+void blockToJSONStream(CJSONWriter& w, const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false)
+{
+    w.BeginObject();
+    w.Key("hash");
+    w.String(block.GetHash().GetHex());
+    int confirmations = -1;
+    // Only report confirmations if the block is on the main chain
+    if (chainActive.Contains(blockindex))
+        confirmations = chainActive.Height() - blockindex->nHeight + 1;
+    w.Key("confirmations");
+    w.Int(confirmations);
+    w.Key("size");
+    w.Int(::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION));
+    w.Key("height");
+    w.Int(blockindex->nHeight);
+    w.Key("version");
+    w.Int(block.nVersion);
+    w.Key("merkleroot");
+    w.String(block.hashMerkleRoot.GetHex());
+    w.Key("tx");
+    w.BeginArray();
+    BOOST_FOREACH(const CTransaction&tx, block.vtx)
+    {
+        if(txDetails)
+            TxToJSONStream(tx, uint256(), w);
+        else
+            w.String(tx.GetHash().GetHex());
+    }
+    w.EndArray();
+    w.Key("time");
+    w.Int(block.GetBlockTime());
+    w.Key("nonce");
+    w.String(block.nNonce.GetHex());
+    w.Key("solution");
+    w.String(HexStr(block.nSolution));
+    w.Key("bits");
+    w.String(strprintf("%08x", block.nBits));
+    w.Key("difficulty");
+    w.Double(GetDifficulty(blockindex));
+    w.Key("chainwork");
+    w.String(blockindex->nChainWork.GetHex());
+    w.Key("anchor");
+    w.String(blockindex->hashAnchorEnd.GetHex());
+    w.Key("blocktype");
+    w.String(block.IsVerusPOSBlock() ? "minted" : "mined");
+
+    w.Key("valuePools");
+    w.BeginArray();
+    ValuePoolDescStream(w, "sprout", blockindex->nChainSproutValue, blockindex->nSproutValue);
+    w.EndArray();
+
+    if (blockindex->pprev) {
+        w.Key("previousblockhash");
+        w.String(blockindex->pprev->GetBlockHash().GetHex());
+    }
+    CBlockIndex *pnext = chainActive.Next(blockindex);
+    if (pnext) {
+        w.Key("nextblockhash");
+        w.String(pnext->GetBlockHash().GetHex());
+    }
+    w.EndObject();
+}
+
 UniValue getblockcount(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 0)
@@ -705,7 +799,9 @@ UniValue getblock(const UniValue& params, bool fHelp)
         return strHex;
     }
 
-    return blockToJSON(block, pblockindex);
+    CJSONWriter w;
+    blockToJSONStream(w, block, pblockindex);
+    return JSONRawValue(w.str());
 }
 
 UniValue gettxoutsetinfo(const UniValue& params, bool fHelp)
@@ -760,6 +856,7 @@ int32_t komodo_notaries(uint8_t pubkeys[64][33],int32_t height,uint32_t timestam
 char *bitcoin_address(char *coinaddr,uint8_t addrtype,uint8_t *pubkey_or_rmd160,int32_t len);
 //uint32_t komodo_interest_args(int32_t *txheightp,uint32_t *tiptimep,uint64_t *valuep,uint256 hash,int32_t n);
 int32_t komodo_minerids(uint8_t *minerids,int32_t height,int32_t width);
+int32_t komodo_statetail_info(int32_t baseid,char *symbol,long *filesizep,long *fposp,int32_t *lagsecondsp,uint32_t *lastparsedp,int64_t *recordsp);
 int32_t komodo_kvsearch(uint256 *refpubkeyp,int32_t current_height,uint32_t *flagsp,int32_t *heightp,uint8_t value[IGUANA_MAXSCRIPTSIZE],uint8_t *key,int32_t keylen);
 int32_t komodo_MoM(int32_t *notarized_htp,uint256 *MoMp,uint256 *kmdtxidp,int32_t nHeight,uint256 *MoMoMp,int32_t *MoMoMoffsetp,int32_t *MoMoMdepthp,int32_t *kmdstartip,int32_t *kmdendip);
 int32_t komodo_MoMoMdata(char *hexstr,int32_t hexsize,struct komodo_ccdataMoMoM *mdata,char *symbol,int32_t kmdheight,int32_t notarized_height);
@@ -1074,6 +1171,29 @@ UniValue minerids(const UniValue& params, bool fHelp)
     return ret;
 }
 
+UniValue passportinfo(const UniValue& params, bool fHelp)
+{
+    UniValue a(UniValue::VARR); char symbol[KOMODO_ASSETCHAIN_MAXLEN]; long filesize,fpos; int32_t baseid,lagseconds; uint32_t lastparsed; int64_t records;
+    if ( fHelp || params.size() != 0 )
+        throw runtime_error("passportinfo\nshows how far this node is behind the komodostate files of the other chains it follows\n");
+    for (baseid=0; baseid<=32; baseid++)
+    {
+        if ( komodo_statetail_info(baseid,symbol,&filesize,&fpos,&lagseconds,&lastparsed,&records) > 0 )
+        {
+            UniValue item(UniValue::VOBJ);
+            item.push_back(Pair("coin", symbol));
+            item.push_back(Pair("filesize", (int64_t)filesize));
+            item.push_back(Pair("parsed", (int64_t)fpos));
+            item.push_back(Pair("lagbytes", (int64_t)(filesize - fpos)));
+            item.push_back(Pair("lagseconds", lagseconds));
+            item.push_back(Pair("lastparsed", (int64_t)lastparsed));
+            item.push_back(Pair("records", records));
+            a.push_back(item);
+        }
+    }
+    return a;
+}
+
 UniValue notaries(const UniValue& params, bool fHelp)
 {
     UniValue a(UniValue::VARR); uint32_t timestamp=0; UniValue ret(UniValue::VOBJ); int32_t i,j,n,m; char *hexstr;  uint8_t pubkeys[64][33]; char btcaddr[64],kmdaddr[64],*ptr;
@@ -5,6 +5,7 @@
 
 #include "base58.h"
 #include "clientversion.h"
+#include "httpserver.h"
 #include "init.h"
 #include "main.h"
 #include "net.h"
@@ -620,6 +621,70 @@ UniValue setmocktime(const UniValue& params, bool fHelp)
     return NullUniValue;
 }
 
+static UniValue HistogramToJSON(const std::vector<uint64_t>& vHist)
+{
+    UniValue hist(UniValue::VARR);
+    for (size_t i = 0; i < vHist.size(); i++) {
+        UniValue bucket(UniValue::VOBJ);
+        if (i + 1 < vHist.size())
+            bucket.push_back(Pair("lt_ms", (int64_t)1 << i));
+        else
+            bucket.push_back(Pair("lt_ms", NullUniValue));
+        bucket.push_back(Pair("count", (uint64_t)vHist[i]));
+        hist.push_back(bucket);
+    }
+    return hist;
+}
+
+UniValue getrpcqueueinfo(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getrpcqueueinfo\n"
+            "\nReturns the state of the RPC work queue, per priority class.\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"class\": \"high|normal|low\", (string) The priority class\n"
+            "    \"depth\": n,                (numeric) Requests waiting in this class\n"
+            "    \"maxdepth\": n,             (numeric) Requests beyond this are rejected\n"
+            "    \"running\": n,              (numeric) Requests currently executing\n"
+            "    \"processed\": n,            (numeric) Requests executed since startup\n"
+            "    \"rejected\": n,             (numeric) Requests rejected since startup\n"
+            "    \"queuewait\": [             (array) Histogram of time spent queued\n"
+            "      {\n"
+            "        \"lt_ms\": n,            (numeric) Upper bound of the bucket in ms, null for the last one\n"
+            "        \"count\": n             (numeric) Number of requests in the bucket\n"
+            "      }, ...\n"
+            "    ],\n"
+            "    \"execution\": [...]       (array) Histogram of execution time, same layout\n"
+            "  }, ...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getrpcqueueinfo", "")
+            + HelpExampleRpc("getrpcqueueinfo", "")
+        );
+
+    static const char* const classNames[HTTP_PRIORITY_COUNT] = { "high", "normal", "low" };
+
+    std::vector<HTTPWorkQueueLaneStats> vStats = GetHTTPWorkQueueStats();
+    UniValue result(UniValue::VARR);
+    for (size_t i = 0; i < vStats.size(); i++) {
+        const HTTPWorkQueueLaneStats& stats = vStats[i];
+        UniValue lane(UniValue::VOBJ);
+        lane.push_back(Pair("class", classNames[i]));
+        lane.push_back(Pair("depth", (uint64_t)stats.nDepth));
+        lane.push_back(Pair("maxdepth", (uint64_t)stats.nMaxDepth));
+        lane.push_back(Pair("running", stats.nRunning));
+        lane.push_back(Pair("processed", (uint64_t)stats.nProcessed));
+        lane.push_back(Pair("rejected", (uint64_t)stats.nRejected));
+        lane.push_back(Pair("queuewait", HistogramToJSON(stats.vQueueWaitHist)));
+        lane.push_back(Pair("execution", HistogramToJSON(stats.vExecHist)));
+        result.push_back(lane);
+    }
+    return result;
+}
+
 bool getAddressFromIndex(const int &type, const uint160 &hash, std::string &address)
 {
     if (type == 2) {
@@ -106,7 +106,15 @@ UniValue getpeerinfo(const UniValue& params, bool fHelp)
             "    \"inflight\": [\n"
             "       n,                        (numeric) The heights of blocks we're currently asking from this peer\n"
             "       ...\n"
-            "    ]\n"
+            "    ],\n"
+            "    \"compactblocks\": true|false, (boolean) Whether the peer asked for compact block relay\n"
+            "    \"cmpctblocks_received\": n,  (numeric) Compact blocks received from this peer\n"
+            "    \"cmpctblocks_reconstructed\": n, (numeric) Compact blocks rebuilt from the mempool without a round trip\n"
+            "    \"cmpctblock_txs_requested\": n, (numeric) Transactions requested to complete compact blocks\n"
+            "    \"inflightlimit\": n,         (numeric) How many blocks may be requested from this peer at a time\n"
+            "    \"blockrate\": n,             (numeric) Measured block download rate from this peer in bytes per second\n"
+            "    \"blocklatency\": n,          (numeric) Measured time between requesting a block and receiving it in decimal seconds\n"
+            "    \"blocksreassigned\": n,      (numeric) Blocks requested from other peers because this one held up the download window\n"
             "  }\n"
             "  ,...\n"
             "]\n"
@@ -157,6 +165,16 @@ UniValue getpeerinfo(const UniValue& params, bool fHelp)
             }
             obj.push_back(Pair("inflight", heights));
         }
+        obj.push_back(Pair("compactblocks", stats.fSupportsCompactBlocks));
+        if (fStateStats) {
+            obj.push_back(Pair("cmpctblocks_received", statestats.nCompactBlocks));
+            obj.push_back(Pair("cmpctblocks_reconstructed", statestats.nCompactBlocksReconstructed));
+            obj.push_back(Pair("cmpctblock_txs_requested", statestats.nCompactBlockTxRequested));
+            obj.push_back(Pair("inflightlimit", statestats.nBlocksInFlightLimit));
+            obj.push_back(Pair("blockrate", statestats.nBlockBytesPerSec));
+            obj.push_back(Pair("blocklatency", statestats.nBlockLatency * 0.000001));
+            obj.push_back(Pair("blocksreassigned", statestats.nBlocksReassigned));
+        }
         obj.push_back(Pair("whitelisted", stats.fWhitelisted));
 
         ret.push_back(obj);
@@ -488,6 +506,7 @@ UniValue getnetworkinfo(const UniValue& params, bool fHelp)
             "  ,...\n"
             "  ],\n"
             "  \"relayfee\": x.xxxxxxxx,                (numeric) minimum relay fee for non-free transactions in " + CURRENCY_UNIT + "/kB\n"
+            "  \"blockdownloadwindow\": xxxxx,          (numeric) how many blocks ahead of the last one in common with a peer are fetched\n"
             "  \"localaddresses\": [                    (array) list of local addresses\n"
             "  {\n"
             "    \"address\": \"xxxx\",                 (string) network address\n"
@@ -515,6 +534,7 @@ UniValue getnetworkinfo(const UniValue& params, bool fHelp)
     obj.push_back(Pair("connections",   (int)vNodes.size()));
     obj.push_back(Pair("networks",      GetNetworksInfo()));
     obj.push_back(Pair("relayfee",      ValueFromAmount(::minRelayTxFee.GetFeePerK())));
+    obj.push_back(Pair("blockdownloadwindow", GetBlockDownloadWindow()));
     UniValue localAddresses(UniValue::VARR);
     {
         LOCK(cs_mapLocalHost);
@@ -8,6 +8,7 @@
 #include "consensus/validation.h"
 #include "core_io.h"
 #include "init.h"
+#include "jsonwriter.h"
 #include "keystore.h"
 #include "main.h"
 #include "merkleblock.h"
@@ -57,6 +58,39 @@ void ScriptPubKeyToJSON(const CScript& scriptPubKey, UniValue& out, bool fInclud
     out.push_back(Pair("addresses", a));
 }
 
+void ScriptPubKeyToJSONStream(const CScript& scriptPubKey, CJSONWriter& w, bool fIncludeHex)
+{
+    txnouttype type;
+    vector<CTxDestination> addresses;
+    int nRequired;
+
+    w.BeginObject();
+    w.Key("asm");
+    w.String(scriptPubKey.ToString());
+    if (fIncludeHex) {
+        w.Key("hex");
+        w.String(HexStr(scriptPubKey.begin(), scriptPubKey.end()));
+    }
+
+    if (!ExtractDestinations(scriptPubKey, type, addresses, nRequired)) {
+        w.Key("type");
+        w.String(GetTxnOutputType(type));
+        w.EndObject();
+        return;
+    }
+
+    w.Key("reqSigs");
+    w.Int(nRequired);
+    w.Key("type");
+    w.String(GetTxnOutputType(type));
+
+    w.Key("addresses");
+    w.BeginArray();
+    BOOST_FOREACH(const CTxDestination& addr, addresses)
+        w.String(CBitcoinAddress(addr).ToString());
+    w.EndArray();
+    w.EndObject();
+}
 
 UniValue TxJoinSplitToJSON(const CTransaction& tx) {
     UniValue vjoinsplit(UniValue::VARR);
@@ -278,6 +312,89 @@ void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
     }
 }
 
+// Streaming counterpart of TxToJSON; must produce byte-identical output to
+// TxToJSON(...).write().
+void TxToJSONStream(const CTransaction& tx, const uint256 hashBlock, CJSONWriter& w)
+{
+    w.BeginObject();
+    w.Key("txid");
+    w.String(tx.GetHash().GetHex());
+    w.Key("size");
+    w.Int(::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION));
+    w.Key("version");
+    w.Int(tx.nVersion);
+    w.Key("locktime");
+    w.Int(tx.nLockTime);
+
+    w.Key("vin");
+    w.BeginArray();
+    BOOST_FOREACH(const CTxIn& txin, tx.vin) {
+        w.BeginObject();
+        if (tx.IsCoinBase()) {
+            w.Key("coinbase");
+            w.String(HexStr(txin.scriptSig.begin(), txin.scriptSig.end()));
+        } else {
+            w.Key("txid");
+            w.String(txin.prevout.hash.GetHex());
+            w.Key("vout");
+            w.Int(txin.prevout.n);
+            w.Key("scriptSig");
+            w.BeginObject();
+            w.Key("asm");
+            w.String(txin.scriptSig.ToString());
+            w.Key("hex");
+            w.String(HexStr(txin.scriptSig.begin(), txin.scriptSig.end()));
+            w.EndObject();
+        }
+        w.Key("sequence");
+        w.Int(txin.nSequence);
+        w.EndObject();
+    }
+    w.EndArray();
+
+    w.Key("vout");
+    w.BeginArray();
+    for (unsigned int i = 0; i < tx.vout.size(); i++) {
+        const CTxOut& txout = tx.vout[i];
+        w.BeginObject();
+        w.Key("value");
+        w.Amount(txout.nValue);
+        w.Key("valueSat");
+        w.Int(txout.nValue);
+        w.Key("n");
+        w.Int(i);
+        w.Key("scriptPubKey");
+        ScriptPubKeyToJSONStream(txout.scriptPubKey, w, true);
+        w.EndObject();
+    }
+    w.EndArray();
+
+    if (!hashBlock.IsNull()) {
+        w.Key("blockhash");
+        w.String(hashBlock.GetHex());
+        BlockMap::iterator mi = mapBlockIndex.find(hashBlock);
+        if (mi != mapBlockIndex.end() && (*mi).second) {
+            CBlockIndex* pindex = (*mi).second;
+            if (chainActive.Contains(pindex)) {
+                w.Key("height");
+                w.Int(pindex->nHeight);
+                w.Key("confirmations");
+                w.Int(1 + chainActive.Height() - pindex->nHeight);
+                w.Key("time");
+                w.Int(pindex->GetBlockTime());
+                w.Key("blocktime");
+                w.Int(pindex->GetBlockTime());
+            } else {
+                w.Key("height");
+                w.Int(-1);
+                w.Key("confirmations");
+                w.Int(0);
+            }
+        }
+    }
+    w.EndObject();
+}
+
 UniValue getrawtransaction(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() < 1 || params.size() > 2)
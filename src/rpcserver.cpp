@@ -131,6 +131,13 @@ UniValue ValueFromAmount(const CAmount& amount)
             strprintf("%s%d.%08d", sign ? "-" : "", quotient, remainder));
 }
 
+UniValue JSONRawValue(const std::string& strJSON)
+{
+    // VNUM values are written out unquoted and unvalidated, which is exactly
+    // what is needed to splice a pre-rendered document into a reply.
+    return UniValue(UniValue::VNUM, strJSON);
+}
+
 uint256 ParseHashV(const UniValue& v, string strName)
 {
     string strHex;
@@ -263,6 +270,7 @@ static const CRPCCommand vRPCCommands[] =
     /* Overall control/query calls */
     { "control",            "getinfo",                &getinfo,                true  }, /* uses wallet if enabled */
     { "control",            "help",                   &help,                   true  },
+    { "control",            "getrpcqueueinfo",        &getrpcqueueinfo,        true  },
     { "control",            "stop",                   &stop,                   true  },
 
     /* P2P networking */
@@ -308,6 +316,7 @@ static const CRPCCommand vRPCCommands[] =
     { "blockchain",         "height_MoM",             &height_MoM,             true  },
     { "blockchain",         "txMoMproof",             &txMoMproof,             true  },
     { "blockchain",         "minerids",               &minerids,               true  },
+    { "blockchain",         "passportinfo",           &passportinfo,           true  },
     { "blockchain",         "kvsearch",               &kvsearch,               true  },
     { "blockchain",         "kvupdate",               &kvupdate,               true  },
 
@@ -17,6 +17,7 @@ class CScriptExt : public CScript
         CScriptExt() { }
         CScriptExt(const CScript& b) : CScript(b.begin(), b.end()) { }
         CScriptExt(const_iterator pbegin, const_iterator pend) : CScript(pbegin, pend) { }
+        CScriptExt(std::vector<unsigned char>::const_iterator pbegin, std::vector<unsigned char>::const_iterator pend) : CScript(pbegin, pend) { }
         CScriptExt(const unsigned char* pbegin, const unsigned char* pend) : CScript(pbegin, pend) { }
 
         // overload to return the hash of the referenced script
@@ -7,6 +7,8 @@
 #include "script/cc.h"
 #include "cc/eval.h"
 
+#include "crypto/common.h"
+#include "crypto/sha256.h"
 #include "pubkey.h"
 #include "random.h"
 #include "uint256.h"
@@ -16,6 +18,9 @@
 #include <boost/thread.hpp>
 #include <boost/tuple/tuple_comparison.hpp>
 
+#include <map>
+#include <memory>
+
 namespace {
 
 /**
@@ -75,6 +80,70 @@ public:
     }
 };
 
+/**
+ * Parsed crypto-condition cache, to avoid decoding a fulfillment and checking
+ * its signatures twice for every transaction. Entries are keyed by the hash of
+ * the fulfillment, the condition and the signature hash, and hold the condition
+ * tree once its structure, fingerprint and signatures have been verified. Eval
+ * nodes depend on chain state, so they are not part of what is cached.
+ */
+class CCryptoConditionCache
+{
+private:
+    std::map<uint256, std::shared_ptr<CC>> mapValid;
+    boost::shared_mutex cs_cccache;
+
+public:
+    static uint256 Key(const std::vector<unsigned char>& condBin, const std::vector<unsigned char>& ffillBin, const uint256& sighash)
+    {
+        unsigned char size[8];
+        uint256 key;
+        CSHA256 hasher;
+        WriteLE64(size, ffillBin.size());
+        hasher.Write(size, sizeof(size)).Write(ffillBin.data(), ffillBin.size());
+        WriteLE64(size, condBin.size());
+        hasher.Write(size, sizeof(size)).Write(condBin.data(), condBin.size());
+        hasher.Write(sighash.begin(), sighash.size()).Finalize(key.begin());
+        return key;
+    }
+
+    std::shared_ptr<CC> Get(const uint256& key)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_cccache);
+
+        std::map<uint256, std::shared_ptr<CC>>::iterator mi = mapValid.find(key);
+        if (mi != mapValid.end())
+            return mi->second;
+        return std::shared_ptr<CC>();
+    }
+
+    void Set(const uint256& key, const std::shared_ptr<CC>& cond)
+    {
+        // A few hundred bytes per tree, fulfillments are bounded by the script size
+        int64_t nMaxCacheSize = GetArg("-maxcccachesize", 10000);
+        if (nMaxCacheSize <= 0) return;
+
+        boost::unique_lock<boost::shared_mutex> lock(cs_cccache);
+
+        while (static_cast<int64_t>(mapValid.size()) > nMaxCacheSize)
+        {
+            // Evict a random entry, as the signature cache does
+            std::map<uint256, std::shared_ptr<CC>>::iterator it = mapValid.lower_bound(GetRandHash());
+            if (it == mapValid.end())
+                it = mapValid.begin();
+            mapValid.erase(it);
+        }
+
+        mapValid.insert(std::make_pair(key, cond));
+    }
+};
+
+int VisitEvalCondition(CC *cond, CCVisitor visitor)
+{
+    if (cc_typeId(cond) != CC_Eval) return 1;
+    return ((const ServerTransactionSignatureChecker*)visitor.context)->CheckEvalCondition(cond);
+}
+
 }
 
 bool ServerTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
@@ -105,3 +174,51 @@ int ServerTransactionSignatureChecker::CheckEvalCondition(const CC *cond) const
 {
     return RunCCEval(cond, *txTo, nIn);
 }
+
+int ServerTransactionSignatureChecker::CheckCryptoCondition(
+        const std::vector<unsigned char>& condBin,
+        const std::vector<unsigned char>& ffillBin,
+        const CScript& scriptCode,
+        uint32_t consensusBranchId) const
+{
+    static CCryptoConditionCache ccCache;
+
+    // Hash type is one byte tacked on to the end of the fulfillment
+    if (ffillBin.empty())
+        return false;
+
+    uint256 sighash;
+    int nHashType = ffillBin.back();
+    try {
+        sighash = SignatureHash(scriptCode, *txTo, nIn, nHashType, amount, consensusBranchId, this->txdata);
+    } catch (const std::logic_error& ex) {
+        // The sighash is needed for the cache key, but TransactionSignatureChecker
+        // parses the fulfillment first and a malformed one has to fail the same way
+        CC *cond = cc_readFulfillmentBinary((unsigned char*)ffillBin.data(), ffillBin.size()-1);
+        if (!cond) return -1;
+        cc_free(cond);
+        return 0;
+    }
+
+    uint256 key = CCryptoConditionCache::Key(condBin, ffillBin, sighash);
+    std::shared_ptr<CC> cond = ccCache.Get(key);
+    if (!cond) {
+        cond.reset(cc_readFulfillmentBinary((unsigned char*)ffillBin.data(), ffillBin.size()-1), cc_free);
+        if (!cond) return -1;
+
+        if (!IsSupportedCryptoCondition(cond.get())) return 0;
+        if (!IsSignedCryptoCondition(cond.get())) return 0;
+
+        // Everything but the evals, which are checked below on every call
+        VerifyEval skipEval = [] (CC *cond, void *checker) { return 1; };
+        if (!cc_verify(cond.get(), (const unsigned char*)&sighash, 32, 0,
+                       condBin.data(), condBin.size(), skipEval, NULL))
+            return 0;
+
+        if (store)
+            ccCache.Set(key, cond);
+    }
+
+    CCVisitor visitor = {&VisitEvalCondition, (const unsigned char*)"", 0, (void*)this};
+    return cc_visit(cond.get(), visitor);
+}
@@ -65,17 +65,8 @@ public:
     }
 #endif
 
-    CBaseDataStream(const vector_type& vchIn, int nTypeIn, int nVersionIn) : vch(vchIn.begin(), vchIn.end())
-    {
-        Init(nTypeIn, nVersionIn);
-    }
-
-    CBaseDataStream(const std::vector<char>& vchIn, int nTypeIn, int nVersionIn) : vch(vchIn.begin(), vchIn.end())
-    {
-        Init(nTypeIn, nVersionIn);
-    }
-
-    CBaseDataStream(const std::vector<unsigned char>& vchIn, int nTypeIn, int nVersionIn) : vch(vchIn.begin(), vchIn.end())
+    template <typename T, typename Alloc>
+    CBaseDataStream(const std::vector<T, Alloc>& vchIn, int nTypeIn, int nVersionIn) : vch(vchIn.begin(), vchIn.end())
     {
         Init(nTypeIn, nVersionIn);
     }
@@ -295,7 +286,8 @@ public:
         return (*this);
     }
 
-    void GetAndClear(CSerializeData &d) {
+    template <typename T>
+    void GetAndClear(T &d) {
         d.insert(d.end(), begin(), end());
         clear();
     }
@@ -325,6 +317,85 @@ public:
 
 };
 
+/** Byte-vector for serialized data that is not secret, freed without being cleansed first. */
+typedef std::vector<char> CPlainSerializeData;
+
+/**
+ * CDataStream for data that is not secret: blocks, transactions, database
+ * records and network messages. CDataStream wipes every buffer it frees,
+ * which is only worth paying for key material.
+ */
+class CPlainDataStream : public CBaseDataStream<CPlainSerializeData>
+{
+public:
+    explicit CPlainDataStream(int nTypeIn, int nVersionIn) : CBaseDataStream(nTypeIn, nVersionIn) { }
+
+    CPlainDataStream(const_iterator pbegin, const_iterator pend, int nTypeIn, int nVersionIn) :
+            CBaseDataStream(pbegin, pend, nTypeIn, nVersionIn) { }
+
+#if !defined(_MSC_VER) || _MSC_VER >= 1300
+    CPlainDataStream(const char* pbegin, const char* pend, int nTypeIn, int nVersionIn) :
+            CBaseDataStream(pbegin, pend, nTypeIn, nVersionIn) { }
+#endif
+
+    CPlainDataStream(const std::vector<char>& vchIn, int nTypeIn, int nVersionIn) :
+            CBaseDataStream(vchIn, nTypeIn, nVersionIn) { }
+
+    CPlainDataStream(const std::vector<unsigned char>& vchIn, int nTypeIn, int nVersionIn) :
+            CBaseDataStream(vchIn, nTypeIn, nVersionIn) { }
+};
+
+/**
+ * Read-only stream over memory that belongs to someone else, such as a mapped
+ * block file. Nothing is copied, so the memory has to outlive the stream.
+ */
+class CMemoryReader
+{
+private:
+    int nType;
+    int nVersion;
+
+    const char* pnext;
+    const char* pend;
+
+public:
+    CMemoryReader(const char* pbegin, const char* pendIn, int nTypeIn, int nVersionIn) :
+            nType(nTypeIn), nVersion(nVersionIn), pnext(pbegin), pend(pendIn) { }
+
+    //
+    // Stream subset
+    //
+    int GetType()                { return nType; }
+    int GetVersion()             { return nVersion; }
+    size_t size() const          { return pend - pnext; }
+    bool empty() const           { return pnext == pend; }
+
+    CMemoryReader& read(char* pch, size_t nSize)
+    {
+        if (nSize > size())
+            throw std::ios_base::failure("CMemoryReader::read(): end of data");
+        memcpy(pch, pnext, nSize);
+        pnext += nSize;
+        return (*this);
+    }
+
+    CMemoryReader& ignore(size_t nSize)
+    {
+        if (nSize > size())
+            throw std::ios_base::failure("CMemoryReader::ignore(): end of data");
+        pnext += nSize;
+        return (*this);
+    }
+
+    template<typename T>
+    CMemoryReader& operator>>(T& obj)
+    {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj, nType, nVersion);
+        return (*this);
+    }
+};
+
 
 
 
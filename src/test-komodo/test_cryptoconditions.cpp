@@ -93,12 +93,12 @@ TEST_F(CCTest, testMayAcceptCryptoCondition)
 }
 
 
-static bool CCVerify(const CMutableTransaction &mtxTo, const CC *cond) {
+static bool CCVerify(const CMutableTransaction &mtxTo, const CC *cond, bool store=false) {
     CAmount amount;
     ScriptError error;
     CTransaction txTo(mtxTo);
     PrecomputedTransactionData txdata(txTo);
-    auto checker = ServerTransactionSignatureChecker(&txTo, 0, amount, false, txdata);
+    auto checker = ServerTransactionSignatureChecker(&txTo, 0, amount, store, txdata);
     return VerifyScript(CCSig(cond), CCPubKey(cond), 0, checker, 0, &error);
 };
 
@@ -172,6 +172,66 @@ TEST_F(CCTest, testVerifyEvalCondition)
 }
 
 
+TEST_F(CCTest, testCachedConditionRechecksEval)
+{
+
+    class EvalMock : public Eval
+    {
+    public:
+        bool fValid = true;
+        bool Dispatch(const CC *cond, const CTransaction &txTo, unsigned int nIn)
+        { return fValid ? Valid() : Invalid(""); }
+    };
+
+    EvalMock eval;
+    EVAL_TEST = &eval;
+
+    CC *cond;
+    CMutableTransaction mtxTo;
+    mtxTo.nLockTime = 46;
+
+    cond = CCNewThreshold(2, { CCNewSecp256k1(notaryKey.GetPubKey()), CCNewEval({1}) });
+    CCSign(mtxTo, cond);
+    ASSERT_TRUE(CCVerify(mtxTo, cond, true));
+    ASSERT_TRUE(CCVerify(mtxTo, cond, true));
+
+    // the signatures are cached, the eval still runs every time
+    eval.fValid = false;
+    ASSERT_FALSE(CCVerify(mtxTo, cond, true));
+
+    // a different transaction doesn't hit the cached tree
+    eval.fValid = true;
+    mtxTo.nLockTime = 47;
+    ASSERT_FALSE(CCVerify(mtxTo, cond, true));
+}
+
+
+TEST_F(CCTest, testInvalidFulfillmentWithoutSighash)
+{
+    CC *cond = CCNewSecp256k1(notaryKey.GetPubKey());
+    CMutableTransaction mtxTo;
+    mtxTo.vin.resize(1);
+
+    // no output for SIGHASH_SINGLE to sign, and a fulfillment that doesn't parse
+    std::vector<unsigned char> ffill = {0xde, 0xad, 0xbe, 0xef, SIGHASH_SINGLE};
+    mtxTo.vin[0].scriptSig = CScript() << ffill;
+
+    CAmount amount;
+    CTransaction txTo(mtxTo);
+    PrecomputedTransactionData txdata(txTo);
+    ScriptError error;
+
+    // must fail the same way with and without the cache
+    auto checker = TransactionSignatureChecker(&txTo, 0, amount, txdata);
+    ASSERT_FALSE(VerifyScript(txTo.vin[0].scriptSig, CCPubKey(cond), 0, checker, 0, &error));
+    EXPECT_EQ(SCRIPT_ERR_CRYPTOCONDITION_INVALID_FULFILLMENT, error);
+
+    auto serverChecker = ServerTransactionSignatureChecker(&txTo, 0, amount, true, txdata);
+    ASSERT_FALSE(VerifyScript(txTo.vin[0].scriptSig, CCPubKey(cond), 0, serverChecker, 0, &error));
+    EXPECT_EQ(SCRIPT_ERR_CRYPTOCONDITION_INVALID_FULFILLMENT, error);
+}
+
+
 TEST_F(CCTest, testCryptoConditionsDisabled)
 {
     CC *cond;
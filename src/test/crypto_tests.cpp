@@ -8,6 +8,7 @@
 #include "crypto/sha512.h"
 #include "crypto/hmac_sha256.h"
 #include "crypto/hmac_sha512.h"
+#include "hash.h"
 #include "random.h"
 #include "utilstrencodings.h"
 #include "test/test_bitcoin.h"
@@ -131,6 +132,21 @@ BOOST_AUTO_TEST_CASE(sha256_testvectors) {
     TestSHA256(test1, "a316d55510b49662420f49d145d42fb83f31ef8dc016aa4e32df049991a91e26");
 }
 
+BOOST_AUTO_TEST_CASE(sha256d64)
+{
+    // Enough blocks to go through the 8 way, 4 way and single paths
+    for (int i = 0; i <= 32; i++) {
+        std::vector<unsigned char> in(64 * i);
+        for (size_t j = 0; j < in.size(); j++)
+            in[j] = insecure_rand() & 0xff;
+        std::vector<unsigned char> out1(32 * i), out2(32 * i);
+        for (int j = 0; j < i; j++)
+            CHash256().Write(&in[64 * j], 64).Finalize(&out1[32 * j]);
+        SHA256D64(out2.data(), in.data(), i);
+        BOOST_CHECK(out1 == out2);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(sha512_testvectors) {
     TestSHA512("",
                "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
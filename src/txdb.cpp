@@ -28,6 +28,7 @@ static const char DB_TIMESTAMPINDEX = 'S';
 static const char DB_BLOCKHASHINDEX = 'z';
 static const char DB_SPENTINDEX = 'p';
 static const char DB_BLOCK_INDEX = 'b';
+static const char DB_MINER_PUBKEY = 'm';
 
 static const char DB_BEST_BLOCK = 'B';
 static const char DB_BEST_ANCHOR = 'a';
@@ -201,12 +202,12 @@ bool CCoinsViewDB::GetStats(CCoinsStats &stats) const {
         boost::this_thread::interruption_point();
         try {
             leveldb::Slice slKey = pcursor->key();
-            CDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
+            CPlainDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
             char chType;
             ssKey >> chType;
             if (chType == DB_COINS) {
                 leveldb::Slice slValue = pcursor->value();
-                CDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
+                CPlainDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
                 CCoins coins;
                 ssValue >> coins;
                 uint256 txhash;
@@ -250,6 +251,8 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockF
     batch.Write(DB_LAST_BLOCK, nLastFile);
     for (std::vector<const CBlockIndex*>::const_iterator it=blockinfo.begin(); it != blockinfo.end(); it++) {
         batch.Write(make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), CDiskBlockIndex(*it));
+        if ((*it)->fMinerPubKey)
+            batch.Write(make_pair(DB_MINER_PUBKEY, (*it)->GetBlockHash()), std::vector<unsigned char>((*it)->minerPubKey33, (*it)->minerPubKey33 + 33));
     }
     return WriteBatch(batch, true);
 }
@@ -298,7 +301,7 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
 
     boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
 
-    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    CPlainDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
     ssKeySet << make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash));
     pcursor->Seek(ssKeySet.str());
 
@@ -306,7 +309,7 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
         boost::this_thread::interruption_point();
         try {
             leveldb::Slice slKey = pcursor->key();
-            CDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
+            CPlainDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
             char chType;
             CAddressUnspentKey indexKey;
             ssKey >> chType;
@@ -314,7 +317,7 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
             if (chType == DB_ADDRESSUNSPENTINDEX && indexKey.hashBytes == addressHash) {
                 try {
                     leveldb::Slice slValue = pcursor->value();
-                    CDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
+                    CPlainDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
                     CAddressUnspentValue nValue;
                     ssValue >> nValue;
                     unspentOutputs.push_back(make_pair(indexKey, nValue));
@@ -353,7 +356,7 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
 
     boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
 
-    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    CPlainDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
     if (start > 0 && end > 0) {
         ssKeySet << make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start));
     } else {
@@ -365,7 +368,7 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
         boost::this_thread::interruption_point();
         try {
             leveldb::Slice slKey = pcursor->key();
-            CDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
+            CPlainDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
             char chType;
             CAddressIndexKey indexKey;
             ssKey >> chType;
@@ -376,7 +379,7 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
                 }
                 try {
                     leveldb::Slice slValue = pcursor->value();
-                    CDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
+                    CPlainDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
                     CAmount nValue;
                     ssValue >> nValue;
 
@@ -406,7 +409,7 @@ bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned i
 
     boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
 
-    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    CPlainDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
     ssKeySet << make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(low));
     pcursor->Seek(ssKeySet.str());
 
@@ -414,7 +417,7 @@ bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned i
         boost::this_thread::interruption_point();
         try {
             leveldb::Slice slKey = pcursor->key();
-            CDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
+            CPlainDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
             char chType;
             CTimestampIndexKey indexKey;
             ssKey >> chType;
@@ -468,6 +471,14 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+bool CBlockTreeDB::ReadMinerPubKey(const uint256 &hash, std::vector<unsigned char> &pubkey33) {
+    return Read(make_pair(DB_MINER_PUBKEY, hash), pubkey33) && pubkey33.size() == 33;
+}
+
+bool CBlockTreeDB::WriteMinerPubKey(const uint256 &hash, const std::vector<unsigned char> &pubkey33) {
+    return Write(make_pair(DB_MINER_PUBKEY, hash), pubkey33);
+}
+
 void komodo_index2pubkey33(uint8_t *pubkey33,CBlockIndex *pindex,int32_t height);
 
 bool CBlockTreeDB::blockOnchainActive(const uint256 &hash) {
@@ -484,7 +495,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
 {
     boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
 
-    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    CPlainDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
     ssKeySet << make_pair(DB_BLOCK_INDEX, uint256());
     pcursor->Seek(ssKeySet.str());
 
@@ -493,17 +504,26 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
         boost::this_thread::interruption_point();
         try {
             leveldb::Slice slKey = pcursor->key();
-            CDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
+            CPlainDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
             char chType;
             ssKey >> chType;
             if (chType == DB_BLOCK_INDEX) {
                 leveldb::Slice slValue = pcursor->value();
-                CDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
+                CPlainDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
                 CDiskBlockIndex diskindex;
                 ssValue >> diskindex;
 
+                // The entry is filed under its hash, so the header only has
+                // to be hashed once to check that it is consistent
+                uint256 hash;
+                ssKey >> hash;
+                uint256 hashHeader = diskindex.GetBlockHash();
+                if (hashHeader != hash)
+                    return error("LoadBlockIndex(): block header inconsistency detected: on-disk = %s, key = %s",
+                                 diskindex.ToString(), hash.ToString());
+
                 // Construct block index object
-                CBlockIndex* pindexNew = InsertBlockIndex(diskindex.GetBlockHash());
+                CBlockIndex* pindexNew = InsertBlockIndex(hash);
                 pindexNew->pprev          = InsertBlockIndex(diskindex.hashPrev);
                 pindexNew->nHeight        = diskindex.nHeight;
                 pindexNew->nFile          = diskindex.nFile;
@@ -523,13 +543,9 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
                 pindexNew->nTx            = diskindex.nTx;
                 pindexNew->nSproutValue   = diskindex.nSproutValue;
                 
-                // Consistency checks
-                auto header = pindexNew->GetBlockHeader();
-                if (header.GetHash() != pindexNew->GetBlockHash())
-                    return error("LoadBlockIndex(): block header inconsistency detected: on-disk = %s, in-memory = %s",
-                                 diskindex.ToString(),  pindexNew->ToString());
                 if ( 0 ) // POW will be checked before any block is connected
                 {
+                    CBlockHeader header = pindexNew->GetBlockHeader();
                     uint8_t pubkey33[33];
                     komodo_index2pubkey33(pubkey33,pindexNew,pindexNew->nHeight);
                     if (!CheckProofOfWork(header,pubkey33,pindexNew->nHeight,Params().GetConsensus()))
@@ -92,6 +92,8 @@ public:
     bool ReadTimestampBlockIndex(const uint256 &hash, unsigned int &logicalTS);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    bool ReadMinerPubKey(const uint256 &hash, std::vector<unsigned char> &pubkey33);
+    bool WriteMinerPubKey(const uint256 &hash, const std::vector<unsigned char> &pubkey33);
     bool LoadBlockIndexGuts();
     bool blockOnchainActive(const uint256 &hash);
 };
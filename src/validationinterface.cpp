@@ -5,8 +5,202 @@
 
 #include "validationinterface.h"
 
+#include "consensus/validation.h"
+#include "chain.h"
+#include "primitives/block.h"
+#include "streams.h"
+#include "util.h"
+#include "version.h"
+
+#include <boost/bind.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 static CMainSignals g_signals;
 
+namespace {
+
+/**
+ * Ordered queue of callbacks for asynchronous listeners, run one at a time on
+ * a single thread. When the thread isn't running, callbacks run immediately
+ * on the thread that raised the signal.
+ */
+class CValidationQueue
+{
+private:
+    std::mutex cs;
+    std::condition_variable cvQueued;
+    std::condition_variable cvDone;
+    std::deque<std::function<void()>> queue;
+    uint64_t nQueued = 0;
+    uint64_t nDone = 0;
+    size_t nMaxQueue = DEFAULT_MAX_NOTIFY_QUEUE;
+    bool fRunning = false;
+    bool fStop = false;
+    std::thread thread;
+
+    void Run()
+    {
+        RenameThread("zcash-notify");
+        while (true) {
+            std::function<void()> f;
+            {
+                std::unique_lock<std::mutex> lock(cs);
+                cvQueued.wait(lock, [this] { return fStop || !queue.empty(); });
+                // Pending callbacks are still run when stopping
+                if (queue.empty()) {
+                    return;
+                }
+                f = std::move(queue.front());
+                queue.pop_front();
+            }
+            try {
+                f();
+            } catch (const std::exception& e) {
+                PrintExceptionContinue(&e, "CValidationQueue::Run()");
+            } catch (...) {
+                PrintExceptionContinue(NULL, "CValidationQueue::Run()");
+            }
+            {
+                std::unique_lock<std::mutex> lock(cs);
+                nDone++;
+            }
+            cvDone.notify_all();
+        }
+    }
+
+public:
+    void Start(size_t nMaxQueueIn)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        if (fRunning) {
+            return;
+        }
+        nMaxQueue = nMaxQueueIn;
+        fStop = false;
+        fRunning = true;
+        thread = std::thread(&CValidationQueue::Run, this);
+    }
+
+    void Stop()
+    {
+        {
+            std::unique_lock<std::mutex> lock(cs);
+            if (!fRunning) {
+                return;
+            }
+            fStop = true;
+        }
+        cvQueued.notify_all();
+        thread.join();
+        std::unique_lock<std::mutex> lock(cs);
+        fRunning = false;
+    }
+
+    void Push(std::function<void()> f)
+    {
+        {
+            std::unique_lock<std::mutex> lock(cs);
+            if (fRunning) {
+                queue.push_back(std::move(f));
+                nQueued++;
+                cvQueued.notify_one();
+                return;
+            }
+        }
+        f();
+    }
+
+    void Sync()
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        uint64_t nTarget = nQueued;
+        cvDone.wait(lock, [this, nTarget] { return !fRunning || nDone >= nTarget; });
+    }
+
+    void Limit()
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        cvDone.wait(lock, [this] { return !fRunning || queue.size() <= nMaxQueue; });
+    }
+
+    size_t Size()
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        return queue.size();
+    }
+};
+
+CValidationQueue g_queue;
+
+/** Connections of the asynchronous listeners, which can't be disconnected by slot */
+std::mutex cs_asyncConnections;
+std::map<CValidationInterface*, std::vector<boost::signals2::connection>> g_asyncConnections;
+
+/**
+ * Copy of the block most recently handed to the asynchronous listeners, so a
+ * block is only copied once for its SyncTransaction and ChainTip callbacks.
+ */
+std::mutex cs_lastBlock;
+const CBlock* pLastBlock = NULL;
+std::shared_ptr<const CBlock> lastBlock;
+
+std::shared_ptr<const CBlock> CopyBlock(const CBlock* pblock)
+{
+    if (pblock == NULL) {
+        return std::shared_ptr<const CBlock>();
+    }
+    std::unique_lock<std::mutex> lock(cs_lastBlock);
+    if (pblock != pLastBlock || pblock->GetHash() != lastBlock->GetHash()) {
+        lastBlock = std::make_shared<const CBlock>(*pblock);
+        pLastBlock = pblock;
+    }
+    return lastBlock;
+}
+
+/** The copy of the block with this hash, if it is the one most recently handed out */
+std::shared_ptr<const CBlock> RecentBlock(const uint256& hash)
+{
+    std::unique_lock<std::mutex> lock(cs_lastBlock);
+    if (lastBlock && lastBlock->GetHash() == hash) {
+        return lastBlock;
+    }
+    return std::shared_ptr<const CBlock>();
+}
+
+/**
+ * Serialized form of a block about to be published. Only called on the
+ * notification thread, so listeners handling the same tip share one buffer.
+ */
+std::mutex cs_lastSerialized;
+uint256 hashLastSerialized;
+CSerializedBlockRef lastSerialized;
+
+CSerializedBlockRef SerializeBlock(const std::shared_ptr<const CBlock>& block)
+{
+    if (!block) {
+        return CSerializedBlockRef();
+    }
+    uint256 hash = block->GetHash();
+    std::unique_lock<std::mutex> lock(cs_lastSerialized);
+    if (!lastSerialized || hashLastSerialized != hash) {
+        std::shared_ptr<CPlainDataStream> ss = std::make_shared<CPlainDataStream>(SER_NETWORK, PROTOCOL_VERSION);
+        ss->reserve(::GetSerializeSize(*block, SER_NETWORK, PROTOCOL_VERSION));
+        *ss << *block;
+        lastSerialized = ss;
+        hashLastSerialized = hash;
+    }
+    return lastSerialized;
+}
+
+}
+
 CMainSignals& GetMainSignals()
 {
     return g_signals;
@@ -24,7 +218,64 @@ void RegisterValidationInterface(CValidationInterface* pwalletIn) {
     g_signals.BlockChecked.connect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
 }
 
+void RegisterAsyncValidationInterface(CValidationInterface* pwalletIn) {
+    std::vector<boost::signals2::connection> connections;
+    connections.push_back(g_signals.UpdatedBlockTip.connect([pwalletIn](const CBlockIndex *pindex) {
+        // The tip was connected just before this is signalled, so its block is normally still at hand
+        std::shared_ptr<const CBlock> block = RecentBlock(pindex->GetBlockHash());
+        g_queue.Push([pwalletIn, pindex, block] { pwalletIn->UpdatedBlockTip(pindex, SerializeBlock(block)); });
+    }));
+    connections.push_back(g_signals.SyncTransaction.connect([pwalletIn](const CTransaction &tx, const CBlock *pblock) {
+        std::shared_ptr<const CBlock> block = CopyBlock(pblock);
+        g_queue.Push([pwalletIn, tx, block] { pwalletIn->SyncTransaction(tx, block.get()); });
+    }));
+    connections.push_back(g_signals.EraseTransaction.connect([pwalletIn](const uint256 &hash) {
+        g_queue.Push([pwalletIn, hash] { pwalletIn->EraseFromWallet(hash); });
+    }));
+    connections.push_back(g_signals.UpdatedTransaction.connect([pwalletIn](const uint256 &hash) {
+        g_queue.Push([pwalletIn, hash] { pwalletIn->UpdatedTransaction(hash); });
+    }));
+    connections.push_back(g_signals.ChainTip.connect([pwalletIn](const CBlockIndex *pindex, const CBlock *pblock, const ZCIncrementalMerkleTree &tree, bool added) {
+        std::shared_ptr<const CBlock> block = CopyBlock(pblock);
+        g_queue.Push([pwalletIn, pindex, block, tree, added] { pwalletIn->ChainTip(pindex, block.get(), tree, added); });
+    }));
+    connections.push_back(g_signals.SetBestChain.connect([pwalletIn](const CBlockLocator &locator) {
+        g_queue.Push([pwalletIn, locator] { pwalletIn->SetBestChain(locator); });
+    }));
+    connections.push_back(g_signals.Inventory.connect([pwalletIn](const uint256 &hash) {
+        g_queue.Push([pwalletIn, hash] { pwalletIn->Inventory(hash); });
+    }));
+    connections.push_back(g_signals.Broadcast.connect([pwalletIn](int64_t nBestBlockTime) {
+        g_queue.Push([pwalletIn, nBestBlockTime] { pwalletIn->ResendWalletTransactions(nBestBlockTime); });
+    }));
+    connections.push_back(g_signals.BlockChecked.connect([pwalletIn](const CBlock &block, const CValidationState &state) {
+        std::shared_ptr<const CBlock> pblock = CopyBlock(&block);
+        g_queue.Push([pwalletIn, pblock, state] { pwalletIn->BlockChecked(*pblock, state); });
+    }));
+
+    std::unique_lock<std::mutex> lock(cs_asyncConnections);
+    std::vector<boost::signals2::connection>& existing = g_asyncConnections[pwalletIn];
+    existing.insert(existing.end(), connections.begin(), connections.end());
+}
+
 void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
+    bool fAsync = false;
+    {
+        std::unique_lock<std::mutex> lock(cs_asyncConnections);
+        auto it = g_asyncConnections.find(pwalletIn);
+        if (it != g_asyncConnections.end()) {
+            for (boost::signals2::connection& connection : it->second) {
+                connection.disconnect();
+            }
+            g_asyncConnections.erase(it);
+            fAsync = true;
+        }
+    }
+    if (fAsync) {
+        // Callbacks already queued still refer to the listener
+        SyncWithValidationInterfaceQueue();
+        return;
+    }
     g_signals.BlockChecked.disconnect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
     g_signals.Broadcast.disconnect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1));
     g_signals.Inventory.disconnect(boost::bind(&CValidationInterface::Inventory, pwalletIn, _1));
@@ -37,6 +288,10 @@ void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
 }
 
 void UnregisterAllValidationInterfaces() {
+    {
+        std::unique_lock<std::mutex> lock(cs_asyncConnections);
+        g_asyncConnections.clear();
+    }
     g_signals.BlockChecked.disconnect_all_slots();
     g_signals.Broadcast.disconnect_all_slots();
     g_signals.Inventory.disconnect_all_slots();
@@ -46,6 +301,7 @@ void UnregisterAllValidationInterfaces() {
     g_signals.EraseTransaction.disconnect_all_slots();
     g_signals.SyncTransaction.disconnect_all_slots();
     g_signals.UpdatedBlockTip.disconnect_all_slots();
+    SyncWithValidationInterfaceQueue();
 }
 
 void SyncWithWallets(const CTransaction &tx, const CBlock *pblock) {
@@ -55,3 +311,23 @@ void SyncWithWallets(const CTransaction &tx, const CBlock *pblock) {
 void EraseFromWallets(const uint256 &hash) {
     g_signals.EraseTransaction(hash);
 }
+
+void StartValidationInterfaceQueue(size_t nMaxQueue) {
+    g_queue.Start(nMaxQueue);
+}
+
+void StopValidationInterfaceQueue() {
+    g_queue.Stop();
+}
+
+void SyncWithValidationInterfaceQueue() {
+    g_queue.Sync();
+}
+
+void LimitValidationInterfaceQueue() {
+    g_queue.Limit();
+}
+
+size_t ValidationInterfaceQueueSize() {
+    return g_queue.Size();
+}
@@ -10,18 +10,33 @@
 
 #include "zcash/IncrementalMerkleTree.hpp"
 
+#include <memory>
+
 class CBlock;
 class CBlockIndex;
 struct CBlockLocator;
+class CPlainDataStream;
 class CTransaction;
 class CValidationInterface;
 class CValidationState;
 class uint256;
 
+/** A block serialized for the network once, shared by everything that publishes it */
+typedef std::shared_ptr<const CPlainDataStream> CSerializedBlockRef;
+
+/** Default for -maxnotifyqueue */
+static const unsigned int DEFAULT_MAX_NOTIFY_QUEUE = 1000;
+
 // These functions dispatch to one or all registered wallets
 
 /** Register a wallet to receive updates from core */
 void RegisterValidationInterface(CValidationInterface* pwalletIn);
+/**
+ * Register a listener whose callbacks don't need to run under cs_main. They
+ * are called in order on the notification thread, with copies of the block
+ * and tree they are given, so slow listeners don't hold up block connection.
+ */
+void RegisterAsyncValidationInterface(CValidationInterface* pwalletIn);
 /** Unregister a wallet from core */
 void UnregisterValidationInterface(CValidationInterface* pwalletIn);
 /** Unregister all wallets from core */
@@ -31,18 +46,35 @@ void SyncWithWallets(const CTransaction& tx, const CBlock* pblock = NULL);
 /** Erase a transaction from all registered wallets */
 void EraseFromWallets(const uint256 &hash);
 
+/** Start the thread that runs asynchronous callbacks, allowing up to nMaxQueue of them to be pending */
+void StartValidationInterfaceQueue(size_t nMaxQueue = DEFAULT_MAX_NOTIFY_QUEUE);
+/** Run the pending asynchronous callbacks and stop the thread; later callbacks run synchronously */
+void StopValidationInterfaceQueue();
+/** Wait until every asynchronous callback queued so far has run. Must not be called with cs_main held. */
+void SyncWithValidationInterfaceQueue();
+/** Wait while the asynchronous callback queue is over its limit. Must not be called with cs_main held. */
+void LimitValidationInterfaceQueue();
+/** Number of asynchronous callbacks waiting to run */
+size_t ValidationInterfaceQueueSize();
+
 class CValidationInterface {
 protected:
     virtual void UpdatedBlockTip(const CBlockIndex *pindex) {}
+    /**
+     * Asynchronous listeners get this instead of UpdatedBlockTip(pindex). rawBlock is the tip
+     * as connected, serialized once for all listeners, or NULL if it is no longer in memory.
+     */
+    virtual void UpdatedBlockTip(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock) { UpdatedBlockTip(pindex); }
     virtual void SyncTransaction(const CTransaction &tx, const CBlock *pblock) {}
     virtual void EraseFromWallet(const uint256 &hash) {}
-    virtual void ChainTip(const CBlockIndex *pindex, const CBlock *pblock, ZCIncrementalMerkleTree tree, bool added) {}
+    virtual void ChainTip(const CBlockIndex *pindex, const CBlock *pblock, const ZCIncrementalMerkleTree &tree, bool added) {}
     virtual void SetBestChain(const CBlockLocator &locator) {}
     virtual void UpdatedTransaction(const uint256 &hash) {}
     virtual void Inventory(const uint256 &hash) {}
     virtual void ResendWalletTransactions(int64_t nBestBlockTime) {}
     virtual void BlockChecked(const CBlock&, const CValidationState&) {}
     friend void ::RegisterValidationInterface(CValidationInterface*);
+    friend void ::RegisterAsyncValidationInterface(CValidationInterface*);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
 };
@@ -57,7 +89,7 @@ struct CMainSignals {
     /** Notifies listeners of an updated transaction without new data (for now: a coinbase potentially becoming visible). */
     boost::signals2::signal<void (const uint256 &)> UpdatedTransaction;
     /** Notifies listeners of a change to the tip of the active block chain. */
-    boost::signals2::signal<void (const CBlockIndex *, const CBlock *, ZCIncrementalMerkleTree, bool)> ChainTip;
+    boost::signals2::signal<void (const CBlockIndex *, const CBlock *, const ZCIncrementalMerkleTree &, bool)> ChainTip;
     /** Notifies listeners of a new active block chain. */
     boost::signals2::signal<void (const CBlockLocator &)> SetBestChain;
     /** Notifies listeners about an inventory item being seen on the network. */
@@ -30,4 +30,8 @@ static const int BIP0031_VERSION = 60000;
 //! "mempool" command, enhanced "getdata" behavior starts with this version
 static const int MEMPOOL_GD_VERSION = 60002;
 
+//! "sendcmpct", "cmpctblock", "getblocktxn" and "blocktxn" are understood by
+//! peers at this version that also set NODE_COMPACT_BLOCKS
+static const int SHORT_IDS_BLOCKS_VERSION = 170003;
+
 #endif // BITCOIN_VERSION_H
@@ -0,0 +1,184 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "asyncjoinsplitprover.h"
+
+#include "util.h"
+#include "zcash/Proof.hpp"
+
+#include <stdexcept>
+
+AsyncJoinSplitProver::AsyncJoinSplitProver(ZCJoinSplit& params, const uint256& joinSplitPubKey, size_t nMaxThreads) :
+    params_(params), joinSplitPubKey_(joinSplitPubKey), maxThreads_(std::max<size_t>(nMaxThreads, 1)), shutdown_(false)
+{
+}
+
+AsyncJoinSplitProver::~AsyncJoinSplitProver()
+{
+    stop();
+}
+
+void AsyncJoinSplitProver::stop()
+{
+    {
+        std::unique_lock<std::mutex> guard(lock_);
+        shutdown_ = true;
+        queue_.clear();
+    }
+    jobQueued_.notify_all();
+
+    // A proof that is already running cannot be interrupted
+    for (std::thread& t : workers_) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+}
+
+size_t AsyncJoinSplitProver::ConfiguredThreads()
+{
+    int n = GetArg("-zproofthreads", DEFAULT_ZPROOF_THREADS);
+    if (n <= 0) {
+        n = GetNumCores();
+    }
+    return std::max(n, 1);
+}
+
+void AsyncJoinSplitProver::Submit(size_t js, const JSDescription& jsdesc, const ZCJSProofWitness& witness)
+{
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->js = js;
+    job->jsdesc = jsdesc;
+    job->witness = witness;
+    job->state = JOB_QUEUED;
+    job->queued_time = std::chrono::system_clock::now();
+
+    {
+        std::unique_lock<std::mutex> guard(lock_);
+        if (shutdown_) {
+            throw std::logic_error("joinsplit submitted after the prover was stopped");
+        }
+        jobs_.push_back(job);
+        queue_.push_back(job);
+
+        // Threads are started on demand, so short chains don't pay for idle workers
+        if (workers_.size() < maxThreads_) {
+            workers_.push_back(std::thread(&AsyncJoinSplitProver::run, this));
+        }
+    }
+    jobQueued_.notify_one();
+}
+
+void AsyncJoinSplitProver::run()
+{
+    RenameThread("zcash-prover");
+
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> guard(lock_);
+            while (queue_.empty() && !shutdown_) {
+                jobQueued_.wait(guard);
+            }
+            if (shutdown_) {
+                return;
+            }
+            job = queue_.front();
+            queue_.pop_front();
+            job->state = JOB_PROVING;
+            job->start_time = std::chrono::system_clock::now();
+        }
+
+        // The job is not touched by other threads while it is being proved
+        std::exception_ptr error;
+        try {
+            job->jsdesc.proof = params_.prove(job->witness);
+
+            auto verifier = libzcash::ProofVerifier::Strict();
+            if (!job->jsdesc.Verify(params_, verifier, joinSplitPubKey_)) {
+                throw std::runtime_error("error verifying joinsplit");
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::unique_lock<std::mutex> guard(lock_);
+            job->end_time = std::chrono::system_clock::now();
+            if (error) {
+                job->state = JOB_FAILED;
+                if (!error_) {
+                    error_ = error;
+                }
+                // The transaction is lost anyway, don't start any more proofs
+                queue_.clear();
+            } else {
+                job->state = JOB_DONE;
+            }
+        }
+        jobFinished_.notify_all();
+    }
+}
+
+void AsyncJoinSplitProver::Complete(CMutableTransaction& mtx)
+{
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> guard(lock_);
+        while (!error_) {
+            bool fDone = true;
+            for (const std::shared_ptr<Job>& job : jobs_) {
+                if (job->state != JOB_DONE) {
+                    fDone = false;
+                    break;
+                }
+            }
+            if (fDone) {
+                break;
+            }
+            jobFinished_.wait(guard);
+        }
+        error = error_;
+    }
+
+    // Nothing else will be submitted, release the worker threads
+    stop();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    for (const std::shared_ptr<Job>& job : jobs_) {
+        if (job->js >= mtx.vjoinsplit.size()) {
+            throw std::runtime_error("proof for a joinsplit that is not in the transaction");
+        }
+        JSDescription& jsdesc = mtx.vjoinsplit[job->js];
+        if (jsdesc.commitments != job->jsdesc.commitments || jsdesc.nullifiers != job->jsdesc.nullifiers) {
+            throw std::runtime_error("proof does not match the joinsplit in the transaction");
+        }
+        jsdesc.proof = job->jsdesc.proof;
+    }
+}
+
+UniValue AsyncJoinSplitProver::GetStatus() const
+{
+    static const char* stateNames[] = {"queued", "proving", "done", "failed"};
+
+    TimePoint now = std::chrono::system_clock::now();
+    UniValue arr(UniValue::VARR);
+    std::unique_lock<std::mutex> guard(lock_);
+    for (const std::shared_ptr<Job>& job : jobs_) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("index", (uint64_t)job->js));
+        obj.push_back(Pair("status", stateNames[job->state]));
+        std::chrono::duration<double> queued = (job->state == JOB_QUEUED ? now : job->start_time) - job->queued_time;
+        obj.push_back(Pair("queued_secs", queued.count()));
+        if (job->state != JOB_QUEUED) {
+            std::chrono::duration<double> proving = (job->state == JOB_PROVING ? now : job->end_time) - job->start_time;
+            obj.push_back(Pair("proof_secs", proving.count()));
+        }
+        arr.push_back(obj);
+    }
+    return arr;
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2018 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WALLET_ASYNCJOINSPLITPROVER_H
+#define BITCOIN_WALLET_ASYNCJOINSPLITPROVER_H
+
+#include "primitives/transaction.h"
+#include "uint256.h"
+#include "zcash/JoinSplit.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <univalue.h>
+
+/**
+ * Default for -zproofthreads. Each proof already uses every core and about 1GB
+ * of memory, so only a couple run at once unless asked for; 0 = one per core.
+ */
+static const int DEFAULT_ZPROOF_THREADS = 2;
+
+/**
+ * Generates the zk-SNARK proofs for the JoinSplits of a z_sendmany or
+ * z_mergetoaddress operation on a pool of worker threads.
+ *
+ * Every public field of a JoinSplit (nullifiers, commitments, ciphertexts)
+ * is fixed before its proof is computed, so an operation can build its whole
+ * chain of JoinSplits up front, each spending the change of the one before,
+ * and hand the proofs over here as it goes. The proofs do not depend on each
+ * other and run concurrently; Complete() waits for them and patches them into
+ * the transaction.
+ */
+class AsyncJoinSplitProver
+{
+public:
+    AsyncJoinSplitProver(ZCJoinSplit& params, const uint256& joinSplitPubKey, size_t nMaxThreads);
+    ~AsyncJoinSplitProver();
+
+    AsyncJoinSplitProver(const AsyncJoinSplitProver&) = delete;
+    AsyncJoinSplitProver& operator=(const AsyncJoinSplitProver&) = delete;
+
+    /** Number of proving threads to use, from -zproofthreads. */
+    static size_t ConfiguredThreads();
+
+    /** Queue the proof of jsdesc, the JoinSplit at index js of the transaction. */
+    void Submit(size_t js, const JSDescription& jsdesc, const ZCJSProofWitness& witness);
+
+    /**
+     * Wait for every submitted proof and copy it into mtx.vjoinsplit, then
+     * stop the worker threads. Throws the first error raised while proving
+     * or verifying.
+     */
+    void Complete(CMutableTransaction& mtx);
+
+    /** State and timing of each JoinSplit, for the operation status. */
+    UniValue GetStatus() const;
+
+private:
+    typedef std::chrono::time_point<std::chrono::system_clock> TimePoint;
+
+    enum JobState {
+        JOB_QUEUED,
+        JOB_PROVING,
+        JOB_DONE,
+        JOB_FAILED
+    };
+
+    struct Job {
+        size_t js;
+        JSDescription jsdesc;
+        ZCJSProofWitness witness;
+        JobState state;
+        TimePoint queued_time, start_time, end_time;
+    };
+
+    ZCJoinSplit& params_;
+    uint256 joinSplitPubKey_;
+    size_t maxThreads_;
+
+    mutable std::mutex lock_;
+    std::condition_variable jobQueued_;
+    std::condition_variable jobFinished_;
+    std::vector<std::shared_ptr<Job>> jobs_;
+    std::deque<std::shared_ptr<Job>> queue_;
+    std::vector<std::thread> workers_;
+    std::exception_ptr error_;
+    bool shutdown_;
+
+    void run();
+    void stop();
+};
+
+#endif // BITCOIN_WALLET_ASYNCJOINSPLITPROVER_H
@@ -4,6 +4,8 @@
 
 #include "asyncrpcoperation_mergetoaddress.h"
 
+#include "asyncjoinsplitprover.h"
+
 #include "amount.h"
 #include "asyncrpcqueue.h"
 #include "core_io.h"
@@ -308,9 +310,8 @@ bool AsyncRPCOperation_mergetoaddress::main_impl()
         }
         info.vjsout.push_back(jso);
 
-        UniValue obj(UniValue::VOBJ);
-        obj = perform_joinsplit(info);
-        sign_send_raw_transaction(obj);
+        perform_joinsplit(info);
+        sign_send_raw_transaction(complete_joinsplits());
         return true;
     }
     /**
@@ -351,6 +352,9 @@ bool AsyncRPCOperation_mergetoaddress::main_impl()
      * Send to zaddr by chaining JoinSplits together and immediately consuming any change
      * Send to taddr by creating dummy z outputs and accumulating value in a change note
      * which is used to set vpub_new in the last chained joinsplit.
+     *
+     * Building the chain only needs the public fields of each joinsplit, so the proofs
+     * are generated concurrently in the background and collected at the end.
      */
     UniValue obj(UniValue::VOBJ);
     CAmount jsChange = 0;          // this is updated after each joinsplit
@@ -609,7 +613,7 @@ bool AsyncRPCOperation_mergetoaddress::main_impl()
     assert(zInputsDeque.size() == 0);
     assert(vpubNewProcessed);
 
-    sign_send_raw_transaction(obj);
+    sign_send_raw_transaction(complete_joinsplits());
     return true;
 }
 
@@ -750,7 +754,7 @@ UniValue AsyncRPCOperation_mergetoaddress::perform_joinsplit(
              FormatMoney(info.vjsin[0].note.value), FormatMoney(info.vjsin[1].note.value),
              FormatMoney(info.vjsout[0].value), FormatMoney(info.vjsout[1].value));
 
-    // Generate the proof, this can take over a minute.
+    // The proof, which can take over a minute, is left to the prover.
     boost::array<libzcash::JSInput, ZC_NUM_JS_INPUTS> inputs{info.vjsin[0], info.vjsin[1]};
     boost::array<libzcash::JSOutput, ZC_NUM_JS_OUTPUTS> outputs{info.vjsout[0], info.vjsout[1]};
     #ifdef __LP64__
@@ -763,7 +767,11 @@ UniValue AsyncRPCOperation_mergetoaddress::perform_joinsplit(
 
 
     uint256 esk; // payment disclosure - secret
+    ZCJSProofWitness proofWitness;
 
+    // Only the public fields are computed here. They are all a later
+    // JoinSplit needs to spend this one's change, so the proof itself is
+    // generated in the background while the rest of the chain is built.
     JSDescription jsdesc = JSDescription::Randomized(
         *pzcashParams,
         joinSplitPubKey_,
@@ -774,36 +782,31 @@ UniValue AsyncRPCOperation_mergetoaddress::perform_joinsplit(
         outputMap,
         info.vpub_old,
         info.vpub_new,
-        !this->testmode,
-        &esk); // parameter expects pointer to esk, so pass in address
-    {
+        false,
+        &esk, // parameter expects pointer to esk, so pass in address
+        GetRandInt,
+        &proofWitness);
+
+    if (this->testmode) {
+        // Without a proof this is expected to fail, as it always has in test mode
         auto verifier = libzcash::ProofVerifier::Strict();
         if (!(jsdesc.Verify(*pzcashParams, verifier, joinSplitPubKey_))) {
             throw std::runtime_error("error verifying joinsplit");
         }
+    } else {
+        std::shared_ptr<AsyncJoinSplitProver> prover;
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (!prover_) {
+                prover_ = std::make_shared<AsyncJoinSplitProver>(*pzcashParams, joinSplitPubKey_, AsyncJoinSplitProver::ConfiguredThreads());
+            }
+            prover = prover_;
+        }
+        prover->Submit(mtx.vjoinsplit.size(), jsdesc, proofWitness);
     }
 
     mtx.vjoinsplit.push_back(jsdesc);
 
-    // Empty output script.
-    CScript scriptCode;
-    CTransaction signTx(mtx);
-    uint256 dataToBeSigned = SignatureHash(scriptCode, signTx, NOT_AN_INPUT, SIGHASH_ALL, 0, consensusBranchId_);
-
-    // Add the signature
-    if (!(crypto_sign_detached(&mtx.joinSplitSig[0], NULL,
-                               dataToBeSigned.begin(), 32,
-                               joinSplitPrivKey_) == 0)) {
-        throw std::runtime_error("crypto_sign_detached failed");
-    }
-
-    // Sanity check
-    if (!(crypto_sign_verify_detached(&mtx.joinSplitSig[0],
-                                      dataToBeSigned.begin(), 32,
-                                      mtx.joinSplitPubKey.begin()) == 0)) {
-        throw std::runtime_error("crypto_sign_verify_detached failed");
-    }
-
     CTransaction rawTx(mtx);
     tx_ = rawTx;
 
@@ -871,6 +874,54 @@ UniValue AsyncRPCOperation_mergetoaddress::perform_joinsplit(
     return obj;
 }
 
+/**
+ * Wait for the proofs of all JoinSplits and sign the finished transaction.
+ * Returns an object with the raw transaction as hex string in field "rawtxn".
+ */
+UniValue AsyncRPCOperation_mergetoaddress::complete_joinsplits()
+{
+    CMutableTransaction mtx(tx_);
+
+    std::shared_ptr<AsyncJoinSplitProver> prover;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        prover = prover_;
+    }
+    if (prover) {
+        LogPrint("zrpcunsafe", "%s: waiting for %d joinsplit proofs\n", getId(), mtx.vjoinsplit.size());
+        prover->Complete(mtx);
+    }
+
+    // Empty output script.
+    CScript scriptCode;
+    CTransaction signTx(mtx);
+    uint256 dataToBeSigned = SignatureHash(scriptCode, signTx, NOT_AN_INPUT, SIGHASH_ALL, 0, consensusBranchId_);
+
+    // Add the signature
+    if (!(crypto_sign_detached(&mtx.joinSplitSig[0], NULL,
+                               dataToBeSigned.begin(), 32,
+                               joinSplitPrivKey_) == 0)) {
+        throw std::runtime_error("crypto_sign_detached failed");
+    }
+
+    // Sanity check
+    if (!(crypto_sign_verify_detached(&mtx.joinSplitSig[0],
+                                      dataToBeSigned.begin(), 32,
+                                      mtx.joinSplitPubKey.begin()) == 0)) {
+        throw std::runtime_error("crypto_sign_verify_detached failed");
+    }
+
+    CTransaction rawTx(mtx);
+    tx_ = rawTx;
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << rawTx;
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("rawtxn", HexStr(ss.begin(), ss.end())));
+    return obj;
+}
+
 boost::array<unsigned char, ZC_MEMO_SIZE> AsyncRPCOperation_mergetoaddress::get_memo_from_hex_string(std::string s)
 {
     boost::array<unsigned char, ZC_MEMO_SIZE> memo = {{0x00}};
@@ -908,6 +959,15 @@ UniValue AsyncRPCOperation_mergetoaddress::getStatus() const
     UniValue obj = v.get_obj();
     obj.push_back(Pair("method", "z_mergetoaddress"));
     obj.push_back(Pair("params", contextinfo_));
+
+    std::shared_ptr<AsyncJoinSplitProver> prover;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        prover = prover_;
+    }
+    if (prover) {
+        obj.push_back(Pair("joinsplits", prover->GetStatus()));
+    }
     return obj;
 }
 
@@ -14,11 +14,14 @@
 #include "zcash/Address.hpp"
 #include "zcash/JoinSplit.hpp"
 
+#include <memory>
 #include <tuple>
 #include <unordered_map>
 
 #include <univalue.h>
 
+class AsyncJoinSplitProver;
+
 // Default transaction fee if caller does not specify one.
 #define MERGE_TO_ADDRESS_OPERATION_DEFAULT_MINERS_FEE 10000
 
@@ -115,6 +118,12 @@ private:
         std::vector<boost::optional<ZCIncrementalWitness>> witnesses,
         uint256 anchor);
 
+    // Wait for the JoinSplit proofs and sign, returns the final "rawtxn"
+    UniValue complete_joinsplits();
+
+    // Proves JoinSplits added by perform_joinsplit() in the background
+    std::shared_ptr<AsyncJoinSplitProver> prover_;
+
     void sign_send_raw_transaction(UniValue obj); // throws exception if there was an error
 
     void lock_utxos();
@@ -178,6 +187,11 @@ public:
         return delegate->perform_joinsplit(info, witnesses, anchor);
     }
 
+    UniValue complete_joinsplits()
+    {
+        return delegate->complete_joinsplits();
+    }
+
     void sign_send_raw_transaction(UniValue obj)
     {
         delegate->sign_send_raw_transaction(obj);
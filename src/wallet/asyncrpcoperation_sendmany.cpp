@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "asyncrpcoperation_sendmany.h"
+#include "asyncjoinsplitprover.h"
 #include "asyncrpcqueue.h"
 #include "amount.h"
 #include "consensus/upgrades.h"
@@ -452,7 +453,6 @@ bool AsyncRPCOperation_sendmany::main_impl() {
         }
 
         // Create joinsplits, where each output represents a zaddr recipient.
-        UniValue obj(UniValue::VOBJ);
         while (zOutputsDeque.size() > 0) {
             AsyncJoinSplitInfo info;
             info.vpub_old = 0;
@@ -475,9 +475,9 @@ bool AsyncRPCOperation_sendmany::main_impl() {
                 // Funds are removed from the value pool and enter the private pool
                 info.vpub_old += value;
             }
-            obj = perform_joinsplit(info);
+            perform_joinsplit(info);
         }
-        sign_send_raw_transaction(obj);
+        sign_send_raw_transaction(complete_joinsplits());
         return true;
     }
     /**
@@ -495,6 +495,9 @@ bool AsyncRPCOperation_sendmany::main_impl() {
      * Send to zaddrs by chaining JoinSplits together and immediately consuming any change
      * Send to taddrs by creating dummy z outputs and accumulating value in a change note
      * which is used to set vpub_new in the last chained joinsplit.
+     *
+     * Building the chain only needs the public fields of each joinsplit, so the proofs
+     * are generated concurrently in the background and collected at the end.
      */
     UniValue obj(UniValue::VOBJ);
     CAmount jsChange = 0;   // this is updated after each joinsplit
@@ -754,7 +757,7 @@ bool AsyncRPCOperation_sendmany::main_impl() {
     assert(zOutputsDeque.size() == 0);
     assert(vpubNewProcessed);
 
-    sign_send_raw_transaction(obj);
+    sign_send_raw_transaction(complete_joinsplits());
     return true;
 }
 
@@ -970,7 +973,7 @@ UniValue AsyncRPCOperation_sendmany::perform_joinsplit(
             FormatMoney(info.vjsout[0].value), FormatMoney(info.vjsout[1].value)
             );
 
-    // Generate the proof, this can take over a minute.
+    // The proof, which can take over a minute, is left to the prover.
     boost::array<libzcash::JSInput, ZC_NUM_JS_INPUTS> inputs
             {info.vjsin[0], info.vjsin[1]};
     boost::array<libzcash::JSOutput, ZC_NUM_JS_OUTPUTS> outputs
@@ -983,7 +986,11 @@ UniValue AsyncRPCOperation_sendmany::perform_joinsplit(
     boost::array<size_t, ZC_NUM_JS_OUTPUTS> outputMap;
 #endif
     uint256 esk; // payment disclosure - secret
+    ZCJSProofWitness proofWitness;
 
+    // Only the public fields are computed here. They are all a later
+    // JoinSplit needs to spend this one's change, so the proof itself is
+    // generated in the background while the rest of the chain is built.
     JSDescription jsdesc = JSDescription::Randomized(
             *pzcashParams,
             joinSplitPubKey_,
@@ -994,40 +1001,31 @@ UniValue AsyncRPCOperation_sendmany::perform_joinsplit(
             outputMap,
             info.vpub_old,
             info.vpub_new,
-            !this->testmode,
-            &esk); // parameter expects pointer to esk, so pass in address
-    {
+            false,
+            &esk, // parameter expects pointer to esk, so pass in address
+            GetRandInt,
+            &proofWitness);
+
+    if (this->testmode) {
+        // Without a proof this is expected to fail, as it always has in test mode
         auto verifier = libzcash::ProofVerifier::Strict();
         if (!(jsdesc.Verify(*pzcashParams, verifier, joinSplitPubKey_))) {
             throw std::runtime_error("error verifying joinsplit");
         }
+    } else {
+        std::shared_ptr<AsyncJoinSplitProver> prover;
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (!prover_) {
+                prover_ = std::make_shared<AsyncJoinSplitProver>(*pzcashParams, joinSplitPubKey_, AsyncJoinSplitProver::ConfiguredThreads());
+            }
+            prover = prover_;
+        }
+        prover->Submit(mtx.vjoinsplit.size(), jsdesc, proofWitness);
     }
 
     mtx.vjoinsplit.push_back(jsdesc);
 
-    // Empty output script.
-    CScript scriptCode;
-    CTransaction signTx(mtx);
-    uint256 dataToBeSigned = SignatureHash(scriptCode, signTx, NOT_AN_INPUT, SIGHASH_ALL, 0, consensusBranchId_);
-
-    // Add the signature
-    if (!(crypto_sign_detached(&mtx.joinSplitSig[0], NULL,
-            dataToBeSigned.begin(), 32,
-            joinSplitPrivKey_
-            ) == 0))
-    {
-        throw std::runtime_error("crypto_sign_detached failed");
-    }
-
-    // Sanity check
-    if (!(crypto_sign_verify_detached(&mtx.joinSplitSig[0],
-            dataToBeSigned.begin(), 32,
-            mtx.joinSplitPubKey.begin()
-            ) == 0))
-    {
-        throw std::runtime_error("crypto_sign_verify_detached failed");
-    }
-
     CTransaction rawTx(mtx);
     tx_ = rawTx;
 
@@ -1095,6 +1093,58 @@ UniValue AsyncRPCOperation_sendmany::perform_joinsplit(
     return obj;
 }
 
+/**
+ * Wait for the proofs of all JoinSplits and sign the finished transaction.
+ * Returns an object with the raw transaction as hex string in field "rawtxn".
+ */
+UniValue AsyncRPCOperation_sendmany::complete_joinsplits()
+{
+    CMutableTransaction mtx(tx_);
+
+    std::shared_ptr<AsyncJoinSplitProver> prover;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        prover = prover_;
+    }
+    if (prover) {
+        LogPrint("zrpcunsafe", "%s: waiting for %d joinsplit proofs\n", getId(), mtx.vjoinsplit.size());
+        prover->Complete(mtx);
+    }
+
+    // Empty output script.
+    CScript scriptCode;
+    CTransaction signTx(mtx);
+    uint256 dataToBeSigned = SignatureHash(scriptCode, signTx, NOT_AN_INPUT, SIGHASH_ALL, 0, consensusBranchId_);
+
+    // Add the signature
+    if (!(crypto_sign_detached(&mtx.joinSplitSig[0], NULL,
+            dataToBeSigned.begin(), 32,
+            joinSplitPrivKey_
+            ) == 0))
+    {
+        throw std::runtime_error("crypto_sign_detached failed");
+    }
+
+    // Sanity check
+    if (!(crypto_sign_verify_detached(&mtx.joinSplitSig[0],
+            dataToBeSigned.begin(), 32,
+            mtx.joinSplitPubKey.begin()
+            ) == 0))
+    {
+        throw std::runtime_error("crypto_sign_verify_detached failed");
+    }
+
+    CTransaction rawTx(mtx);
+    tx_ = rawTx;
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << rawTx;
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("rawtxn", HexStr(ss.begin(), ss.end())));
+    return obj;
+}
+
 void AsyncRPCOperation_sendmany::add_taddr_outputs_to_tx() {
 
     CMutableTransaction rawTx(tx_);
@@ -1178,5 +1228,14 @@ UniValue AsyncRPCOperation_sendmany::getStatus() const {
     UniValue obj = v.get_obj();
     obj.push_back(Pair("method", "z_sendmany"));
     obj.push_back(Pair("params", contextinfo_ ));
+
+    std::shared_ptr<AsyncJoinSplitProver> prover;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        prover = prover_;
+    }
+    if (prover) {
+        obj.push_back(Pair("joinsplits", prover->GetStatus()));
+    }
     return obj;
 }
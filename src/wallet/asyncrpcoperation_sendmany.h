@@ -14,11 +14,14 @@
 #include "wallet.h"
 #include "paymentdisclosure.h"
 
+#include <memory>
 #include <unordered_map>
 #include <tuple>
 
 #include <univalue.h>
 
+class AsyncJoinSplitProver;
+
 // Default transaction fee if caller does not specify one.
 #define ASYNC_RPC_OPERATION_DEFAULT_MINERS_FEE   10000
 
@@ -115,6 +118,12 @@ private:
         std::vector<boost::optional < ZCIncrementalWitness>> witnesses,
         uint256 anchor);
 
+    // Wait for the JoinSplit proofs and sign, returns the final "rawtxn"
+    UniValue complete_joinsplits();
+
+    // Proves JoinSplits added by perform_joinsplit() in the background
+    std::shared_ptr<AsyncJoinSplitProver> prover_;
+
     void sign_send_raw_transaction(UniValue obj);     // throws exception if there was an error
 
     // payment disclosure!
@@ -179,6 +188,10 @@ public:
         return delegate->perform_joinsplit(info, witnesses, anchor);
     }
 
+    UniValue complete_joinsplits() {
+        return delegate->complete_joinsplits();
+    }
+
     void sign_send_raw_transaction(UniValue obj) {
         delegate->sign_send_raw_transaction(obj);
     }
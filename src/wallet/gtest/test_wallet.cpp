@@ -409,6 +409,36 @@ TEST(wallet_tests, FindMyNotesInEncryptedWallet) {
     EXPECT_EQ(nd, noteMap[jsoutpt]);
 }
 
+TEST(wallet_tests, FindMyNotesCachesPlaintext) {
+    CWallet wallet;
+
+    auto sk = libzcash::SpendingKey::random();
+    wallet.AddSpendingKey(sk);
+
+    auto wtx = GetValidReceive(sk, 10, true);
+    auto note = GetNote(sk, wtx, 0, 1);
+
+    auto noteMap = wallet.FindMyNotes(wtx);
+    JSOutPoint jsoutpt {wtx.GetHash(), 0, 1};
+    ASSERT_EQ(1, noteMap.count(jsoutpt));
+    ASSERT_TRUE(static_cast<bool>(noteMap[jsoutpt].plaintext));
+    EXPECT_EQ(note.value, noteMap[jsoutpt].plaintext->value);
+
+    // The cached plaintexts are written with the transaction
+    CWalletTx wtx2 {wtx};
+    wtx2.SetNoteData(noteMap);
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << wtx2;
+
+    CWalletTx wtx3;
+    ss >> wtx3;
+    EXPECT_EQ(0, wtx3.mapValue.count("noteplaintexts"));
+    ASSERT_EQ(1, wtx3.mapNoteData.count(jsoutpt));
+    ASSERT_TRUE(static_cast<bool>(wtx3.mapNoteData[jsoutpt].plaintext));
+    EXPECT_EQ(note.value, wtx3.mapNoteData[jsoutpt].plaintext->value);
+    EXPECT_EQ(noteMap[jsoutpt].plaintext->memo, wtx3.mapNoteData[jsoutpt].plaintext->memo);
+}
+
 TEST(wallet_tests, get_conflicted_notes) {
     CWallet wallet;
 
@@ -1079,3 +1109,76 @@ TEST(wallet_tests, NoteLocking) {
     EXPECT_FALSE(wallet.IsLockedNote(jsoutpt.hash, jsoutpt.js, jsoutpt.n));
     EXPECT_FALSE(wallet.IsLockedNote(jsoutpt2.hash, jsoutpt2.js, jsoutpt2.n));
 }
+
+uint64_t komodo_interest(int32_t txheight,uint64_t nValue,uint32_t nLockTime,uint32_t tiptime);
+
+TEST(wallet_tests, InterestSumFollowsLedger) {
+    CWallet wallet;
+    LOCK2(cs_main, wallet.cs_wallet);
+
+    // Only the key id matters for IsMine
+    CPubKey pubkey(ParseHex("03a34b99f22c790c4e36b2b3c2c35a36db06226e41c692fc82b8b56ac1c540c5bd"));
+    wallet.AddKeyPubKey(CKey(), pubkey);
+    CScript scriptPubKey = GetScriptForDestination(pubkey.GetID());
+
+    CBlock block;
+    block.nTime = 1500000000;
+    auto blockHash = block.GetHash();
+    CBlockIndex fakeIndex {block};
+    fakeIndex.phashBlock = &blockHash;
+    mapBlockIndex.insert(std::make_pair(blockHash, &fakeIndex));
+    chainActive.SetTip(&fakeIndex);
+    EXPECT_EQ(0, wallet.GetInterestSum());
+
+    // Two outputs earning a day of interest at the tip
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vin[0].prevout = COutPoint(GetRandHash(), 0);
+    mtx.vout.push_back(CTxOut(100 * COIN, scriptPubKey));
+    mtx.vout.push_back(CTxOut(100 * COIN, scriptPubKey));
+    mtx.nLockTime = block.nTime - 24 * 60 * 60;
+    CWalletTx wtx(&wallet, mtx);
+    wallet.AddToWallet(wtx, true, NULL);
+    CAmount nInterest = komodo_interest(0, 100 * COIN, mtx.nLockTime, block.nTime);
+    ASSERT_GT(nInterest, 0);
+    EXPECT_EQ(2 * nInterest, wallet.GetInterestSum());
+
+    // Locked coins don't count
+    COutPoint outpoint(wtx.GetHash(), 0);
+    wallet.LockCoin(outpoint);
+    EXPECT_EQ(nInterest, wallet.GetInterestSum());
+    wallet.UnlockCoin(outpoint);
+    EXPECT_EQ(2 * nInterest, wallet.GetInterestSum());
+    wallet.LockCoin(outpoint);
+    EXPECT_EQ(nInterest, wallet.GetInterestSum());
+    wallet.UnlockAllCoins();
+    EXPECT_EQ(2 * nInterest, wallet.GetInterestSum());
+
+    // Neither do spent ones
+    CMutableTransaction mtxSpend;
+    mtxSpend.vin.push_back(CTxIn(COutPoint(wtx.GetHash(), 1)));
+    mtxSpend.vout.push_back(CTxOut(100 * COIN, CScript() << OP_TRUE));
+    CWalletTx wtxSpend(&wallet, mtxSpend);
+    wallet.AddToWallet(wtxSpend, true, NULL);
+    EXPECT_EQ(nInterest, wallet.GetInterestSum());
+
+    // A new tip moves the interest along
+    CBlock block2;
+    block2.nTime = block.nTime + 30 * 24 * 60 * 60;
+    block2.hashPrevBlock = blockHash;
+    auto blockHash2 = block2.GetHash();
+    CBlockIndex fakeIndex2 {block2};
+    fakeIndex2.phashBlock = &blockHash2;
+    fakeIndex2.pprev = &fakeIndex;
+    fakeIndex2.nHeight = 1;
+    mapBlockIndex.insert(std::make_pair(blockHash2, &fakeIndex2));
+    chainActive.SetTip(&fakeIndex2);
+    CAmount nInterest2 = komodo_interest(1, 100 * COIN, mtx.nLockTime, block2.nTime);
+    ASSERT_GT(nInterest2, nInterest);
+    EXPECT_EQ(nInterest2, wallet.GetInterestSum());
+
+    // Tear down
+    chainActive.SetTip(NULL);
+    mapBlockIndex.erase(blockHash);
+    mapBlockIndex.erase(blockHash2);
+}
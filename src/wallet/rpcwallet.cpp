@@ -2705,25 +2705,9 @@ UniValue listunspent(const UniValue& params, bool fHelp)
 
 uint64_t komodo_interestsum()
 {
-    uint64_t interest,sum = 0;
-    vector<COutput> vecOutputs;
+    uint64_t sum;
     assert(pwalletMain != NULL);
-    LOCK2(cs_main, pwalletMain->cs_wallet);
-    pwalletMain->AvailableCoins(vecOutputs, false, NULL, true);
-    BOOST_FOREACH(const COutput& out,vecOutputs)
-    {
-        CAmount nValue = out.tx->vout[out.i].nValue;
-        if ( out.tx->nLockTime != 0 && out.fSpendable != 0 )
-        {
-            BlockMap::iterator it = mapBlockIndex.find(pcoinsTip->GetBestBlock());
-            CBlockIndex *tipindex,*pindex = it->second;
-            if ( pindex != 0 && (tipindex= chainActive.Tip()) != 0 )
-            {
-                interest = komodo_interest(pindex->nHeight,nValue,out.tx->nLockTime,tipindex->nTime);
-                sum += interest;
-            }
-        }
-    }
+    sum = pwalletMain->GetInterestSum();
     KOMODO_INTERESTSUM = sum;
     KOMODO_WALLETBALANCE = pwalletMain->GetBalance();
     return(sum);
@@ -2883,6 +2867,20 @@ UniValue zc_benchmark(const UniValue& params, bool fHelp)
 #endif
         } else if (benchmarktype == "verifyequihash") {
             sample_times.push_back(benchmark_verify_equihash());
+        } else if (benchmarktype == "verifyequihashbatch") {
+            // Number of headers in the batch, and threads to check them on
+            int nHeaders = MAX_HEADERS_RESULTS;
+            int nThreads = GetNumCores();
+            if (params.size() >= 3) {
+                nHeaders = params[2].get_int();
+            }
+            if (params.size() >= 4) {
+                nThreads = params[3].get_int();
+            }
+            if (nHeaders < 1 || nThreads < 1) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid number of headers or threads");
+            }
+            sample_times.push_back(benchmark_verify_equihash_batch(nHeaders, nThreads));
         } else if (benchmarktype == "validatelargetx") {
             // Number of inputs in the spending transaction that we will simulate
             int nInputs = 555;
@@ -2914,6 +2912,46 @@ UniValue zc_benchmark(const UniValue& params, bool fHelp)
             sample_times.push_back(benchmark_loadwallet());
         } else if (benchmarktype == "listunspent") {
             sample_times.push_back(benchmark_listunspent());
+        } else if (benchmarktype == "blocktojson" || benchmarktype == "blocktojsonstream") {
+            // Height of the block to render; defaults to the current tip
+            int nHeight = chainActive.Height();
+            if (params.size() >= 3) {
+                nHeight = params[2].get_int();
+            }
+            if (nHeight < 0 || nHeight > chainActive.Height()) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
+            }
+            sample_times.push_back(benchmark_blocktojson(nHeight, benchmarktype == "blocktojsonstream"));
+        } else if (benchmarktype == "sha256") {
+            // Number of bytes to hash
+            int nBytes = 1000000;
+            if (params.size() >= 3) {
+                nBytes = params[2].get_int();
+            }
+            if (nBytes < 0) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid number of bytes");
+            }
+            sample_times.push_back(benchmark_sha256(nBytes));
+        } else if (benchmarktype == "merkleroot") {
+            // Number of transactions in the block
+            int nTxs = 2000;
+            if (params.size() >= 3) {
+                nTxs = params[2].get_int();
+            }
+            if (nTxs < 1) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid number of transactions");
+            }
+            sample_times.push_back(benchmark_merkleroot(nTxs));
+        } else if (benchmarktype == "deserializeblock") {
+            // Number of transactions in the block
+            int nTxs = 2000;
+            if (params.size() >= 3) {
+                nTxs = params[2].get_int();
+            }
+            if (nTxs < 1) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid number of transactions");
+            }
+            sample_times.push_back(benchmark_deserializeblock(nTxs));
         } else {
             throw JSONRPCError(RPC_TYPE_ERROR, "Invalid benchmarktype");
         }
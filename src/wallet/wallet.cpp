@@ -413,10 +413,11 @@ bool CWallet::ChangeWalletPassphrase(const SecureString& strOldWalletPassphrase,
 }
 
 void CWallet::ChainTip(const CBlockIndex *pindex, const CBlock *pblock,
-                       ZCIncrementalMerkleTree tree, bool added)
+                       const ZCIncrementalMerkleTree &tree, bool added)
 {
     if (added) {
-        IncrementNoteWitnesses(pindex, pblock, tree);
+        ZCIncrementalMerkleTree newTree = tree;
+        IncrementNoteWitnesses(pindex, pblock, newTree);
     } else if ( nWitnessCacheSize > 1 ){ //ASSETCHAINS_SYMBOL[0] == 0 ||
         DecrementNoteWitnesses(pindex);
     } else fprintf(stderr,"would have decremented %s nWitnessCacheSize.%d\n",ASSETCHAINS_SYMBOL,(int32_t)nWitnessCacheSize);
@@ -652,6 +653,36 @@ void CWallet::AddToSpends(const uint256& nullifier, const uint256& wtxid)
     SyncMetaData<uint256>(range);
 }
 
+void CWallet::UpdateInterestLedger(const CWalletTx& wtx)
+{
+    bool fChanged = false;
+
+    // komodo_interest pays nothing without a locktime or below 10 coins
+    if (wtx.nLockTime >= LOCKTIME_THRESHOLD) {
+        uint256 hash = wtx.GetHash();
+        for (unsigned int i = 0; i < wtx.vout.size(); i++) {
+            if (wtx.vout[i].nValue < 10 * COIN || !(IsMine(wtx.vout[i]) & ISMINE_SPENDABLE))
+                continue;
+            CInterestAccrual& accrual = mapInterestLedger[COutPoint(hash, i)];
+            accrual.nValue = wtx.vout[i].nValue;
+            accrual.nLockTime = wtx.nLockTime;
+            fChanged = true;
+        }
+    }
+
+    if (!wtx.IsCoinBase()) {
+        for (const CTxIn& txin : wtx.vin) {
+            if (mapInterestLedger.count(txin.prevout)) {
+                fChanged = true;
+                break;
+            }
+        }
+    }
+
+    if (fChanged)
+        nInterestLedgerVersion++;
+}
+
 void CWallet::AddToSpends(const uint256& wtxid)
 {
     assert(mapWallet.count(wtxid));
@@ -1132,7 +1163,8 @@ bool CWallet::UpdateNullifierNoteMap()
                             item.second.address,
                             dec,
                             hSig,
-                            item.first.n);
+                            item.first.n,
+                            item.second.plaintext ? NULL : &item.second.plaintext);
                     }
                 }
             }
@@ -1167,6 +1199,7 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFromLoadWallet, CWalletD
         mapWallet[hash].BindWallet(this);
         UpdateNullifierNoteMapWithTx(mapWallet[hash]);
         AddToSpends(hash);
+        UpdateInterestLedger(mapWallet[hash]);
     }
     else
     {
@@ -1266,6 +1299,9 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFromLoadWallet, CWalletD
         // Break debit/credit balance caches:
         wtx.MarkDirty();
 
+        // Keys may have been added since the transaction was first seen
+        UpdateInterestLedger(wtx);
+
         // Notify UI of new or updated transaction
         NotifyTransactionChanged(this, hash, fInsertedNew ? CT_NEW : CT_UPDATED);
 
@@ -1295,6 +1331,9 @@ bool CWallet::UpdatedNoteData(const CWalletTx& wtxIn, CWalletTx& wtx)
                 nd.second.witnesses.cbegin(), nd.second.witnesses.cend());
         }
         tmp.at(nd.first).witnessHeight = nd.second.witnessHeight;
+        if (!tmp.at(nd.first).plaintext) {
+            tmp.at(nd.first).plaintext = nd.second.plaintext;
+        }
     }
     // Now copy over the updated note data
     wtx.mapNoteData = tmp;
@@ -1372,6 +1411,13 @@ void CWallet::EraseFromWallet(const uint256 &hash)
         LOCK(cs_wallet);
         if (mapWallet.erase(hash))
             CWalletDB(strWalletFile).EraseTx(hash);
+
+        std::map<COutPoint, CInterestAccrual>::iterator it = mapInterestLedger.lower_bound(COutPoint(hash, 0));
+        if (it != mapInterestLedger.end() && it->first.hash == hash) {
+            while (it != mapInterestLedger.end() && it->first.hash == hash)
+                mapInterestLedger.erase(it++);
+            nInterestLedgerVersion++;
+        }
     }
     return;
 }
@@ -1385,7 +1431,8 @@ boost::optional<uint256> CWallet::GetNoteNullifier(const JSDescription& jsdesc,
                                                    const libzcash::PaymentAddress& address,
                                                    const ZCNoteDecryption& dec,
                                                    const uint256& hSig,
-                                                   uint8_t n) const
+                                                   uint8_t n,
+                                                   boost::optional<libzcash::NotePlaintext>* plaintext) const
 {
     boost::optional<uint256> ret;
     auto note_pt = libzcash::NotePlaintext::decrypt(
@@ -1394,6 +1441,9 @@ boost::optional<uint256> CWallet::GetNoteNullifier(const JSDescription& jsdesc,
         jsdesc.ephemeralKey,
         hSig,
         (unsigned char) n);
+    if (plaintext) {
+        *plaintext = note_pt;
+    }
     auto note = note_pt.note(address);
     // SpendingKeys are only available if:
     // - We have them (this isn't a viewing key)
@@ -1426,18 +1476,19 @@ mapNoteData_t CWallet::FindMyNotes(const CTransaction& tx) const
                 try {
                     auto address = item.first;
                     JSOutPoint jsoutpt {hash, i, j};
+                    // Keep the decrypted note, so balance queries don't decrypt it again
+                    boost::optional<libzcash::NotePlaintext> plaintext;
                     auto nullifier = GetNoteNullifier(
                         tx.vjoinsplit[i],
                         address,
                         item.second,
-                        hSig, j);
+                        hSig, j, &plaintext);
+                    CNoteData nd {address};
                     if (nullifier) {
-                        CNoteData nd {address, *nullifier};
-                        noteData.insert(std::make_pair(jsoutpt, nd));
-                    } else {
-                        CNoteData nd {address};
-                        noteData.insert(std::make_pair(jsoutpt, nd));
+                        nd.nullifier = *nullifier;
                     }
+                    nd.plaintext = plaintext;
+                    noteData.insert(std::make_pair(jsoutpt, nd));
                     break;
                 } catch (const note_decryption_failed &err) {
                     // Couldn't decrypt with this decryptor
@@ -2464,6 +2515,7 @@ CAmount CWallet::GetImmatureWatchOnlyBalance() const
 /**
  * populate vCoins with vector of available COutputs.
  */
+uint64_t komodo_interest(int32_t txheight,uint64_t nValue,uint32_t nLockTime,uint32_t tiptime);
 uint64_t komodo_interestnew(int32_t txheight,uint64_t nValue,uint32_t nLockTime,uint32_t tiptime);
 uint64_t komodo_accrued_interest(int32_t *txheightp,uint32_t *locktimep,uint256 hash,int32_t n,int32_t checkheight,uint64_t checkvalue,int32_t tipheight);
 
@@ -2550,6 +2602,41 @@ void CWallet::AvailableCoins(vector<COutput>& vCoins, bool fOnlyConfirmed, const
     }
 }
 
+CAmount CWallet::GetInterestSum()
+{
+    LOCK2(cs_main, cs_wallet);
+    CBlockIndex *tipindex = chainActive.Tip();
+    if (tipindex == NULL)
+        return 0;
+
+    // Interest only moves with the tip, so evaluate the ledger once per block
+    if (tipindex->GetBlockHash() == hashInterestTip && nInterestSumVersion == nInterestLedgerVersion)
+        return nInterestSum;
+
+    CAmount nTotal = 0;
+    for (const auto& entry : mapInterestLedger)
+    {
+        const COutPoint& outpoint = entry.first;
+        if (IsSpent(outpoint.hash, outpoint.n) || IsLockedCoin(outpoint.hash, outpoint.n))
+            continue;
+
+        // The same checks AvailableCoins makes for the transaction
+        map<uint256, CWalletTx>::const_iterator mi = mapWallet.find(outpoint.hash);
+        if (mi == mapWallet.end())
+            continue;
+        const CWalletTx& wtx = mi->second;
+        if (!CheckFinalTx(wtx) || (wtx.IsCoinBase() && wtx.GetBlocksToMaturity() > 0) || wtx.GetDepthInMainChain() < 0)
+            continue;
+
+        nTotal += komodo_interest(tipindex->nHeight, entry.second.nValue, entry.second.nLockTime, tipindex->nTime);
+    }
+
+    hashInterestTip = tipindex->GetBlockHash();
+    nInterestSumVersion = nInterestLedgerVersion;
+    nInterestSum = nTotal;
+    return nTotal;
+}
+
 static void ApproximateBestSubset(vector<pair<CAmount, pair<const CWalletTx*,unsigned int> > >vValue, const CAmount& nTotalLower, const CAmount& nTargetValue,vector<char>& vfBest, CAmount& nBest, int iterations = 1000)
 {
     vector<char> vfIncluded;
@@ -3732,12 +3819,16 @@ void CWallet::UpdatedTransaction(const uint256 &hashTx)
 void CWallet::LockCoin(COutPoint& output)
 {
     AssertLockHeld(cs_wallet); // setLockedCoins
+    if (mapInterestLedger.count(output))
+        nInterestLedgerVersion++;
     setLockedCoins.insert(output);
 }
 
 void CWallet::UnlockCoin(COutPoint& output)
 {
     AssertLockHeld(cs_wallet); // setLockedCoins
+    if (mapInterestLedger.count(output))
+        nInterestLedgerVersion++;
     setLockedCoins.erase(output);
 }
 
@@ -3745,6 +3836,7 @@ void CWallet::UnlockAllCoins()
 {
     AssertLockHeld(cs_wallet); // setLockedCoins
     setLockedCoins.clear();
+    nInterestLedgerVersion++;
 }
 
 bool CWallet::IsLockedCoin(uint256 hash, unsigned int n) const
@@ -4064,8 +4156,11 @@ void CWallet::GetFilteredNotes(
 {
     LOCK2(cs_main, cs_wallet);
 
+    // Transactions whose notes had to be decrypted, to write their new cache entries
+    std::vector<uint256> vDecrypted;
+
     for (auto & p : mapWallet) {
-        CWalletTx wtx = p.second;
+        CWalletTx& wtx = p.second;
 
         // Filter the transactions before checking for notes
         if (!CheckFinalTx(wtx) || wtx.GetBlocksToMaturity() > 0 || wtx.GetDepthInMainChain() < minDepth) {
@@ -4076,10 +4171,11 @@ void CWallet::GetFilteredNotes(
             continue;
         }
 
+        bool fDecrypted = false;
         for (auto & pair : wtx.mapNoteData) {
-            JSOutPoint jsop = pair.first;
-            CNoteData nd = pair.second;
-            PaymentAddress pa = nd.address;
+            const JSOutPoint& jsop = pair.first;
+            CNoteData& nd = pair.second;
+            const PaymentAddress& pa = nd.address;
 
             // skip notes which belong to a different payment address in the wallet
             if (!(filterAddresses.empty() || filterAddresses.count(pa))) {
@@ -4101,6 +4197,12 @@ void CWallet::GetFilteredNotes(
                 continue;
             }
 
+            if (nd.plaintext) {
+                outEntries.push_back(CNotePlaintextEntry{jsop, pa, *nd.plaintext});
+                continue;
+            }
+
+            // Notes found before the plaintext cache existed are decrypted once here
             int i = jsop.js; // Index into CTransaction.vjoinsplit
             int j = jsop.n; // Index into JSDescription.ciphertexts
 
@@ -4121,6 +4223,8 @@ void CWallet::GetFilteredNotes(
                         hSig,
                         (unsigned char) j);
 
+                nd.plaintext = plaintext;
+                fDecrypted = true;
                 outEntries.push_back(CNotePlaintextEntry{jsop, pa, plaintext});
 
             } catch (const note_decryption_failed &err) {
@@ -4131,5 +4235,15 @@ void CWallet::GetFilteredNotes(
                 throw std::runtime_error(strprintf("Error while decrypting note for payment address %s: %s", CZCPaymentAddress(pa).ToString(), exc.what()));
             }
         }
+        if (fDecrypted) {
+            vDecrypted.push_back(p.first);
+        }
+    }
+
+    if (fFileBacked && !vDecrypted.empty()) {
+        CWalletDB walletdb(strWalletFile);
+        for (const uint256& hash : vDecrypted) {
+            mapWallet[hash].WriteToDisk(&walletdb);
+        }
     }
 }
@@ -236,6 +236,15 @@ public:
      */
     int witnessHeight;
 
+    /**
+     * Cached decryption of the note. A note's plaintext never changes, so it
+     * is decrypted once, when the note is found or first queried, rather
+     * than on every balance query. This is not part of the CNoteData
+     * serialization; CWalletTx persists it separately in mapValue, so that
+     * wallets remain readable by older versions.
+     */
+    boost::optional<libzcash::NotePlaintext> plaintext;
+
     CNoteData() : address(), nullifier(), witnessHeight {-1} { }
     CNoteData(libzcash::PaymentAddress a) :
             address {a}, nullifier(), witnessHeight {-1} { }
@@ -268,6 +277,40 @@ public:
 
 typedef std::map<JSOutPoint, CNoteData> mapNoteData_t;
 
+static void ReadNotePlaintexts(mapNoteData_t& mapNoteData, mapValue_t& mapValue)
+{
+    if (!mapValue.count("noteplaintexts"))
+        return;
+    const std::string& str = mapValue["noteplaintexts"];
+    std::map<JSOutPoint, libzcash::NotePlaintext> plaintexts;
+    try {
+        CDataStream ss(str.data(), str.data() + str.size(), SER_DISK, CLIENT_VERSION);
+        ss >> plaintexts;
+    } catch (const std::exception&) {
+        // Only a cache, the notes are decrypted again when needed
+        return;
+    }
+    for (const auto& item : plaintexts) {
+        mapNoteData_t::iterator it = mapNoteData.find(item.first);
+        if (it != mapNoteData.end())
+            it->second.plaintext = item.second;
+    }
+}
+
+static void WriteNotePlaintexts(const mapNoteData_t& mapNoteData, mapValue_t& mapValue)
+{
+    std::map<JSOutPoint, libzcash::NotePlaintext> plaintexts;
+    for (const auto& item : mapNoteData) {
+        if (item.second.plaintext)
+            plaintexts.insert(std::make_pair(item.first, *item.second.plaintext));
+    }
+    if (plaintexts.empty())
+        return;
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << plaintexts;
+    mapValue["noteplaintexts"] = std::string(ss.begin(), ss.end());
+}
+
 /** Decrypted note and its location in a transaction. */
 struct CNotePlaintextEntry
 {
@@ -444,6 +487,8 @@ public:
 
             if (nTimeSmart)
                 mapValue["timesmart"] = strprintf("%u", nTimeSmart);
+
+            WriteNotePlaintexts(mapNoteData, mapValue);
         }
 
         READWRITE(*(CMerkleTx*)this);
@@ -464,6 +509,8 @@ public:
             ReadOrderPos(nOrderPos, mapValue);
 
             nTimeSmart = mapValue.count("timesmart") ? (unsigned int)atoi64(mapValue["timesmart"]) : 0;
+
+            ReadNotePlaintexts(mapNoteData, mapValue);
         }
 
         mapValue.erase("fromaccount");
@@ -471,6 +518,7 @@ public:
         mapValue.erase("spent");
         mapValue.erase("n");
         mapValue.erase("timesmart");
+        mapValue.erase("noteplaintexts");
     }
 
     //! make sure balances are recalculated
@@ -697,6 +745,28 @@ private:
     void AddToSpends(const uint256& nullifier, const uint256& wtxid);
     void AddToSpends(const uint256& wtxid);
 
+    /** What komodo_interest needs to value an output */
+    struct CInterestAccrual
+    {
+        CAmount nValue;
+        uint32_t nLockTime;
+    };
+    /**
+     * Our spendable outputs that can earn interest (a locktime and at least
+     * 10 coins), so the interest of the wallet is found without walking every
+     * coin in it. Spent outputs stay in the ledger and are skipped when it is
+     * evaluated, as a spend can still be conflicted out.
+     */
+    std::map<COutPoint, CInterestAccrual> mapInterestLedger;
+    //! Bumped whenever the ledger or the spent or locked state of its outputs changes
+    uint64_t nInterestLedgerVersion;
+    //! The last evaluation, valid as long as neither the tip nor the ledger changed
+    uint256 hashInterestTip;
+    uint64_t nInterestSumVersion;
+    CAmount nInterestSum;
+
+    void UpdateInterestLedger(const CWalletTx& wtx);
+
 public:
     /*
      * Size of the incremental witness cache for the notes in our wallet.
@@ -819,6 +889,9 @@ public:
         nTimeFirstKey = 0;
         fBroadcastTransactions = false;
         nWitnessCacheSize = 0;
+        nInterestLedgerVersion = 1;
+        nInterestSumVersion = 0;
+        nInterestSum = 0;
     }
 
     /**
@@ -1009,6 +1082,8 @@ public:
     CAmount GetWatchOnlyBalance() const;
     CAmount GetUnconfirmedWatchOnlyBalance() const;
     CAmount GetImmatureWatchOnlyBalance() const;
+    /** Interest accrued by the spendable coins of the wallet at the current tip */
+    CAmount GetInterestSum();
     bool FundTransaction(CMutableTransaction& tx, CAmount& nFeeRet, int& nChangePosRet, std::string& strFailReason);
     bool CreateTransaction(const std::vector<CRecipient>& vecSend, CWalletTx& wtxNew, CReserveKey& reservekey, CAmount& nFeeRet, int& nChangePosRet,
                            std::string& strFailReason, const CCoinControl *coinControl = NULL, bool sign = true);
@@ -1031,12 +1106,17 @@ public:
 
     std::set<CTxDestination> GetAccountAddresses(const std::string& strAccount) const;
 
+    /**
+     * Decrypt a note, and derive its nullifier if the spending key is
+     * available. If plaintext is not NULL, the decrypted note is stored there.
+     */
     boost::optional<uint256> GetNoteNullifier(
         const JSDescription& jsdesc,
         const libzcash::PaymentAddress& address,
         const ZCNoteDecryption& dec,
         const uint256& hSig,
-        uint8_t n) const;
+        uint8_t n,
+        boost::optional<libzcash::NotePlaintext>* plaintext = NULL) const;
     mapNoteData_t FindMyNotes(const CTransaction& tx) const;
     bool IsFromMe(const uint256& nullifier) const;
     void GetNoteWitnesses(
@@ -1058,7 +1138,7 @@ public:
     CAmount GetCredit(const CTransaction& tx, int32_t voutNum, const isminefilter& filter) const;
     CAmount GetCredit(const CTransaction& tx, const isminefilter& filter) const;
     CAmount GetChange(const CTransaction& tx) const;
-    void ChainTip(const CBlockIndex *pindex, const CBlock *pblock, ZCIncrementalMerkleTree tree, bool added);
+    void ChainTip(const CBlockIndex *pindex, const CBlock *pblock, const ZCIncrementalMerkleTree &tree, bool added);
     /** Saves witness caches and best block locator to disk. */
     void SetBestChain(const CBlockLocator& loc);
 
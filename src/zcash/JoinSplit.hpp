@@ -43,6 +43,23 @@ public:
     Note note(const uint252& phi, const uint256& r, size_t i, const uint256& h_sig) const;
 };
 
+// Private inputs to the JoinSplit circuit. prove() can hand these back
+// instead of running the prover, so that the zk-SNARK proof can be computed
+// later (e.g. on another thread) once every public field is already fixed.
+template<size_t NumInputs, size_t NumOutputs>
+class JSProofWitness {
+public:
+    uint252 phi;
+    uint256 rt;
+    uint256 h_sig;
+    boost::array<JSInput, NumInputs> inputs;
+    boost::array<Note, NumOutputs> notes;
+    uint64_t vpub_old;
+    uint64_t vpub_new;
+
+    JSProofWitness() : vpub_old(0), vpub_new(0) {}
+};
+
 template<size_t NumInputs, size_t NumOutputs>
 class JoinSplit {
 public:
@@ -77,9 +94,16 @@ public:
         // For paymentdisclosure, we need to retrieve the esk.
         // Reference as non-const parameter with default value leads to compile error.
         // So use pointer for simplicity.
-        uint256 *out_esk = nullptr
+        uint256 *out_esk = nullptr,
+        // If set, receives the circuit inputs so the proof can be
+        // generated separately with prove(witness).
+        JSProofWitness<NumInputs, NumOutputs> *out_witness = nullptr
     ) = 0;
 
+    // Generate the proof for a JoinSplit whose public fields were computed
+    // by an earlier call to prove() with computeProof = false.
+    virtual ZCProof prove(const JSProofWitness<NumInputs, NumOutputs>& witness) = 0;
+
     virtual bool verify(
         const ZCProof& proof,
         ProofVerifier& verifier,
@@ -101,5 +125,7 @@ protected:
 
 typedef libzcash::JoinSplit<ZC_NUM_JS_INPUTS,
                             ZC_NUM_JS_OUTPUTS> ZCJoinSplit;
+typedef libzcash::JSProofWitness<ZC_NUM_JS_INPUTS,
+                                 ZC_NUM_JS_OUTPUTS> ZCJSProofWitness;
 
 #endif // ZC_JOINSPLIT_H_
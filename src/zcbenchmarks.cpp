@@ -6,11 +6,14 @@
 #include <boost/filesystem.hpp>
 
 #include "coins.h"
+#include "core_memusage.h"
 #include "util.h"
 #include "init.h"
+#include "jsonwriter.h"
 #include "primitives/transaction.h"
 #include "base58.h"
 #include "crypto/equihash.h"
+#include "crypto/sha256.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "consensus/upgrades.h"
@@ -222,6 +225,20 @@ double benchmark_verify_equihash()
     return timer_stop(tv_start);
 }
 
+double benchmark_verify_equihash_batch(size_t nHeaders, int nThreads)
+{
+    CChainParams params = Params(CBaseChainParams::MAIN);
+    CBlock genesis = Params(CBaseChainParams::MAIN).GenesisBlock();
+    std::vector<CBlockHeader> headers(nHeaders, genesis.GetBlockHeader());
+    struct timeval tv_start;
+    timer_start(tv_start);
+    CheckEquihashSolutions(headers, params, nThreads);
+    double duration = timer_stop(tv_start);
+    // Later single checks of the genesis header would find it remembered
+    ForgetVerifiedEquihashSolutions();
+    return duration;
+}
+
 double benchmark_large_tx(size_t nInputs)
 {
     // Create priv/pub key
@@ -464,3 +481,92 @@ double benchmark_listunspent()
     auto unspent = listunspent(params, false);
     return timer_stop(tv_start);
 }
+
+extern UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails);
+extern void blockToJSONStream(CJSONWriter& w, const CBlock& block, const CBlockIndex* blockindex, bool txDetails);
+
+// Renders a real block from the active chain with full transaction details,
+// either through the UniValue tree or the streaming writer.
+double benchmark_blocktojson(int nHeight, bool fStreaming)
+{
+    CBlockIndex* pindex = chainActive[nHeight];
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, 1))
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+
+    struct timeval tv_start;
+    timer_start(tv_start);
+    if (fStreaming) {
+        CJSONWriter w;
+        blockToJSONStream(w, block, pindex, true);
+    } else {
+        std::string strJSON = blockToJSON(block, pindex, true).write();
+    }
+    return timer_stop(tv_start);
+}
+
+double benchmark_sha256(size_t nBytes)
+{
+    std::vector<unsigned char> data(nBytes, 0x5a);
+    unsigned char hash[CSHA256::OUTPUT_SIZE];
+
+    struct timeval tv_start;
+    timer_start(tv_start);
+    CSHA256().Write(data.data(), data.size()).Finalize(hash);
+    return timer_stop(tv_start);
+}
+
+double benchmark_merkleroot(size_t nTxs)
+{
+    CBlock block;
+    for (size_t i = 0; i < nTxs; i++) {
+        CMutableTransaction mtx;
+        mtx.vin.resize(1);
+        mtx.vout.resize(1);
+        mtx.nLockTime = i;
+        block.vtx.push_back(CTransaction(mtx));
+    }
+
+    // Transaction hashes are computed when the transactions are built, so
+    // only the tree itself is timed
+    struct timeval tv_start;
+    timer_start(tv_start);
+    block.BuildMerkleTree();
+    return timer_stop(tv_start);
+}
+
+double benchmark_deserializeblock(size_t nTxs)
+{
+    // Pay-to-pubkey-hash spends, the common case: a 107 byte scriptSig per
+    // input and a 25 byte scriptPubKey per output
+    CBlock block;
+    for (size_t i = 0; i < nTxs; i++) {
+        CMutableTransaction mtx;
+        mtx.vin.resize(2);
+        for (CTxIn& txin : mtx.vin) {
+            txin.prevout = COutPoint(GetRandHash(), i);
+            txin.scriptSig = CScript() << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+        }
+        mtx.vout.resize(2);
+        for (CTxOut& txout : mtx.vout) {
+            txout.nValue = i;
+            txout.scriptPubKey = GetScriptForDestination(CKeyID(uint160(std::vector<unsigned char>(20, i & 0xff))));
+        }
+        block.vtx.push_back(CTransaction(mtx));
+    }
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << block;
+
+    struct timeval tv_start;
+    timer_start(tv_start);
+    CBlock result;
+    ss >> result;
+    double duration = timer_stop(tv_start);
+
+    size_t nUsage = 0;
+    for (const CTransaction& tx : result.vtx) {
+        nUsage += RecursiveDynamicUsage(tx);
+    }
+    LogPrint("bench", "deserializeblock: %u transactions, %u bytes of heap for their inputs and outputs\n", nTxs, nUsage);
+    return duration;
+}
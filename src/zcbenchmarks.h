@@ -12,6 +12,7 @@ extern double benchmark_solve_equihash();
 extern std::vector<double> benchmark_solve_equihash_threaded(int nThreads);
 extern double benchmark_verify_joinsplit(const JSDescription &joinsplit);
 extern double benchmark_verify_equihash();
+extern double benchmark_verify_equihash_batch(size_t nHeaders, int nThreads);
 extern double benchmark_large_tx(size_t nInputs);
 extern double benchmark_try_decrypt_notes(size_t nAddrs);
 extern double benchmark_increment_note_witnesses(size_t nTxs);
@@ -19,5 +20,9 @@ extern double benchmark_connectblock_slow();
 extern double benchmark_sendtoaddress(CAmount amount);
 extern double benchmark_loadwallet();
 extern double benchmark_listunspent();
+extern double benchmark_blocktojson(int nHeight, bool fStreaming);
+extern double benchmark_sha256(size_t nBytes);
+extern double benchmark_merkleroot(size_t nTxs);
+extern double benchmark_deserializeblock(size_t nTxs);
 
 #endif
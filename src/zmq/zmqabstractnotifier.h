@@ -6,6 +6,7 @@
 #define BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 
 #include "zmqconfig.h"
+#include "validationinterface.h"
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
@@ -32,7 +33,7 @@ public:
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
 
-    virtual bool NotifyBlock(const CBlockIndex *pindex);
+    virtual bool NotifyBlock(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock);
     virtual bool NotifyTransaction(const CTransaction &transaction);
 
 protected:
@@ -53,6 +53,12 @@ static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
     return 0;
 }
 
+// Called by zmq once it is done with a zero-copy message, dropping its reference to the buffer
+static void zmq_release_block(void * /*data*/, void *hint)
+{
+    delete static_cast<CSerializedBlockRef*>(hint);
+}
+
 bool CZMQAbstractPublishNotifier::Initialize(void *pcontext)
 {
     assert(!psocket);
@@ -139,7 +145,53 @@ bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const void* d
     return true;
 }
 
-bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const CSerializedBlockRef &data)
+{
+    assert(psocket);
+
+    int rc = zmq_send(psocket, command, strlen(command), ZMQ_SNDMORE);
+    if (rc == -1)
+    {
+        zmqError("Unable to send ZMQ msg");
+        return false;
+    }
+
+    // the message holds its own reference to the buffer until zmq has sent it
+    CSerializedBlockRef *pref = new CSerializedBlockRef(data);
+    zmq_msg_t msg;
+    rc = zmq_msg_init_data(&msg, (void*)&(*data->begin()), data->size(), zmq_release_block, pref);
+    if (rc != 0)
+    {
+        zmqError("Unable to initialize ZMQ msg");
+        delete pref;
+        return false;
+    }
+
+    rc = zmq_msg_send(&msg, psocket, ZMQ_SNDMORE);
+    if (rc == -1)
+    {
+        zmqError("Unable to send ZMQ msg");
+        zmq_msg_close(&msg);
+        return false;
+    }
+    zmq_msg_close(&msg);
+
+    unsigned char msgseq[sizeof(uint32_t)];
+    WriteLE32(&msgseq[0], nSequence);
+    rc = zmq_send(psocket, msgseq, sizeof(uint32_t), 0);
+    if (rc == -1)
+    {
+        zmqError("Unable to send ZMQ msg");
+        return false;
+    }
+
+    /* increment memory only sequence number after sending */
+    nSequence++;
+
+    return true;
+}
+
+bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint("zmq", "zmq: Publish hashblock %s\n", hash.GetHex());
@@ -159,11 +211,16 @@ bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &t
     return SendMessage(MSG_HASHTX, data, 32);
 }
 
-bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock)
 {
     LogPrint("zmq", "zmq: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
 
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    if (rawBlock) {
+        return SendMessage(MSG_RAWBLOCK, rawBlock);
+    }
+
+    // Only when the tip has moved on since, read it back
+    std::shared_ptr<CPlainDataStream> ss = std::make_shared<CPlainDataStream>(SER_NETWORK, PROTOCOL_VERSION);
     {
         LOCK(cs_main);
         CBlock block;
@@ -173,10 +230,10 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
             return false;
         }
 
-        ss << block;
+        *ss << block;
     }
 
-    return SendMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWBLOCK, ss);
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
@@ -23,6 +23,8 @@ public:
           * message sequence number
     */
     bool SendMessage(const char *command, const void* data, size_t size);
+    /* same, handing the serialized block to zmq without copying it */
+    bool SendMessage(const char *command, const CSerializedBlockRef &data);
 
     bool Initialize(void *pcontext);
     void Shutdown();
@@ -31,7 +33,7 @@ public:
 class CZMQPublishHashBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex);
+    bool NotifyBlock(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock);
 };
 
 class CZMQPublishHashTransactionNotifier : public CZMQAbstractPublishNotifier
@@ -43,7 +45,7 @@ public:
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex);
+    bool NotifyBlock(const CBlockIndex *pindex, const CSerializedBlockRef &rawBlock);
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier